@@ -0,0 +1,166 @@
+// **************************************************************************
+//
+/// @file: IcbArena.h
+/// A class for arenas (bump allocators)
+//
+// Intrasoft Code Base - Package Datatypes
+//
+//
+// **************************************************************************
+
+#ifdef _DEBUG
+#	undef THIS_FILE
+#	define THIS_FILE __FILE__
+#	define new DEBUG_NEW
+#endif
+
+// **************************************************************************
+// *** CIcbArena ************************************************************
+// **************************************************************************
+
+/// This class provides an arena for objects which are all released at once.
+///
+/// Allocations are taken from the current block by incrementing a pointer.
+/// If the block is exhausted, a new block of at least twice its size is 
+/// allocated. Reset() releases all objects in running time O(1): the last
+/// (and largest) block is kept for reuse, the older blocks are freed. Thus,
+/// an arena that is reset after each task stops allocating from the heap
+/// as soon as its block is big enough for one task.
+/// The memory overhead is 16 bytes per arena and 8 bytes per block.
+///
+/// Destructors are never called. Therefore, this class is suitable for 
+/// simple types such as numbers, plain strings or structures of them, but 
+/// not for smart pointers or MFC-like strings.
+
+class CIcbArena
+{
+	// *** Inner Classes ****************************************************
+private:
+	/// Header of each block, followed by the memory of the block.
+	struct SBlock
+	{
+		SBlock*	m_pPrev; ///< Pointer to the previous (smaller) block, or NULL.
+		int		m_nSize; ///< The number of bytes following the header.
+	};
+
+	enum { ALIGN = 8 }; ///< The alignment of all allocations (for double and __int64).
+
+	// *** Attributes *******************************************************
+private:
+	SBlock*	m_pBlock; ///< The current block, or NULL if nothing was allocated yet.
+	char*	m_pNext;  ///< The next free byte of the current block.
+	char*	m_pEnd;   ///< The end of the current block.
+	int		m_nFirst; ///< The size of the first block.
+
+	// *** Methods **********************************************************
+private:
+	/// Allocates a new block that is big enough for nBytes and makes it the current block.
+	/// @param nBytes the number of bytes to be allocated from the new block.
+	/// @return pointer to the allocated bytes.
+	void* DoAllocBlock(int nBytes)
+	{
+		int nSize = m_pBlock ? 2 * m_pBlock->m_nSize : m_nFirst;
+		while(nSize < nBytes) nSize <<= 1;
+		SBlock* pBlock = (SBlock*) new char[sizeof(SBlock) + ALIGN + nSize];
+		pBlock->m_pPrev = m_pBlock;
+		pBlock->m_nSize = nSize;
+		m_pBlock = pBlock;
+		m_pNext  = DoAlign((char*) (pBlock + 1)) + nBytes;
+		m_pEnd   = (char*) (pBlock + 1) + ALIGN + nSize;
+		return m_pNext - nBytes;
+	}
+
+	/// Rounds a pointer up to the next multiple of ALIGN.
+	static char* DoAlign(char* p)
+	{
+		return (char*) (((INT_PTR) p + (ALIGN-1)) & ~((INT_PTR) (ALIGN-1)));
+	}
+
+	/// Frees a list of blocks.
+	/// @param pBlock the last block of the list, may be NULL.
+	static void DoFree(SBlock* pBlock)
+	{
+		while(pBlock) {
+			SBlock* pPrev = pBlock->m_pPrev;
+			delete[] (char*) pBlock;
+			pBlock = pPrev;
+		}
+	}
+
+	/// Not copyable, the objects in an arena are referenced by pointers.
+	CIcbArena(const CIcbArena&);
+	CIcbArena& operator = (const CIcbArena&);
+
+public:
+	/// Constructs an empty arena. No memory is allocated before the first allocation.
+	/// @param nFirst the size of the first block in bytes.
+	CIcbArena(int nFirst = 4096) : m_pBlock(NULL), m_pNext(NULL), m_pEnd(NULL), m_nFirst(nFirst > 0 ? nFirst : 4096) { }
+
+	/// Destructs the arena and frees all blocks (without calling any destructors).
+	~CIcbArena()
+	{
+		DoFree(m_pBlock);
+	}
+
+	/// Allocates memory, aligned to 8 bytes.
+	/// @param nBytes the number of bytes to allocate.
+	/// @return pointer to the uninitialized memory, valid until Reset() is called.
+	inline void* Alloc(int nBytes)
+	{
+		char* p = DoAlign(m_pNext);
+		if(p == NULL || nBytes > m_pEnd - p) {
+			return DoAllocBlock(nBytes);
+		}
+		m_pNext = p + nBytes;
+		return p;
+	}
+
+	/// Allocates an array of nNum default constructed objects of type T.
+	/// The destructors of the objects are never called.
+	/// @param nNum the number of objects.
+	/// @return pointer to the first object, valid until Reset() is called.
+	template <class T> inline T* AllocArray(int nNum)
+	{
+		T* pBuf = (T*) Alloc(nNum * sizeof(T));
+		IcbConstruct(pBuf, nNum);
+		return pBuf;
+	}
+
+	/// Allocates a copy of a string, terminated by a 0.
+	/// @param pText the characters to copy (need not be terminated).
+	/// @param nLength the number of characters to copy.
+	/// @return pointer to the copy, valid until Reset() is called.
+	template <class T> inline T* AllocString(const T* pText, int nLength)
+	{
+		T* pBuf = (T*) Alloc((nLength + 1) * sizeof(T));
+		memcpy(pBuf, pText, nLength * sizeof(T));
+		pBuf[nLength] = 0;
+		return pBuf;
+	}
+
+	/// Releases all objects allocated so far. The largest block is kept.
+	void Reset()
+	{
+		if(m_pBlock) {
+			DoFree(m_pBlock->m_pPrev);
+			m_pBlock->m_pPrev = NULL;
+			m_pNext = (char*) (m_pBlock + 1);
+		}
+	}
+
+	/// Returns the number of bytes reserved from the heap, i.e. the size of all blocks.
+	int GetCapacity() const
+	{
+		int nCapacity = 0;
+		for(SBlock* pBlock = m_pBlock; pBlock; pBlock = pBlock->m_pPrev) {
+			nCapacity += pBlock->m_nSize;
+		}
+		return nCapacity;
+	}
+};
+
+// **************************************************************************
+
+#ifdef _DEBUG
+#   undef new
+#endif
@@ -0,0 +1,660 @@
+// **************************************************************************
+//
+/// @file: IcbFlatHashtable.h
+/// A template class for hash tables (maps) with open addressing
+//
+// Intrasoft Code Base - Package Datatypes
+//
+//
+// **************************************************************************
+
+#if !defined(ICB_MFC_60) && !defined(ICB_WINCE)
+#	define ICB_FLATHASHTABLE_SSE2
+#	include <emmintrin.h>
+#endif
+
+#ifdef _DEBUG
+#	undef THIS_FILE
+#	define THIS_FILE __FILE__
+#	define new DEBUG_NEW
+#endif
+
+// **************************************************************************
+// *** TIcbFlatHashtable ****************************************************
+// **************************************************************************
+
+/// This template class provides a hash table of types KEY and VAL with the
+/// interface of TIcbHashtable.
+///
+/// Unlike TIcbHashtable, which allocates a node per element and chains the
+/// nodes of a bucket, the elements are stored inline in one array of slots
+/// (open addressing). A second array holds a control byte per slot: empty,
+/// deleted or the upper 7 bits of the hash value of the element. A lookup
+/// compares the control bytes of a group of 16 slots at once (with SSE2 if
+/// available) and only compares the keys of the slots whose 7 bits match,
+/// so it usually touches one cache line of control bytes and one of slots.
+/// The groups are probed quadratically until a group with an empty slot.
+///
+/// Insert, lookup and delete operations can be done in running time O(1).
+/// The memory overhead is 20 bytes per hash table (28 on 64-bit platforms,
+/// padded to 32) and 1 byte per slot. The number of slots is a power of 2
+/// (at least 16) with a fill factor of at most 7/8 including deleted slots.
+///
+/// Constructors, destructors and assignment operators for keys and values are
+/// properly called. When the table grows, the elements are moved with
+/// IcbRelocate, like the elements of TIcbArray. Thus, pointers to values are
+/// only valid until the next insertion or removal. The template function
+/// IcbCompare is used to compare keys and IcbHashCode to compute hash keys.
+
+template <class KEY, class VAL> class TIcbFlatHashtable
+{
+	// *** Inner Classes ****************************************************
+private:
+	/// Structure for each slot of the hash table.
+	/// The members are constructed and destructed by IcbConstruct / IcbDestruct,
+	/// as the slots are allocated uninitialized.
+	struct SSlot
+	{
+		KEY		m_oKey;	 ///< The key of the element.
+		VAL		m_oVal;  ///< The value of the element.
+	};
+
+	enum
+	{
+		GROUP   = 16,	///< The number of slots whose control bytes are compared at once.
+		EMPTY   = 0x80,	///< The control byte of an empty slot.
+		DELETED = 0xFE	///< The control byte of a removed element; full slots have 0x00..0x7F.
+	};
+
+	// *** Attributes *******************************************************
+private:
+	SSlot*	m_pSlots;	 ///< Points to an array with m_nCapacity slots followed by their control bytes, or NULL if m_nCapacity is zero.
+	BYTE*	m_pCtrl;	 ///< Points to the control bytes behind the slots.
+	int		m_nCapacity; ///< The number of slots, zero or a power of 2 >= GROUP.
+	int		m_nSize;	 ///< The number of elements present in the hash table.
+	int		m_nDeleted;	 ///< The number of slots marked as DELETED.
+
+	// *** Methods **********************************************************
+private:
+	/// Calculates the number of slots with a fill factor of at most 7/8 for a specified number of elements
+	/// @param nSize number of elements
+	/// @return the number of slots to use
+	static int DoComputeCapacity(int nSize)
+	{
+		if(nSize == 0) {
+			return 0;
+		} else {
+			int nCapacity = GROUP;
+			while(nCapacity - nCapacity / 8 < nSize) nCapacity <<= 1;
+			return nCapacity;
+		}
+	}
+
+	/// Computes the hash value of a key. IcbHashCode of integers is the identity
+	/// and pointers are aligned, so the hash code is passed through the finalizer
+	/// of MurmurHash3, after which every bit depends on every bit of the hash code.
+	static inline unsigned DoHash(const KEY& oKey)
+	{
+		unsigned nHash = IcbHashCode(oKey);
+		nHash ^= nHash >> 16;
+		nHash *= 0x85EBCA6Bu;
+		nHash ^= nHash >> 13;
+		nHash *= 0xC2B2AE35u;
+		nHash ^= nHash >> 16;
+		return nHash;
+	}
+
+	/// Returns the first group to probe for a hash value (from its lower bits).
+	inline int DoGetGroup(unsigned nHash) const
+	{
+		return (int) (nHash & (unsigned) (m_nCapacity / GROUP - 1));
+	}
+
+	/// Returns the control byte of a hash value (its upper 7 bits, which are
+	/// independent of the group as long as there are fewer than 2^25 groups).
+	static inline BYTE DoGetCtrl(unsigned nHash)
+	{
+		return (BYTE) (nHash >> 25);
+	}
+
+	/// Returns the index of the lowest bit set.
+	/// @param nMask a mask with at least one bit set.
+	static inline int DoLowestBit(unsigned nMask)
+	{
+		static const int s_anDeBruijn[32] = {
+			0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+			31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+		};
+		return s_anDeBruijn[((nMask & (0u - nMask)) * 0x077CB531u) >> 27];
+	}
+
+#ifdef ICB_FLATHASHTABLE_SSE2
+	/// Returns a mask of the slots of a group with the given control byte.
+	static inline unsigned DoMatch(const BYTE* pCtrl, BYTE nCtrl)
+	{
+		__m128i oCtrl = _mm_loadu_si128((const __m128i*) pCtrl);
+		return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(oCtrl, _mm_set1_epi8((char) nCtrl)));
+	}
+
+	/// Returns a mask of the slots of a group that are EMPTY or DELETED.
+	static inline unsigned DoMatchFree(const BYTE* pCtrl)
+	{
+		return (unsigned) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) pCtrl));
+	}
+#else
+	/// Returns a mask of the slots of a group with the given control byte.
+	static inline unsigned DoMatch(const BYTE* pCtrl, BYTE nCtrl)
+	{
+		unsigned nMask = 0;
+		for(int i=0; i<GROUP; i++) {
+			if(pCtrl[i] == nCtrl) nMask |= 1u << i;
+		}
+		return nMask;
+	}
+
+	/// Returns a mask of the slots of a group that are EMPTY or DELETED.
+	static inline unsigned DoMatchFree(const BYTE* pCtrl)
+	{
+		unsigned nMask = 0;
+		for(int i=0; i<GROUP; i++) {
+			if(pCtrl[i] & 0x80) nMask |= 1u << i;
+		}
+		return nMask;
+	}
+#endif
+
+	/// Allocates the slots and control bytes for nCapacity slots, all EMPTY.
+	void DoAlloc(int nCapacity)
+	{
+		m_nCapacity = nCapacity;
+		if(nCapacity) {
+			m_pSlots = (SSlot*) new char[nCapacity * (sizeof(SSlot) + 1)];
+			m_pCtrl  = (BYTE*) (m_pSlots + nCapacity);
+			memset(m_pCtrl, EMPTY, nCapacity);
+		} else {
+			m_pSlots = NULL;
+			m_pCtrl  = NULL;
+		}
+	}
+
+	/// Constructs the element of a slot claimed by DoInsert.
+	/// @param nIdx the index of the slot.
+	/// @param oKey the key of the element.
+	/// @param pVal the value of the element, or NULL for a default constructed value.
+	void DoConstruct(int nIdx, const KEY& oKey, const VAL* pVal)
+	{
+		IcbConstructCopy(&m_pSlots[nIdx].m_oKey, 1, &oKey);
+		if(pVal) {
+			IcbConstructCopy(&m_pSlots[nIdx].m_oVal, 1, pVal);
+		} else {
+			IcbConstruct(&m_pSlots[nIdx].m_oVal, 1);
+		}
+	}
+
+	/// Returns the first EMPTY or DELETED slot on the probe sequence of a hash value.
+	/// @param nHash the hash value computed by DoHash.
+	/// @return the index of the slot.
+	int DoFindFree(unsigned nHash) const
+	{
+		int nMask = m_nCapacity / GROUP - 1;
+		int nGroup = DoGetGroup(nHash);
+		for(int nStep=1; ; nStep++) {
+			unsigned nFree = DoMatchFree(m_pCtrl + nGroup * GROUP);
+			if(nFree) {
+				return nGroup * GROUP + DoLowestBit(nFree);
+			}
+			nGroup = (nGroup + nStep) & nMask;
+		}
+	}
+
+	/// Sets the number of slots and moves all elements to their new slots.
+	/// Deleted slots are dropped.
+	/// @param nCapacity the new number of slots, zero or a power of 2 >= GROUP.
+	void DoRehash(int nCapacity)
+	{
+		SSlot* pSlots       = m_pSlots;
+		BYTE*  pCtrl        = m_pCtrl;
+		int    nCapacityOld = m_nCapacity;
+
+		DoAlloc(nCapacity);
+		m_nDeleted = 0;
+
+		// move elements from pSlots to m_pSlots
+		for(int i=0; i<nCapacityOld; i++) {
+			if((pCtrl[i] & 0x80) == 0) {
+				unsigned nHash = DoHash(pSlots[i].m_oKey);
+				int nIdx = DoFindFree(nHash);
+				m_pCtrl[nIdx] = DoGetCtrl(nHash);
+				IcbRelocate(&m_pSlots[nIdx], &pSlots[i], 1);
+			}
+		}
+
+		delete[] (char*) pSlots;
+	}
+
+	/// Method to make this hash table a clone of a provided hash table.
+	/// The elements keep their slots, so no hash values are computed.
+	/// @param oCopy the hash table that needs to be cloned
+	void DoClone(const TIcbFlatHashtable& oCopy)
+	{
+		DoAlloc(oCopy.m_nCapacity);
+		m_nSize    = oCopy.m_nSize;
+		m_nDeleted = oCopy.m_nDeleted;
+
+		for(int i=0; i<m_nCapacity; i++) {
+			m_pCtrl[i] = oCopy.m_pCtrl[i];
+			if((m_pCtrl[i] & 0x80) == 0) {
+				DoConstruct(i, oCopy.m_pSlots[i].m_oKey, &oCopy.m_pSlots[i].m_oVal);
+			}
+		}
+	}
+
+	/// Find the slot for a given key
+	/// @param oKey the key that needs to be found
+	/// @param nHash the hash value of the key computed by DoHash.
+	/// @return the index of the slot with the given key, or -1 if the hash table is empty or the key is not found
+	int DoFind(const KEY& oKey, unsigned nHash) const
+	{
+		if(m_nSize == 0) {
+			return -1;
+		}
+
+		int  nMask  = m_nCapacity / GROUP - 1;
+		int  nGroup = DoGetGroup(nHash);
+		BYTE nCtrl  = DoGetCtrl(nHash);
+		for(int nStep=1; ; nStep++) {
+			const BYTE* pCtrl = m_pCtrl + nGroup * GROUP;
+			for(unsigned nMatch = DoMatch(pCtrl, nCtrl); nMatch; nMatch &= nMatch - 1) {
+				int nIdx = nGroup * GROUP + DoLowestBit(nMatch);
+				if(IcbCompare(oKey, m_pSlots[nIdx].m_oKey) == 0) {
+					return nIdx;
+				}
+			}
+			if(DoMatch(pCtrl, EMPTY)) {
+				return -1;
+			}
+			nGroup = (nGroup + nStep) & nMask;
+		}
+	}
+
+	/// Find the slot for a given key
+	/// @param oKey the key that needs to be found
+	/// @return pointer to the slot with the given key, may be NULL if hash table is empty or the key is not found
+	SSlot* DoFind(const KEY& oKey) const
+	{
+		int nIdx = DoFind(oKey, DoHash(oKey));
+		return nIdx >= 0 ? &m_pSlots[nIdx] : NULL;
+	}
+
+	/// Claims a slot for a new element with the given key. Grows the hash table if necessary.
+	/// @param nHash the hash value of the key computed by DoHash.
+	/// @return the index of the slot, which must be constructed by the caller.
+	int DoInsert(unsigned nHash)
+	{
+		if(m_nSize + m_nDeleted >= m_nCapacity - m_nCapacity / 8) { // rehash if fill factor would be larger than 7/8
+			DoRehash(DoComputeCapacity(m_nSize + 1));
+		}
+
+		int nIdx = DoFindFree(nHash);
+		if(m_pCtrl[nIdx] == DELETED) {
+			m_nDeleted--;
+		}
+		m_pCtrl[nIdx] = DoGetCtrl(nHash);
+		m_nSize++;
+		return nIdx;
+	}
+
+	/// Iterates over all elements and provides pointers to keys and / or values as desired.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param pKey receives the pointer to the key of each element. May be NULL when calling this method.
+	/// @param pVal receives the pointer to the value of each element. May be NULL when calling this method.
+	/// @param ppVal receives the pointer to the value of each element. May be NULL when calling this method.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool DoEnum(const void*& pPos, KEY* pKey, VAL* pVal, VAL** ppVal) const
+	{
+		int nIdxStart = pPos ? (int) ((const SSlot*) pPos - m_pSlots) + 1 : 0;
+		for(int nIdx=nIdxStart; nIdx<m_nCapacity; nIdx++) {
+			if((m_pCtrl[nIdx] & 0x80) == 0) {
+				SSlot* pSlot = &m_pSlots[nIdx];
+				if(pKey) *pKey   = pSlot->m_oKey;
+				if(pVal) *pVal   = pSlot->m_oVal;
+				if(ppVal) *ppVal = &pSlot->m_oVal;
+				pPos = pSlot;
+				return true;
+			}
+		}
+		pPos = NULL;
+		return false;
+	}
+
+	/// Iterates over all elements and provides the keys and / or values as desired.
+	/// @param paoKeys receives a pointer to an array of the keys of all elements.
+	/// @param paoVals receives a pointer to an array of the values of all elements.
+	/// @param papVals receives a pointer to an array of pointers to the values of all elements.
+	void DoGetEntries(TIcbArray<KEY>* paoKeys, TIcbArray<VAL>* paoVals, TIcbArray<const VAL*>* papVals) const
+	{
+		if(paoKeys) paoKeys->RemoveAll();
+		if(paoVals) paoVals->RemoveAll();
+		if(papVals) papVals->RemoveAll();
+		for(int i=0; i<m_nCapacity; i++) {
+			if((m_pCtrl[i] & 0x80) == 0) {
+				const SSlot* pSlot = &m_pSlots[i];
+				if(paoKeys) paoKeys->Add(pSlot->m_oKey);
+				if(paoVals) paoVals->Add(pSlot->m_oVal);
+				if(papVals) papVals->Add(&pSlot->m_oVal);
+			}
+		}
+	}
+
+public:
+	/// Constructs an empty hash table without slots.
+	TIcbFlatHashtable()
+	{
+		DoAlloc(0);
+		m_nSize    = 0;
+		m_nDeleted = 0;
+	}
+
+	/// Constructs a new hash table by copying slots and elements from the given hash table.
+	/// @param oCopy the hash table to be copied.
+	TIcbFlatHashtable(const TIcbFlatHashtable& oCopy)
+	{
+		DoClone(oCopy);
+	}
+
+	/// Destructs the instance.
+	~TIcbFlatHashtable()
+	{
+		RemoveAll();
+	}
+
+	/// Assignment operator: Sets slots and elements of this hash table.
+	/// @param  oCopy the hash table to be assinged.
+	/// @return a reference to the hash table itself.
+	TIcbFlatHashtable& operator = (const TIcbFlatHashtable& oCopy)
+	{
+		if(this != &oCopy) {
+			RemoveAll();
+			DoClone(oCopy);
+		}
+		return *this;
+	}
+
+	/// Sets the number of slots such that nRange elements fit without growing, and re-hashes all elements.
+	/// @param nRange the number of elements to make room for, must be >= 0.
+	///               Fewer slots than needed for the present elements are never set.
+	void SetRange(int nRange)
+	{
+		ASSERT(nRange >= 0);
+
+		int nCapacity = DoComputeCapacity(IcbMax(nRange, m_nSize));
+		if(nCapacity != m_nCapacity) {
+			DoRehash(nCapacity);
+		}
+	}
+
+	/// Returns whether the hash table is empty.
+	/// @return true if the hash table contains no elements,
+	///         false if the hash table contains one or more elements.
+	bool IsEmpty() const { return m_nSize == 0; }
+
+	/// Returns the number of elements in the hash table.
+	/// @return the number of elements in the hash table.
+	int GetSize() const { return m_nSize; }
+
+	/// Checks, wether an element with the given key is contained in the hash table.
+	/// @param oKey the key of the element.
+	/// @return     true if there exists an element with the given key, false otherwise.
+	bool Contains(const KEY& oKey) const
+	{
+		return DoFind(oKey) != NULL;
+	}
+
+	/// Returns the value of the element with the given key, if existing.
+	/// @param oKey the key of the element.
+	/// @param oVal receives the value of the element, if existing.
+	/// @return     true if an element with the given key was found and oVal was assigned,
+	///             false if no element was found and oVal was not assigned.
+	bool Get(const KEY& oKey, VAL& oVal) const
+	{
+		const SSlot* pSlot = DoFind(oKey);
+		if(pSlot) {
+			oVal = pSlot->m_oVal;
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	/// Returns a const pointer to the value of the element with the given key.
+	/// @param oKey the key of the element.
+	/// @return a const pointer to the value of the element with the given key,
+	///         or NULL if no element was found.
+	const VAL* GetRef(const KEY& oKey) const
+	{
+		const SSlot* pSlot = DoFind(oKey);
+		if(pSlot) {
+			return &pSlot->m_oVal;
+		} else {
+			return NULL;
+		}
+	}
+
+	/// Returns a non-const pointer to the value of the element with the given key.
+	/// @param oKey the key of the element.
+	/// @return a non-const pointer to the value of the element with the given key,
+	///         or NULL if no element was found.
+	VAL* GetRef(const KEY& oKey)
+	{
+		SSlot* pSlot = DoFind(oKey);
+		if(pSlot) {
+			return &pSlot->m_oVal;
+		} else {
+			return NULL;
+		}
+	}
+
+	/// Inserts a new key/value pair or replaces the value of the element with the given key.
+	/// @param oKey the key of the element to be inserted or updated.
+	/// @param oVal the value of the element to be inserted or updated.
+	void Put(const KEY& oKey, const VAL& oVal)
+	{
+		unsigned nHash = DoHash(oKey);
+		int nIdx = DoFind(oKey, nHash);
+		if(nIdx < 0) {
+			// insert
+			nIdx = DoInsert(nHash);
+			DoConstruct(nIdx, oKey, &oVal);
+		} else {
+			// replace
+			m_pSlots[nIdx].m_oVal = oVal;
+		}
+	}
+
+	/// Returns a reference to the value of the existing or newly created element with the given key.
+	/// If no element with the given key exists, a new element with an empty value is inserted.
+	/// @param oKey the key of the element to be found or inserted.
+	VAL& GetOrPut(const KEY& oKey)
+	{
+		unsigned nHash = DoHash(oKey);
+		int nIdx = DoFind(oKey, nHash);
+		if(nIdx < 0) {
+			// insert
+			nIdx = DoInsert(nHash);
+			DoConstruct(nIdx, oKey, NULL);
+		}
+		return m_pSlots[nIdx].m_oVal;
+	}
+
+	/// Returns a reference to the value of the existing or newly created element with the given key.
+	/// If no element with the given key exists, a new element with the given value is inserted.
+	/// @param oKey     the key of the element to be found or inserted.
+	/// @param oValDflt the value to be assigned when a new element is inserted.
+	VAL& GetOrPut(const KEY& oKey, const VAL& oValDflt)
+	{
+		unsigned nHash = DoHash(oKey);
+		int nIdx = DoFind(oKey, nHash);
+		if(nIdx < 0) {
+			// insert
+			nIdx = DoInsert(nHash);
+			DoConstruct(nIdx, oKey, &oValDflt);
+		}
+		return m_pSlots[nIdx].m_oVal;
+	}
+
+	/// Removes the element with the given key, if existing.
+	/// @param oKey the key of the element to be removed.
+	void Remove(const KEY& oKey)
+	{
+		int nIdx = DoFind(oKey, DoHash(oKey));
+		if(nIdx < 0) {
+			return;
+		}
+
+		// remove: a lookup stops at a group with an EMPTY slot, so the slot may only
+		// become EMPTY if its group already has one, otherwise it is marked DELETED
+		IcbDestruct(&m_pSlots[nIdx], 1);
+		if(DoMatch(m_pCtrl + (nIdx & ~(GROUP-1)), EMPTY)) {
+			m_pCtrl[nIdx] = EMPTY;
+		} else {
+			m_pCtrl[nIdx] = DELETED;
+			m_nDeleted++;
+		}
+		m_nSize--;
+
+		if(8 * m_nSize <= m_nCapacity && m_nCapacity > GROUP) { // rehash if fill factor smaller than 1/8
+			SetRange(m_nSize);
+		}
+	}
+
+	/// Removes all elements and frees the slots.
+	void RemoveAll()
+	{
+		for(int i=0; i<m_nCapacity; i++) {
+			if((m_pCtrl[i] & 0x80) == 0) {
+				IcbDestruct(&m_pSlots[i], 1);
+			}
+		}
+		delete[] (char*) m_pSlots;
+		DoAlloc(0);
+		m_nSize    = 0;
+		m_nDeleted = 0;
+	}
+
+	/// Iterates over the keys of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param oKey receives the key of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumKeys(const void*& pPos, KEY& oKey) const
+	{
+		return DoEnum(pPos, &oKey, NULL, NULL);
+	}
+
+	/// Iterates over the values of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param oVal receives the value of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumVals(const void*& pPos, VAL& oVal) const
+	{
+		return DoEnum(pPos, NULL, &oVal, NULL);
+	}
+
+	/// Iterates over the non-const pointers to the values of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param pVal receives the pointer to the value of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumValRefs(const void*& pPos, VAL*& pVal)
+	{
+		return DoEnum(pPos, NULL, NULL, &pVal);
+	}
+
+	/// Iterates over the const pointers to the values of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param pVal receives the pointer to the value of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumValRefs(const void*& pPos, const VAL*& pVal) const
+	{
+		return DoEnum(pPos, NULL, NULL, (VAL**) &pVal);
+	}
+
+	/// Iterates over the keys and values of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param oKey receives the key of each element.
+	/// @param oVal receives the value of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumKeyVals(const void*& pPos, KEY& oKey, VAL& oVal) const
+	{
+		return DoEnum(pPos, &oKey, &oVal, NULL);
+	}
+
+	/// Iterates over the keys and non-const pointers to the values of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param oKey receives the key of each element.
+	/// @param pVal receives the pointer to the value of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumKeyValRefs(const void*& pPos, KEY& oKey, VAL*& pVal)
+	{
+		return DoEnum(pPos, &oKey, NULL, &pVal);
+	}
+
+	/// Iterates over the keys and const pointers to the values of all elements.
+	/// @param pPos the iteration handle: initally NULL, the received value must
+	///             be passed to the next iteration as long as the return value is true.
+	/// @param oKey receives the key of each element.
+	/// @param pVal receives the pointer to the value of each element.
+	/// @return     true if an element was found and returned, false if the iteration ends.
+	bool EnumKeyValRefs(const void*& pPos, KEY& oKey, const VAL*& pVal) const
+	{
+		return DoEnum(pPos, &oKey, NULL, (VAL**) &pVal);
+	}
+
+	/// Returns the keys of all elements.
+	/// @param aoKeys receives the keys of all elements.
+	void GetKeys(TIcbArray<KEY>& aoKeys) const
+	{
+		DoGetEntries(&aoKeys, NULL, NULL);
+	}
+
+	/// Returns the values of all elements.
+	/// @param aoVals receives the values of all elements.
+	void GetVals(TIcbArray<VAL>& aoVals) const
+	{
+		DoGetEntries(NULL, &aoVals, NULL);
+	}
+
+	/// Returns const pointers to the values of all elements.
+	/// @param apVals receives the pointers to the values of all elements.
+	void GetValRefs(TIcbArray<const VAL*>& apVals) const
+	{
+		DoGetEntries(NULL, NULL, &apVals);
+	}
+
+	/// Returns the keys and values of all elements.
+	/// @param aoKeys receives the keys of all elements.
+	/// @param aoVals receives the values of all elements.
+	void GetKeyVals(TIcbArray<KEY>& aoKeys, TIcbArray<VAL>& aoVals) const
+	{
+		DoGetEntries(&aoKeys, &aoVals, NULL);
+	}
+
+	/// Returns the keys and const pointers to the values of all elements.
+	/// @param aoKeys receives the keys of all elements.
+	/// @param apVals receives the pointers to the values of all elements.
+	void GetKeyValRefs(TIcbArray<KEY>& aoKeys, TIcbArray<const VAL*>& apVals) const
+	{
+		DoGetEntries(&aoKeys, NULL, &apVals);
+	}
+};
+
+// **************************************************************************
+
+#ifdef _DEBUG
+#   undef new
+#endif
@@ -21,9 +21,15 @@
 /// This template class provides a hash table of types KEY and VAL.
 /// 
 /// Insert, lookup and delete operations can be done in running time O(1).
-/// The memory overhead is 12+(4*range) bytes per hash table and 4 bytes 
+/// The memory overhead is 32+(4*range) bytes per hash table and 4 bytes 
 /// per element.
 ///
+/// By default, each element is allocated from the heap. After SetSlabSize(),
+/// the elements are carved from slabs of the hash table instead, and removed
+/// elements are kept in a free list for the next insertion. The slabs are
+/// released by the destructor only; RemoveAll() keeps the largest one. 
+/// Pointers to values stay valid across rehashing either way.
+///
 /// Constructors, destructors and assignment operators for keys and values are 
 /// properly called. The template function IcbCompare is used to compare keys
 /// and IcbHashCode to compute hash keys. Therefore, this class is suitable 
@@ -52,11 +58,25 @@ private:
 		SNode(SNode* pNext, const KEY& oKey, const VAL& oVal) :  m_pNext(pNext), m_oKey(oKey), m_oVal(oVal) { }
 	};
 
+	/// Header of each slab, followed by its nodes.
+	struct SSlab
+	{
+		SSlab*	m_pPrev;  ///< Pointer to the previous (smaller) slab, or NULL.
+		int		m_nNodes; ///< The number of nodes following the header.
+	};
+
+	enum { HEADER = (sizeof(SSlab) + sizeof(SNode) - 1) / sizeof(SNode) }; ///< The number of nodes taken by the header of a slab.
+
 	// *** Attributes *******************************************************
 private:
 	SNode**	m_pData;  ///< Points to an array with m_nRange pointers to elements, or NULL if m_nRange is zero. 
 	int		m_nRange; ///< The range of the hash table. 
 	int		m_nSize;  ///< The number of elements present in the hash table.
+	SSlab*	m_pSlab;  ///< The current (largest) slab, or NULL.
+	SNode*	m_pNext;  ///< The next unused node of the current slab.
+	SNode*	m_pEnd;   ///< The end of the current slab.
+	SNode*	m_pFree;  ///< The free list of removed nodes, linked by m_pNext.
+	int		m_nSlab;  ///< The number of nodes of the first slab, or zero if nodes are allocated from the heap.
 		
 	// *** Methods **********************************************************
 private:
@@ -74,15 +94,93 @@ private:
 		}
 	}
 
+	/// Allocates a new slab and makes it the current slab.
+	/// @param nNodes the number of nodes of the new slab.
+	void DoAllocSlab(int nNodes)
+	{
+		SSlab* pSlab = (SSlab*) new char[(HEADER + nNodes) * sizeof(SNode)];
+		pSlab->m_pPrev  = m_pSlab;
+		pSlab->m_nNodes = nNodes;
+		m_pSlab = pSlab;
+		m_pNext = (SNode*) pSlab + HEADER;
+		m_pEnd  = m_pNext + nNodes;
+	}
+
+	/// Frees the slabs, whose nodes must have been destructed, and clears the free list.
+	/// @param bKeepLast true to keep the current (largest) slab for reuse.
+	void DoFreeSlabs(bool bKeepLast)
+	{
+		SSlab* pSlab = m_pSlab;
+		if(bKeepLast && pSlab) {
+			pSlab = pSlab->m_pPrev;
+			m_pSlab->m_pPrev = NULL;
+			m_pNext = (SNode*) m_pSlab + HEADER;
+		} else {
+			m_pSlab = NULL;
+			m_pNext = NULL;
+			m_pEnd  = NULL;
+		}
+		while(pSlab) {
+			SSlab* pPrev = pSlab->m_pPrev;
+			delete[] (char*) pSlab;
+			pSlab = pPrev;
+		}
+		m_pFree = NULL;
+	}
+
+	/// Creates a new node, from the free list or the current slab if slabs are used.
+	/// @param pNext pointer to the next element with the same hash value.
+	/// @param oKey the key of the new element.
+	/// @param pVal the value of the new element, or NULL for a default constructed value.
+	/// @return pointer to the new node.
+	SNode* DoNewNode(SNode* pNext, const KEY& oKey, const VAL* pVal)
+	{
+		if(m_nSlab == 0) {
+			return pVal ? new SNode(pNext, oKey, *pVal) : new SNode(pNext, oKey);
+		}
+
+		SNode* pNode = m_pFree;
+		if(pNode) {
+			m_pFree = pNode->m_pNext;
+		} else {
+			if(m_pNext == m_pEnd) {
+				DoAllocSlab(m_pSlab ? 2 * m_pSlab->m_nNodes : m_nSlab);
+			}
+			pNode = m_pNext++;
+		}
+		pNode->m_pNext = pNext;
+		IcbConstructCopy(&pNode->m_oKey, 1, &oKey);
+		if(pVal) {
+			IcbConstructCopy(&pNode->m_oVal, 1, pVal);
+		} else {
+			IcbConstruct(&pNode->m_oVal, 1);
+		}
+		return pNode;
+	}
+
+	/// Deletes a node, or destructs it and adds it to the free list if slabs are used.
+	/// @param pNode pointer to the node to be deleted.
+	void DoDeleteNode(SNode* pNode)
+	{
+		if(m_nSlab == 0) {
+			delete pNode;
+		} else {
+			IcbDestruct(&pNode->m_oKey, 1);
+			IcbDestruct(&pNode->m_oVal, 1);
+			pNode->m_pNext = m_pFree;
+			m_pFree = pNode;
+		}
+	}
+
 	/// Does clone a single hash table bucket.
 	/// @param pNode const pointer to the first node of the original bucket
 	/// @return pointer to the first node of the new bucket
-	static SNode* DoClone(const SNode* pNode)
+	SNode* DoClone(const SNode* pNode)
 	{
 		SNode*  pResult = NULL;
 		SNode** ppLink  = &pResult;
 		while(pNode) {
-			SNode* pTmp = new SNode(NULL, pNode->m_oKey, pNode->m_oVal);
+			SNode* pTmp = DoNewNode(NULL, pNode->m_oKey, &pNode->m_oVal);
 			*ppLink = pTmp;
 			pNode   = pNode->m_pNext;
 			ppLink  = &(pTmp->m_pNext);
@@ -91,12 +189,22 @@ private:
 	}
 
 	/// Method to make this hash table a clone of a provided hash table
+	/// If the hash table uses slabs, the elements are copied into one fresh slab.
 	/// @param sCopy the hash table that needs to be cloned
 	void DoClone(const TIcbHashtable& sCopy)
 	{
 		m_pData  = sCopy.m_pData ? new SNode*[sCopy.m_nRange] : NULL;
 		m_nRange = sCopy.m_nRange;
 		m_nSize  = sCopy.m_nSize;
+		m_pSlab  = NULL;
+		m_pNext  = NULL;
+		m_pEnd   = NULL;
+		m_pFree  = NULL;
+		m_nSlab  = sCopy.m_nSlab;
+
+		if(m_nSlab && m_nSize) {
+			DoAllocSlab(IcbMax(m_nSlab, m_nSize));
+		}
 
 		for(int i=0; i<m_nRange; i++) {
 			m_pData[i] = DoClone(sCopy.m_pData[i]);
@@ -196,6 +304,11 @@ public:
 		m_pData  = NULL;
 		m_nRange = 0;
 		m_nSize  = 0;
+		m_pSlab  = NULL;
+		m_pNext  = NULL;
+		m_pEnd   = NULL;
+		m_pFree  = NULL;
+		m_nSlab  = 0;
 	}
 
 	/// Constructs a new hash table by copying range and elements from the given hash table.
@@ -209,6 +322,7 @@ public:
 	~TIcbHashtable()
 	{
 		RemoveAll();
+		DoFreeSlabs(false);
 	}
 
 	/// Assignment operator: Sets range and elements of this hash table.
@@ -217,6 +331,7 @@ public:
 	TIcbHashtable& operator = (const TIcbHashtable& oCopy)
 	{
 		RemoveAll();
+		DoFreeSlabs(false);
 		DoClone(oCopy);
 		return *this;
 	}
@@ -258,6 +373,22 @@ public:
 		m_nRange = nRange;
 	}
 
+	/// Makes the hash table allocate its elements from slabs, or from the heap again.
+	/// The slabs grow exponentially, starting with nNodes elements. Copies of the
+	/// hash table use slabs as well. The hash table must be empty.
+	/// @param nNodes the number of elements of the first slab, or zero to allocate
+	///               each element from the heap (the default).
+	void SetSlabSize(int nNodes)
+	{
+		ASSERT(nNodes >= 0 && m_nSize == 0);
+
+		if(m_nSize > 0) {
+			return; // nodes would be freed by the wrong allocator
+		}
+		DoFreeSlabs(false);
+		m_nSlab = nNodes;
+	}
+
 	/// Returns whether the hash table is empty.
 	/// @return true if the hash table contains no elements,
 	///         false if the hash table contains one or more elements.
@@ -331,7 +462,7 @@ public:
 		SNode** ppNode = DoFindPtr(oKey);
 		if(*ppNode == NULL) {
 			// insert
-			*ppNode = new SNode(*ppNode, oKey, oVal);
+			*ppNode = DoNewNode(*ppNode, oKey, &oVal);
 			m_nSize++;
 		} else {
 			// replace
@@ -356,7 +487,7 @@ public:
 		SNode** ppNode = DoFindPtr(oKey);
 		if(*ppNode == NULL) {
 			// insert
-			*ppNode = new SNode(*ppNode, oKey);
+			*ppNode = DoNewNode(*ppNode, oKey, NULL);
 			m_nSize++;
 		}
 		SNode* pNode = *ppNode;
@@ -382,7 +513,7 @@ public:
 		SNode** ppNode = DoFindPtr(oKey);
 		if(*ppNode == NULL) {
 			// insert
-			*ppNode = new SNode(*ppNode, oKey, oValDflt);
+			*ppNode = DoNewNode(*ppNode, oKey, &oValDflt);
 			m_nSize++;
 		}
 		SNode* pNode = *ppNode;
@@ -408,7 +539,7 @@ public:
 			// remove
 			SNode* pNode = *ppNode;
 			*ppNode = pNode->m_pNext;
-			delete pNode;
+			DoDeleteNode(pNode);
 			m_nSize--;
 		}
 
@@ -419,22 +550,44 @@ public:
 	}
 
 	/// Removes all elements and sets the range to zero.
+	/// If slabs are used, the largest one is kept for new elements.
 	void RemoveAll()
 	{
 		for(int i=0; i<m_nRange; i++) {
 			SNode* pNode = m_pData[i];
 			while(pNode) {
 				SNode* pNext = pNode->m_pNext;
-				delete pNode;
+				DoDeleteNode(pNode);
 				pNode = pNext;
 			}
 		}
+		DoFreeSlabs(true);
 		delete[] m_pData;
 		m_pData  = NULL;
 		m_nRange = 0;
 		m_nSize  = 0;
 	}
 
+	/// Removes all elements, but keeps the range and, if slabs are used, the slabs.
+	/// The nodes of the elements are added to the free list, so that refilling the
+	/// hash table up to its previous size allocates no memory for the nodes.
+	void Reset()
+	{
+		if(m_nSize == 0) {
+			return;
+		}
+		for(int i=0; i<m_nRange; i++) {
+			SNode* pNode = m_pData[i];
+			while(pNode) {
+				SNode* pNext = pNode->m_pNext;
+				DoDeleteNode(pNode);
+				pNode = pNext;
+			}
+			m_pData[i] = NULL;
+		}
+		m_nSize = 0;
+	}
+
 	/// Iterates over the keys of all elements.
 	/// @param pPos the iteration handle: initally NULL, the received value must
 	///             be passed to the next iteration as long as the return value is true.
@@ -542,7 +695,7 @@ public:
 	/// @param apVals receives the pointers to the values of all elements.
 	void GetKeyValRefs(TIcbArray<KEY>& aoKeys, TIcbArray<const VAL*>& apVals) const 
 	{
-		DoGetEntries(&aoKeys, &aoVals, NULL);
+		DoGetEntries(&aoKeys, NULL, &apVals);
 	}
 };
 
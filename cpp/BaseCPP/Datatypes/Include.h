@@ -17,6 +17,8 @@
 // - ICB_DATATYPES_USE_TIMESIMULATOR
 // - ICB_DATATYPES_USE_LIST
 // - ICB_DATATYPES_USE_HASHTABLE
+// - ICB_DATATYPES_USE_FLATHASHTABLE
+// - ICB_DATATYPES_USE_ARENA
 // - ICB_DATATYPES_USE_TREAP 
 // - ICB_DATATYPES_USE_INDEX
 // - ICB_DATATYPES_USE_DUPLEXMAP
@@ -66,6 +68,12 @@
 #ifdef ICB_DATATYPES_USE_HASHTABLE
 #  include "IcbHashtable.h"
 #endif
+#ifdef ICB_DATATYPES_USE_FLATHASHTABLE
+#  include "IcbFlatHashtable.h"
+#endif
+#ifdef ICB_DATATYPES_USE_ARENA
+#  include "IcbArena.h"
+#endif
 #ifdef ICB_DATATYPES_USE_TREAP
 #  include "IcbTreap.h"
 #endif
@@ -16,6 +16,9 @@
 #ifdef ICB_PACKAGE_DATATYPES
 #  include "Datatypes/Include.h"
 #endif
+#ifdef ICB_PACKAGE_PARSER
+#  include "Parser/Include.h"
+#endif
 #ifdef ICB_PACKAGE_IPC
 #  include "IPC/Include.h"
 #endif
@@ -0,0 +1,220 @@
+// **************************************************************************
+//
+/// @file: IcbParserPool.h
+/// A pool of parser instances for concurrent use
+//
+// Intrasoft Code Base - Package Parser
+//
+//
+// **************************************************************************
+
+#ifdef _DEBUG
+#	undef THIS_FILE
+#	define THIS_FILE __FILE__
+#	define new DEBUG_NEW
+#endif
+
+// **************************************************************************
+// *** TIcbParserReset ******************************************************
+// **************************************************************************
+
+/// Resets a parser before TIcbParserPool hands it out again.
+///
+/// Parse_X() of a generated parser resets the state of the previous parse
+/// itself (keeping its buffers), so by default nothing is done. Parsers with
+/// state of their own, e.g. members defined by code fragments of the grammar,
+/// specialize this template:
+///
+///     template <> struct TIcbParserReset<CMyParser>
+///     {
+///         static inline void Reset(CMyParser& oParser) { oParser.ResetSymbols(); }
+///     };
+
+template <class TParser> struct TIcbParserReset
+{
+	static inline void Reset(TParser& /*oParser*/) { }
+};
+
+// **************************************************************************
+// *** TIcbParserPool *******************************************************
+// **************************************************************************
+
+/// This class provides parser instances to concurrent threads.
+///
+/// A parser instance must not be shared by threads, as it keeps the input
+/// and the state of the parse in members. Constructing one per request on
+/// the other hand costs the allocations of its buffers, which a parser that
+/// is used again keeps. The pool hands out such warm instances: Acquire()
+/// takes one, Release() resets it (see TIcbParserReset) and returns it.
+///
+/// Every thread has a cache of up to CACHE instances, so a thread that
+/// acquires and releases parsers in turn takes them from its cache without
+/// any synchronisation. Beyond that, the instances are kept in a global free
+/// list, a lock-free stack (the interlocked singly linked list of Windows,
+/// which avoids the ABA problem). New instances are only constructed if both
+/// are empty, so the number of instances grows to the number of parsers in
+/// use at the same time (plus the caches) and stays there.
+///
+/// The instances in the cache of a thread that ends are not used again before
+/// the pool is destructed. The pool must not be destructed while a thread is
+/// using it.
+
+template <class TParser, int CACHE = 4> class TIcbParserPool
+{
+	// *** Inner Classes ****************************************************
+private:
+	/// An instance with the entry of the global free list.
+	struct SItem
+	{
+		SLIST_ENTRY	m_oEntry;  ///< The entry of the global free list, must be aligned to MEMORY_ALLOCATION_ALIGNMENT.
+		TParser		m_oParser; ///< The parser.
+	};
+
+	/// The cache of a thread.
+	struct SCache
+	{
+		SCache*	m_pNext;		   ///< The next cache of the pool (all caches are linked for the destructor).
+		int		m_nSize;		   ///< The number of instances in the cache.
+		SItem*	m_apItems[CACHE]; ///< The instances.
+	};
+
+	// *** Attributes *******************************************************
+private:
+	SLIST_HEADER	m_oFree;	 ///< The global free list.
+	SCache* volatile m_pCaches;	 ///< The caches of all threads that used the pool.
+	DWORD			m_nTls;		 ///< The thread local storage index of the cache of each thread.
+	int volatile	m_nCreated;	 ///< The number of instances constructed so far.
+
+	// *** Methods **********************************************************
+private:
+	/// Returns the cache of the calling thread, which is created on first use.
+	SCache* DoGetCache()
+	{
+		SCache* pCache = (SCache*) ::TlsGetValue(m_nTls);
+		if(pCache == NULL) {
+			pCache = new SCache;
+			pCache->m_nSize = 0;
+			do { // push only, so no ABA problem
+				pCache->m_pNext = m_pCaches;
+			} while(::InterlockedCompareExchangePointer((PVOID volatile*) &m_pCaches, pCache, pCache->m_pNext) != pCache->m_pNext);
+			::TlsSetValue(m_nTls, pCache);
+		}
+		return pCache;
+	}
+
+	/// Returns the item of an instance handed out by Acquire().
+	static inline SItem* DoGetItem(TParser* pParser)
+	{
+		return CONTAINING_RECORD(pParser, SItem, m_oParser);
+	}
+
+	/// Not copyable, the instances are referenced by pointers.
+	TIcbParserPool(const TIcbParserPool&);
+	TIcbParserPool& operator = (const TIcbParserPool&);
+
+public:
+	/// Constructs an empty pool. No instances are constructed before the first Acquire() or Reserve().
+	TIcbParserPool() : m_pCaches(NULL), m_nCreated(0)
+	{
+		::InitializeSListHead(&m_oFree);
+		m_nTls = ::TlsAlloc();
+		ASSERT(m_nTls != TLS_OUT_OF_INDEXES);
+	}
+
+	/// Destructs the pool and all instances that have been released.
+	/// Instances that are still acquired must not be released afterwards.
+	~TIcbParserPool()
+	{
+		for(SLIST_ENTRY* pEntry = ::InterlockedFlushSList(&m_oFree); pEntry; ) {
+			SItem* pItem = CONTAINING_RECORD(pEntry, SItem, m_oEntry);
+			pEntry = pEntry->Next;
+			delete pItem;
+		}
+		for(SCache* pCache = m_pCaches; pCache; ) {
+			SCache* pNext = pCache->m_pNext;
+			for(int i = 0; i < pCache->m_nSize; i++) {
+				delete pCache->m_apItems[i];
+			}
+			delete pCache;
+			pCache = pNext;
+		}
+		::TlsFree(m_nTls);
+	}
+
+	/// Constructs instances in advance, so that the first nNum concurrent requests find warm ones.
+	/// @param nNum the number of instances to be added to the global free list.
+	void Reserve(int nNum)
+	{
+		for(int i = 0; i < nNum; i++) {
+			SItem* pItem = new SItem;
+			IcbAtomicInc(&m_nCreated);
+			::InterlockedPushEntrySList(&m_oFree, &pItem->m_oEntry);
+		}
+	}
+
+	/// Takes an instance from the cache of the calling thread or from the global free list,
+	/// or constructs a new one if both are empty.
+	/// @return the instance, which is used by the calling thread only until it is passed to Release().
+	TParser* Acquire()
+	{
+		SCache* pCache = (SCache*) ::TlsGetValue(m_nTls);
+		if(pCache && pCache->m_nSize > 0) {
+			return &pCache->m_apItems[--pCache->m_nSize]->m_oParser;
+		}
+		SLIST_ENTRY* pEntry = ::InterlockedPopEntrySList(&m_oFree);
+		if(pEntry) {
+			return &CONTAINING_RECORD(pEntry, SItem, m_oEntry)->m_oParser;
+		}
+		IcbAtomicInc(&m_nCreated);
+		return &(new SItem)->m_oParser;
+	}
+
+	/// Resets an instance and returns it to the cache of the calling thread, or to the
+	/// global free list if the cache is full. The instance may have been acquired by another thread.
+	/// @param pParser the instance returned by Acquire().
+	void Release(TParser* pParser)
+	{
+		TIcbParserReset<TParser>::Reset(*pParser);
+		SCache* pCache = DoGetCache();
+		if(pCache->m_nSize < CACHE) {
+			pCache->m_apItems[pCache->m_nSize++] = DoGetItem(pParser);
+		} else {
+			::InterlockedPushEntrySList(&m_oFree, &DoGetItem(pParser)->m_oEntry);
+		}
+	}
+
+	/// Returns the number of instances constructed so far, acquired or not.
+	int GetCreated() const
+	{
+		return m_nCreated;
+	}
+
+	// *** Lease ************************************************************
+
+	/// Acquires an instance for the lifetime of the object and releases it in the destructor:
+	///
+	///     TIcbParserPool<CMyParser>::CLease p(pool);
+	///     p->Parse_ROOT(input, size, output, pos);
+	class CLease
+	{
+	private:
+		TIcbParserPool&	m_oPool;
+		TParser*		m_pParser;
+
+		CLease(const CLease&);
+		CLease& operator = (const CLease&);
+
+	public:
+		CLease(TIcbParserPool& oPool) : m_oPool(oPool), m_pParser(oPool.Acquire()) { }
+		~CLease() { m_oPool.Release(m_pParser); }
+
+		inline TParser* operator -> () const { return m_pParser; }
+		inline TParser& operator * () const { return *m_pParser; }
+	};
+};
+
+// **************************************************************************
+
+#ifdef _DEBUG
+#   undef new
+#endif
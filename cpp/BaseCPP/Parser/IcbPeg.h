@@ -0,0 +1,346 @@
+// **************************************************************************
+//
+/// @file: IcbPeg.h
+/// Templates for parsing expression grammars (PEG) written in C++
+//
+// Intrasoft Code Base - Package Parser
+//
+//
+// **************************************************************************
+
+#ifdef _DEBUG
+#	undef THIS_FILE
+#	define THIS_FILE __FILE__
+#	define new DEBUG_NEW
+#endif
+
+// **************************************************************************
+// *** IcbPeg ***************************************************************
+// **************************************************************************
+
+/// The templates of this namespace express a grammar as C++ types, as an
+/// alternative to a parser generated by RSPT. Every parsing expression is a
+/// type with the static member function
+///
+///     template <class S> static bool Match(S& s, int& nPos);
+///
+/// which matches the input of the state s at nPos and advances nPos behind
+/// the match, or returns false (and leaves nPos unchanged). As all calls are
+/// resolved at compile time, the compiler sees the whole grammar at once and
+/// inlines everything but the recursive rules. A rule is a type derived from
+/// its expression, so rules may refer to each other before they are defined:
+///
+///     struct Expr;
+///     struct Atom : Choice< Seq< Char<'('>, Expr, Char<')'> >, Plus< Range<'0','9'> > > { };
+///     struct Expr : Seq< Atom, Star< Seq< Char<'+'>, Atom > > > { };
+///
+/// The state S is derived from TState and holds the input and the semantic
+/// values of the parse. Action<P, F> calls F::Apply(s, nBegin, nEnd) after P
+/// matched [nBegin, nEnd). As PEG backtracks, the semantic values pushed by an
+/// alternative that fails later on must be removed again: S may hide Mark()
+/// and Rollback() of TState, which are called around every alternative,
+/// repetition and predicate.
+///
+/// The constructs are those of RSPT grammars: TS (Char, Text), <set> (Set),
+/// <range> (Range), <notset> (NotSet), sequences (Seq), ordered choice
+/// (Choice) and source code fragments (Action), as well as repetitions
+/// (Star, Plus, Opt) and predicates (And, Not). Like generated parsers, the
+/// expressions must not be left recursive. Seq and Choice take up to 8
+/// expressions, which can be nested for more.
+
+namespace IcbPeg
+{
+	/// The base class of the state of a parse: the input and the farthest failure.
+	template <class TChar> class TState
+	{
+	public:
+		typedef TChar CharType;
+
+		const TChar* m_pInput; ///< The input.
+		int			 m_nSize;  ///< The number of characters of the input.
+		int			 m_nFail;  ///< The farthest position at which a terminal failed.
+
+		TState() : m_pInput(NULL), m_nSize(0), m_nFail(0) { }
+
+		/// Records that a terminal failed at nPos.
+		/// @return false.
+		inline bool Fail(int nPos)
+		{
+			if(nPos > m_nFail) {
+				m_nFail = nPos;
+			}
+			return false;
+		}
+
+		/// Returns the state of the semantic values, restored by Rollback() if an alternative fails.
+		inline int Mark() const { return 0; }
+
+		/// Removes the semantic values added since Mark() returned nMark.
+		inline void Rollback(int /*nMark*/) { }
+	};
+
+	/// Parses the input with the expression P.
+	/// @param s the state, which receives the input.
+	/// @param pInput the input.
+	/// @param nSize the number of characters of the input.
+	/// @param nPos receives the end of the match, or the farthest failure if the parse failed.
+	/// @return true if P matched the whole input.
+	template <class P, class S> inline bool Parse(S& s, const typename S::CharType* pInput, int nSize, int& nPos)
+	{
+		s.m_pInput = pInput;
+		s.m_nSize  = nSize;
+		s.m_nFail  = 0;
+		nPos       = 0;
+		bool bOk   = P::Match(s, nPos);
+		if(bOk && nPos == nSize) {
+			return true;
+		}
+		if(bOk) {
+			s.Fail(nPos); // the end of the input was expected
+		}
+		nPos = s.m_nFail;
+		return false;
+	}
+
+	// *** Terminals ********************************************************
+
+	/// Matches the empty input.
+	struct Empty
+	{
+		template <class S> static inline bool Match(S&, int&) { return true; }
+	};
+
+	/// Matches nothing (the unused expressions of Choice).
+	struct Never
+	{
+		template <class S> static inline bool Match(S&, int&) { return false; }
+	};
+
+	/// Matches any character.
+	struct Any
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			if(nPos >= s.m_nSize) return s.Fail(nPos);
+			nPos++;
+			return true;
+		}
+	};
+
+	/// Matches the character C (a TS of one character).
+	template <int C> struct Char
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			if(nPos >= s.m_nSize || s.m_pInput[nPos] != C) return s.Fail(nPos);
+			nPos++;
+			return true;
+		}
+	};
+
+	/// Matches a character from C1 to C2 (<range>).
+	template <int C1, int C2> struct Range
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			if(nPos >= s.m_nSize || s.m_pInput[nPos] < C1 || s.m_pInput[nPos] > C2) return s.Fail(nPos);
+			nPos++;
+			return true;
+		}
+	};
+
+	/// Matches the text T::Get(), a TS (see ICB_PEG_TEXT). The text consists of ASCII characters.
+	template <class T> struct Text
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			const char* p = T::Get();
+			int			n = nPos;
+			for(; *p; p++, n++) {
+				if(n >= s.m_nSize || s.m_pInput[n] != (unsigned char) *p) return s.Fail(nPos);
+			}
+			nPos = n;
+			return true;
+		}
+	};
+
+	/// Matches one of the characters of T::Get() (<set>, see ICB_PEG_SET).
+	template <class T> struct Set
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			if(nPos < s.m_nSize) {
+				for(const char* p = T::Get(); *p; p++) {
+					if(s.m_pInput[nPos] == (unsigned char) *p) {
+						nPos++;
+						return true;
+					}
+				}
+			}
+			return s.Fail(nPos);
+		}
+	};
+
+	/// Matches a character that is not one of the characters of T::Get() (<notset>, see ICB_PEG_NOTSET).
+	template <class T> struct NotSet
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			if(nPos >= s.m_nSize) return s.Fail(nPos);
+			for(const char* p = T::Get(); *p; p++) {
+				if(s.m_pInput[nPos] == (unsigned char) *p) return s.Fail(nPos);
+			}
+			nPos++;
+			return true;
+		}
+	};
+
+	// *** Composition ******************************************************
+
+	/// Matches P1 to P8 one after the other.
+	template <class P1, class P2, class P3 = Empty, class P4 = Empty, class P5 = Empty, class P6 = Empty, class P7 = Empty, class P8 = Empty> struct Seq
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			int n = nPos;
+			if(P1::Match(s, n) && P2::Match(s, n) && P3::Match(s, n) && P4::Match(s, n) &&
+			   P5::Match(s, n) && P6::Match(s, n) && P7::Match(s, n) && P8::Match(s, n)) {
+				nPos = n;
+				return true;
+			}
+			return false;
+		}
+	};
+
+	/// Matches the alternative P of a Choice, rolls back its semantic values if it fails.
+	template <class P> struct Alternative
+	{
+		template <class S> static inline bool Match(S& s, int& nPos, int nMark)
+		{
+			if(P::Match(s, nPos)) {
+				return true;
+			}
+			s.Rollback(nMark);
+			return false;
+		}
+	};
+
+	/// The unused alternatives of a Choice need no rollback.
+	template <> struct Alternative<Never>
+	{
+		template <class S> static inline bool Match(S&, int&, int) { return false; }
+	};
+
+	/// Matches the first of P1 to P8 that matches (ordered choice). The semantic values of a failed alternative are rolled back.
+	template <class P1, class P2, class P3 = Never, class P4 = Never, class P5 = Never, class P6 = Never, class P7 = Never, class P8 = Never> struct Choice
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			int nMark = s.Mark();
+			return Alternative<P1>::Match(s, nPos, nMark) || Alternative<P2>::Match(s, nPos, nMark) ||
+				   Alternative<P3>::Match(s, nPos, nMark) || Alternative<P4>::Match(s, nPos, nMark) ||
+				   Alternative<P5>::Match(s, nPos, nMark) || Alternative<P6>::Match(s, nPos, nMark) ||
+				   Alternative<P7>::Match(s, nPos, nMark) || Alternative<P8>::Match(s, nPos, nMark);
+		}
+	};
+
+	/// Matches P as often as possible, also never. Stops if P matches the empty input.
+	template <class P> struct Star
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			while(true) {
+				int nMark = s.Mark();
+				int n	  = nPos;
+				if(!P::Match(s, n)) {
+					s.Rollback(nMark);
+					return true;
+				}
+				if(n == nPos) {
+					return true;
+				}
+				nPos = n;
+			}
+		}
+	};
+
+	/// Matches P as often as possible, at least once.
+	template <class P> struct Plus
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			return P::Match(s, nPos) && Star<P>::Match(s, nPos);
+		}
+	};
+
+	/// Matches P or the empty input.
+	template <class P> struct Opt
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			int nMark = s.Mark();
+			if(!P::Match(s, nPos)) {
+				s.Rollback(nMark);
+			}
+			return true;
+		}
+	};
+
+	/// Matches the empty input if P matches, without consuming it or keeping its semantic values.
+	template <class P> struct And
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			int nMark = s.Mark();
+			int n	  = nPos;
+			bool bOk  = P::Match(s, n);
+			s.Rollback(nMark);
+			return bOk;
+		}
+	};
+
+	/// Matches the empty input if P does not match. The failures within P are not recorded.
+	template <class P> struct Not
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			int nMark = s.Mark();
+			int nFail = s.m_nFail;
+			int n	  = nPos;
+			bool bOk  = P::Match(s, n);
+			s.Rollback(nMark);
+			s.m_nFail = nFail;
+			return !bOk;
+		}
+	};
+
+	/// Matches P and calls F::Apply(s, nBegin, nEnd) for the matched input [nBegin, nEnd) (a source code fragment).
+	template <class P, class F> struct Action
+	{
+		template <class S> static inline bool Match(S& s, int& nPos)
+		{
+			int n = nPos;
+			if(!P::Match(s, n)) {
+				return false;
+			}
+			F::Apply(s, nPos, n);
+			nPos = n;
+			return true;
+		}
+	};
+}
+
+/// Defines the TS NAME, which matches the text TEXT (a string literal of ASCII characters).
+#define ICB_PEG_TEXT(NAME, TEXT)   struct NAME : IcbPeg::Text<NAME>   { static const char* Get() { return TEXT; } }
+
+/// Defines the TS NAME, which matches one of the characters of TEXT (a string literal of ASCII characters).
+#define ICB_PEG_SET(NAME, TEXT)    struct NAME : IcbPeg::Set<NAME>    { static const char* Get() { return TEXT; } }
+
+/// Defines the TS NAME, which matches any character but those of TEXT (a string literal of ASCII characters).
+#define ICB_PEG_NOTSET(NAME, TEXT) struct NAME : IcbPeg::NotSet<NAME> { static const char* Get() { return TEXT; } }
+
+// **************************************************************************
+
+#ifdef _DEBUG
+#   undef new
+#endif
@@ -0,0 +1,20 @@
+// **************************************************************************
+//
+// File: Include.h
+//
+// Intrasoft Code Base
+//
+// Include File for Package Parser
+//
+// Configuration
+// - ICB_PARSER_USE_PEG
+// - ICB_PARSER_USE_POOL
+//
+// **************************************************************************
+
+#ifdef ICB_PARSER_USE_PEG
+#  include "IcbPeg.h"
+#endif
+#ifdef ICB_PARSER_USE_POOL
+#  include "IcbParserPool.h"
+#endif
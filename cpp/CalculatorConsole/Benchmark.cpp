@@ -0,0 +1,339 @@
+#include "stdafx.h"
+#include <limits.h>
+#include "Benchmark.h"
+#include "Parser.h"
+#include "ParserTable.h"
+#include "ParserPeg.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+// The workload shapes. Each shape stresses a different part of the grammar.
+enum EBenchShape { SHAPE_SUMS, SHAPE_PARENS, SHAPE_IDENTS, SHAPE_NUMBERS, SHAPE_MIXED, SHAPE_COUNT };
+
+static const TCHAR* s_apszShapes[SHAPE_COUNT] = { _T("sums"), _T("parens"), _T("idents"), _T("numbers"), _T("mixed") };
+
+// How the expressions get their parser: all from one instance, each from a new instance (as a server
+// without a pool would do) or each from an instance acquired from a TIcbParserPool and released again.
+enum EBenchInstances { INSTANCES_SHARED, INSTANCES_NEW, INSTANCES_POOL, INSTANCES_COUNT };
+
+static const TCHAR* s_apszInstances[INSTANCES_COUNT] = { _T("shared"), _T("new"), _T("pool") };
+
+// The pooled parsers forget the variables of the previous expression, like independent requests.
+template <> struct TIcbParserReset<Parsers::CCalculatorParser>
+{
+	static inline void Reset(Parsers::CCalculatorParser& oParser) { oParser.ResetVariables(); }
+};
+
+template <> struct TIcbParserReset<Parsers::CCalculatorTableParser>
+{
+	static inline void Reset(Parsers::CCalculatorTableParser& oParser) { oParser.ResetVariables(); }
+};
+
+template <> struct TIcbParserReset<Parsers::CCalculatorPegParser>
+{
+	static inline void Reset(Parsers::CCalculatorPegParser& oParser) { oParser.ResetVariables(); }
+};
+
+// A linear congruential generator. We do not use rand() because the workloads
+// must be identical across platforms, runtimes and releases for a given seed.
+class CBenchRandom
+{
+private:
+	unsigned m_nState;
+
+public:
+	CBenchRandom(unsigned nSeed) : m_nState(nSeed) { }
+
+	int Next(int nRange)
+	{
+		m_nState = m_nState * 1103515245 + 12345;
+		return (int) ((m_nState >> 16) & 0x7FFF) % nRange;
+	}
+};
+
+static void AppendNumber(CString& s, CBenchRandom& r, int nDigits)
+{
+	s += (TCHAR) ('1' + r.Next(9));
+	for(int i = 1; i < nDigits; i++) {
+		s += (TCHAR) ('0' + r.Next(10));
+	}
+}
+
+static void AppendIdent(CString& s, CBenchRandom& r)
+{
+	static const TCHAR* apszIdents[] = { _T("x"), _T("y"), _T("z"), _T("alpha"), _T("beta"), _T("gamma"), _T("delta_1"), _T("delta_2"), _T("Rate"), _T("Total_Sum") };
+	s += apszIdents[r.Next(sizeof(apszIdents) / sizeof(apszIdents[0]))];
+}
+
+static void AppendOperator(CString& s, CBenchRandom& r, bool bAddOnly)
+{
+	static const TCHAR acOps[] = { '+', '-', '*', '/' };
+	s += acOps[r.Next(bAddOnly ? 2 : 4)];
+}
+
+// Creates a single expression with roughly nSize terms of the given shape.
+static CString MakeExpression(EBenchShape eShape, CBenchRandom& r, int nSize)
+{
+	CString s;
+	switch(eShape) {
+		case SHAPE_SUMS: // long sums of short numbers: 12+3-45+...
+			AppendNumber(s, r, 1 + r.Next(3));
+			for(int i = 1; i < nSize; i++) {
+				AppendOperator(s, r, true);
+				AppendNumber(s, r, 1 + r.Next(3));
+			}
+			break;
+
+		case SHAPE_PARENS: // deeply nested brackets: ((((1+2)*3)-4)/5)...
+			for(int i = 1; i < nSize; i++) {
+				s += '(';
+			}
+			AppendNumber(s, r, 1 + r.Next(2));
+			for(int i = 1; i < nSize; i++) {
+				AppendOperator(s, r, false);
+				AppendNumber(s, r, 1 + r.Next(2));
+				s += ')';
+			}
+			break;
+
+		case SHAPE_IDENTS: // assignments and variable references: x=y=alpha*beta+(z=Rate-2)...
+			for(int i = r.Next(3); i > 0; i--) {
+				AppendIdent(s, r);
+				s += '=';
+			}
+			AppendIdent(s, r);
+			for(int i = 1; i < nSize; i++) {
+				AppendOperator(s, r, false);
+				if(r.Next(4) == 0) {
+					s += '(';
+					AppendIdent(s, r);
+					s += '=';
+					AppendIdent(s, r);
+					AppendOperator(s, r, true);
+					AppendNumber(s, r, 1);
+					s += ')';
+				} else {
+					AppendIdent(s, r);
+				}
+			}
+			break;
+
+		case SHAPE_NUMBERS: // long numeric literals: 48213907*55120934/...
+			AppendNumber(s, r, 6 + r.Next(10));
+			for(int i = 1; i < nSize; i++) {
+				AppendOperator(s, r, false);
+				AppendNumber(s, r, 6 + r.Next(10));
+			}
+			break;
+
+		default: // mixed: pick one of the shapes above for every expression
+			return MakeExpression((EBenchShape) r.Next(SHAPE_MIXED), r, nSize);
+	}
+	return s;
+}
+
+// Parses a single expression.
+template<class TParser>
+static bool ParseExpression(TParser& p, const CString& input, bool bRoot)
+{
+	int error = 0;
+	if(bRoot) {
+		CString result;
+		return p.Parse_ROOT(input, input.GetLength(), result, error);
+	} else {
+		double result;
+		return p.Parse_EXPRESSION(input, input.GetLength(), result, error);
+	}
+}
+
+// Parses all inputs once, returns the number of inputs that failed to parse.
+template<class TParser>
+static int RunWorkload(TParser& p, TIcbParserPool<TParser>& pool, const TIcbArray<CString>& asInputs, bool bRoot, EBenchInstances eInstances)
+{
+	int nFailed = 0;
+	for(int i = 0; i < asInputs.GetSize(); i++) {
+		bool bOk;
+		if(eInstances == INSTANCES_NEW) {
+			TParser p2;
+			bOk = ParseExpression(p2, asInputs[i], bRoot);
+		} else if(eInstances == INSTANCES_POOL) {
+			typename TIcbParserPool<TParser>::CLease p2(pool);
+			bOk = ParseExpression(*p2, asInputs[i], bRoot);
+		} else {
+			bOk = ParseExpression(p, asInputs[i], bRoot);
+		}
+		if(!bOk) {
+			nFailed++;
+		}
+	}
+	return nFailed;
+}
+
+// Runs the untimed and timed passes over the workload with a fresh parser (or pool), returns the elapsed ticks of the timed passes.
+template<class TParser>
+static LONGLONG TimeWorkload(const TIcbArray<CString>& asInputs, bool bRoot, EBenchInstances eInstances, int nWarmup, int nIterations, int& nFailed)
+{
+	TParser p;
+	TIcbParserPool<TParser> pool;
+	for(int i = 0; i < nWarmup; i++) {
+		nFailed = RunWorkload(p, pool, asInputs, bRoot, eInstances);
+	}
+
+	LARGE_INTEGER nStart, nStop;
+	::QueryPerformanceCounter(&nStart);
+	for(int i = 0; i < nIterations; i++) {
+		nFailed = RunWorkload(p, pool, asInputs, bRoot, eInstances);
+	}
+	::QueryPerformanceCounter(&nStop);
+	return nStop.QuadPart - nStart.QuadPart;
+}
+
+// Parses a decimal number of an option. Returns false if the value is not a number or not within [nMin, nMax].
+static bool ParseNumber(const CString& value, int nMin, int nMax, int& n)
+{
+	LPCTSTR pszValue = value;
+	TCHAR*  pszEnd   = NULL;
+	long    nValue   = _tcstol(pszValue, &pszEnd, 10);
+	if(pszEnd == pszValue || *pszEnd != 0 || nValue < nMin || nValue > nMax) {
+		return false;
+	}
+	n = (int) nValue;
+	return true;
+}
+
+static void PrintUsage()
+{
+	_tprintf(_T("Syntax: $ CalculatorConsole --bench [--shape=<shape>] [--count=<n>] [--size=<n>] [--seed=<n>]\n"));
+	_tprintf(_T("                                    [--warmup=<n>] [--iterations=<n>] [--cpu=<n>] [--entry=root|expression]\n"));
+	_tprintf(_T("                                    [--parser=recursive|table|peg] [--instances=shared|new|pool]\n"));
+	_tprintf(_T("Where:\n"));
+	_tprintf(_T("    --shape      one of sums, parens, idents, numbers, mixed or all (default: all)\n"));
+	_tprintf(_T("    --count      number of expressions per workload (default: 1000)\n"));
+	_tprintf(_T("    --size       number of terms (or nesting depth) per expression (default: 50)\n"));
+	_tprintf(_T("    --seed       seed of the expression generator (default: 1)\n"));
+	_tprintf(_T("    --warmup     number of untimed passes over the workload (default: 3)\n"));
+	_tprintf(_T("    --iterations number of timed passes over the workload (default: 20)\n"));
+	_tprintf(_T("    --cpu        the CPU to pin the benchmark thread to (0 to %i), -1 to disable pinning (default: 0)\n"), (int) (8 * sizeof(DWORD_PTR)) - 1);
+	_tprintf(_T("    --entry      the exported symbol to parse (default: root)\n"));
+	_tprintf(_T("    --parser     the recursive descent parser (Parser.h) or the table driven LL(1) parser\n"));
+	_tprintf(_T("                 (ParserTable.h), which does not know Version, About and assignments after\n"));
+	_tprintf(_T("                 operators, or the parser written with the PEG templates of BaseCPP\n"));
+	_tprintf(_T("                 (ParserPeg.h) (default: recursive)\n"));
+	_tprintf(_T("    --instances  parses all expressions with one parser, each with a new parser or each with a\n"));
+	_tprintf(_T("                 parser from a TIcbParserPool, which resets its variables (default: shared)\n"));
+}
+
+int RunBenchmark(int argc, TCHAR* argv[])
+{
+	int  nShape      = -1;
+	int  nCount      = 1000;
+	int  nSize       = 50;
+	int  nSeed       = 1;
+	int  nWarmup     = 3;
+	int  nIterations = 20;
+	int  nCpu        = 0;
+	bool bRoot       = true;
+	CString sParser  = _T("recursive");
+	int  nInstances  = INSTANCES_SHARED;
+
+	for(int i = 0; i < argc; i++) {
+		CString arg = argv[i];
+		int nEq = arg.Find('=');
+		CString name  = nEq >= 0 ? arg.Left(nEq) : arg;
+		CString value = nEq >= 0 ? arg.Mid(nEq+1) : CString();
+		if(name == _T("--help")) {
+			PrintUsage();
+			return 2;
+		} else if(name == _T("--shape")) {
+			nShape = -2;
+			for(int j = 0; j < SHAPE_COUNT; j++) {
+				if(value == s_apszShapes[j]) nShape = j;
+			}
+			if(value == _T("all")) nShape = -1;
+		} else if(name == _T("--count")) {
+			if(!ParseNumber(value, 1, INT_MAX, nCount)) nShape = -2;
+		} else if(name == _T("--size")) {
+			if(!ParseNumber(value, 1, INT_MAX, nSize)) nShape = -2;
+		} else if(name == _T("--seed")) {
+			if(!ParseNumber(value, INT_MIN, INT_MAX, nSeed)) nShape = -2;
+		} else if(name == _T("--warmup")) {
+			if(!ParseNumber(value, 0, INT_MAX, nWarmup)) nShape = -2;
+		} else if(name == _T("--iterations")) {
+			if(!ParseNumber(value, 1, INT_MAX, nIterations)) nShape = -2;
+		} else if(name == _T("--cpu")) {
+			if(!ParseNumber(value, -1, (int) (8 * sizeof(DWORD_PTR)) - 1, nCpu)) nShape = -2;
+		} else if(name == _T("--entry") && (value == _T("root") || value == _T("expression"))) {
+			bRoot = value == _T("root");
+		} else if(name == _T("--parser") && (value == _T("recursive") || value == _T("table") || value == _T("peg"))) {
+			sParser = value;
+		} else if(name == _T("--instances")) {
+			nInstances = -1;
+			for(int j = 0; j < INSTANCES_COUNT; j++) {
+				if(value == s_apszInstances[j]) nInstances = j;
+			}
+			if(nInstances < 0) nShape = -2;
+		} else {
+			nShape = -2;
+		}
+		if(nShape == -2) {
+			_tprintf(_T("Error: Invalid argument '%s'.\n"), (LPCTSTR) arg);
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	// pin the thread to a single CPU to avoid migrations and frequency scaling differences between cores
+	if(nCpu >= 0) {
+		if(::SetThreadAffinityMask(::GetCurrentThread(), ((DWORD_PTR) 1) << nCpu) == 0) {
+			_tprintf(_T("Error: The thread cannot be pinned to CPU %i (error %u).\n"), nCpu, (unsigned) ::GetLastError());
+			return 2;
+		}
+		::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+	}
+
+	LARGE_INTEGER nFreq;
+	::QueryPerformanceFrequency(&nFreq);
+
+	_tprintf(_T("Benchmark: parser=%s instances=%s entry=%s count=%i size=%i seed=%i warmup=%i iterations=%i cpu=%i\n"),
+		(LPCTSTR) sParser, s_apszInstances[nInstances], bRoot ? _T("ROOT") : _T("EXPRESSION"), nCount, nSize, nSeed, nWarmup, nIterations, nCpu);
+	_tprintf(_T("%-8s %12s %12s %14s %10s %12s\n"), _T("shape"), _T("expressions"), _T("avg. length"), _T("expressions/s"), _T("MB/s"), _T("ns/expr"));
+
+	int nResult = 0;
+	for(int nShapeIdx = 0; nShapeIdx < SHAPE_COUNT; nShapeIdx++) {
+		if(nShape >= 0 && nShape != nShapeIdx) {
+			continue;
+		}
+
+		// generate the workload, every shape uses its own generator so that the shapes do not depend on each other
+		CBenchRandom      r(nSeed * SHAPE_COUNT + nShapeIdx);
+		TIcbArray<CString> asInputs(nCount);
+		double            nBytes = 0;
+		for(int i = 0; i < nCount; i++) {
+			asInputs.Add(MakeExpression((EBenchShape) nShapeIdx, r, nSize));
+			nBytes += asInputs[i].GetLength() * sizeof(TCHAR);
+		}
+
+		int             nFailed    = 0;
+		EBenchInstances eInstances = (EBenchInstances) nInstances;
+		LONGLONG        nTicks;
+		if(sParser == _T("table")) {
+			nTicks = TimeWorkload<Parsers::CCalculatorTableParser>(asInputs, bRoot, eInstances, nWarmup, nIterations, nFailed);
+		} else if(sParser == _T("peg")) {
+			nTicks = TimeWorkload<Parsers::CCalculatorPegParser>(asInputs, bRoot, eInstances, nWarmup, nIterations, nFailed);
+		} else {
+			nTicks = TimeWorkload<Parsers::CCalculatorParser>(asInputs, bRoot, eInstances, nWarmup, nIterations, nFailed);
+		}
+
+		double nSeconds = (double) nTicks / nFreq.QuadPart;
+		double nExprs   = (double) nCount * nIterations;
+		_tprintf(_T("%-8s %12i %12.1f %14.0f %10.2f %12.1f\n"), s_apszShapes[nShapeIdx], nCount, nBytes / sizeof(TCHAR) / nCount,
+			nExprs / nSeconds, nBytes * nIterations / nSeconds / (1024*1024), nSeconds * 1e9 / nExprs);
+		if(nFailed > 0) {
+			_tprintf(_T("Error: %i of %i expressions failed to parse.\n"), nFailed, nCount);
+			nResult = 1;
+		}
+	}
+	return nResult;
+}
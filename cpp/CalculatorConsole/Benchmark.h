@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs the throughput benchmark of the generated parser (CalculatorConsole --bench [options]).
+// argc and argv contain the options following --bench. Returns the process exit code.
+int RunBenchmark(int argc, TCHAR* argv[]);
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "CalculatorConsole.h"
+#include "Benchmark.h"
 #include "Parser.h"
 
 #ifdef _DEBUG
@@ -13,9 +14,14 @@ int _tmain(int argc, TCHAR* argv[], TCHAR* envp[])
 	if(argc <= 1) {
 		_tprintf(_T("CalculatorConsole -- An expression evaluator to showcase RSPT (the Really Simple Parser Tool)\n"));
 		_tprintf(_T("Syntax: $ CalculatorConsole <expression_1> [<expression_2> ... <expression_n>]\n"));
+		_tprintf(_T("        $ CalculatorConsole --bench [<options>] (see --bench --help)\n"));
 		return 2;
 	}
 
+	if(_tcscmp(argv[1], _T("--bench")) == 0) {
+		return RunBenchmark(argc-2, argv+2);
+	}
+
 	Parsers::CCalculatorParser p;
 
 	for(int i = 1; i < argc; i++) {
@@ -23,8 +29,9 @@ int _tmain(int argc, TCHAR* argv[], TCHAR* envp[])
 		CString result;
 		int     error = 0;
 		if(!p.Parse_ROOT(input, input.GetLength(), result, error)) {
+			// error is the farthest position the parser reached, GetExpected() what it would have accepted there
             CString next = input.GetLength()-error <= 50 ? input.Mid(error, input.GetLength()-error) : input.Mid(error, 50) + "...";
-			CString msg; msg.Format(_T("Error at offset %i: Cannot handle '%s'."), error+1, next);
+			CString msg; msg.Format(_T("Error at offset %i: Expected %s, cannot handle '%s'."), error+1, p.GetExpected(), next);
 			_tprintf(_T("Error: %s\n"), msg);
 		} else {
 			_tprintf(_T("Result: %s\n"), result);
@@ -0,0 +1,199 @@
+#pragma once
+#include <Math.h>
+
+// The calculator grammar (grammar/CalculatorCPP.txt) written with the PEG templates of BaseCPP
+// (Parser/IcbPeg.h) instead of being generated by RSPT. The parser has the same interface as
+// the generated CCalculatorParser (Parser.h), so the benchmark can run both.
+
+namespace Parsers {
+
+namespace CalculatorPeg {
+
+using namespace IcbPeg;
+
+class CState;
+
+// *** Actions ****************************************************************
+
+struct SetVersion  { static void Apply(CState& s, int nBegin, int nEnd); };
+struct SetAbout    { static void Apply(CState& s, int nBegin, int nEnd); };
+struct PushIdent   { static void Apply(CState& s, int nBegin, int nEnd); };
+struct PushConst   { static void Apply(CState& s, int nBegin, int nEnd); };
+struct PushPi      { static void Apply(CState& s, int nBegin, int nEnd); };
+struct PushE       { static void Apply(CState& s, int nBegin, int nEnd); };
+struct LookupIdent { static void Apply(CState& s, int nBegin, int nEnd); };
+struct Assign      { static void Apply(CState& s, int nBegin, int nEnd); };
+struct Add         { static void Apply(CState& s, int nBegin, int nEnd); };
+struct Subtract    { static void Apply(CState& s, int nBegin, int nEnd); };
+struct Multiply    { static void Apply(CState& s, int nBegin, int nEnd); };
+struct Divide      { static void Apply(CState& s, int nBegin, int nEnd); };
+
+// *** Grammar ****************************************************************
+
+ICB_PEG_TEXT(VersionText, "Version");
+ICB_PEG_TEXT(AboutText,   "About");
+ICB_PEG_TEXT(PiText,      "pi");
+
+struct EXPRESSION;
+
+struct IDENTCHAR_1 : Choice< Range<'a','z'>, Range<'A','Z'>, Char<'_'> > { };
+struct IDENTCHAR_N : Choice< Range<'a','z'>, Range<'A','Z'>, Char<'_'>, Range<'0','9'> > { };
+struct IDENT       : Action< Seq< IDENTCHAR_1, Star<IDENTCHAR_N> >, PushIdent > { };
+struct NUMBER      : Action< Plus< Range<'0','9'> >, PushConst > { };
+
+struct SYMBOL : Choice<
+	Action< PiText, PushPi >,
+	Action< Char<'e'>, PushE >,
+	Action< IDENT, LookupIdent > > { };
+
+struct VALUE : Choice< SYMBOL, NUMBER > { };
+
+struct EXPRESSION_BRA : Choice< Seq< Char<'('>, EXPRESSION, Char<')'> >, VALUE > { };
+
+// the binary operators, both levels associate from left to right like <left:n> in the generated parser
+struct EXPRESSION_MUL : Seq< EXPRESSION_BRA, Star< Choice<
+	Action< Seq< Char<'*'>, EXPRESSION_BRA >, Multiply >,
+	Action< Seq< Char<'/'>, EXPRESSION_BRA >, Divide > > > > { };
+
+struct EXPRESSION_OP : Seq< EXPRESSION_MUL, Star< Choice<
+	Action< Seq< Char<'+'>, EXPRESSION_MUL >, Add >,
+	Action< Seq< Char<'-'>, EXPRESSION_MUL >, Subtract > > > > { };
+
+struct EXPRESSION_SET : Choice< Action< Seq< IDENT, Char<'='>, EXPRESSION_SET >, Assign >, EXPRESSION_OP > { };
+
+struct EXPRESSION : EXPRESSION_SET { };
+
+struct ROOT : Choice< Action< VersionText, SetVersion >, Action< AboutText, SetAbout >, EXPRESSION > { };
+
+// *** State ******************************************************************
+
+// The semantic values of a parse: a stack of numbers and identifiers, which is rolled back with the alternatives.
+class CState : public TState<TCHAR>
+{
+public:
+	struct SValue
+	{
+		double	m_nValue; ///< The number, or the value of the identifier.
+		int		m_nBegin; ///< The input of the identifier, if any.
+		int		m_nEnd;
+	};
+
+	TIcbArray<SValue>				m_aValues;
+	TIcbHashtable<CString,double>	m_variables;
+	int								m_nRoot; ///< 1 if Version, 2 if About matched.
+
+	inline int Mark() const
+	{
+		return m_aValues.GetSize();
+	}
+
+	inline void Rollback(int nMark)
+	{
+		m_aValues.SetSize(nMark);
+	}
+
+	inline void Push(double nValue, int nBegin = 0, int nEnd = 0)
+	{
+		SValue v = { nValue, nBegin, nEnd };
+		m_aValues.Add(v);
+	}
+
+	inline double Pop()
+	{
+		double nValue = m_aValues[m_aValues.GetSize()-1].m_nValue;
+		m_aValues.SetSize(m_aValues.GetSize()-1);
+		return nValue;
+	}
+
+	inline SValue& Top()
+	{
+		return m_aValues[m_aValues.GetSize()-1];
+	}
+
+	inline CString Name(const SValue& v) const
+	{
+		return CString(m_pInput + v.m_nBegin, v.m_nEnd - v.m_nBegin);
+	}
+};
+
+inline void SetVersion::Apply(CState& s, int, int) { s.m_nRoot = 1; }
+inline void SetAbout::Apply(CState& s, int, int)   { s.m_nRoot = 2; }
+inline void PushIdent::Apply(CState& s, int nBegin, int nEnd) { s.Push(0, nBegin, nEnd); }
+inline void PushPi::Apply(CState& s, int, int) { s.Push(3.14); }
+inline void PushE::Apply(CState& s, int, int)  { s.Push(2.7); }
+inline void Add::Apply(CState& s, int, int)      { double n = s.Pop(); s.Top().m_nValue += n; }
+inline void Subtract::Apply(CState& s, int, int) { double n = s.Pop(); s.Top().m_nValue -= n; }
+inline void Multiply::Apply(CState& s, int, int) { double n = s.Pop(); s.Top().m_nValue *= n; }
+inline void Divide::Apply(CState& s, int, int)   { double n = s.Pop(); s.Top().m_nValue /= n; }
+
+inline void PushConst::Apply(CState& s, int nBegin, int nEnd)
+{
+	// short numbers are converted from a copy on the stack instead of a heap allocated string
+	TCHAR acBuffer[32];
+	if(nEnd - nBegin < 32) {
+		memcpy(acBuffer, s.m_pInput + nBegin, (nEnd - nBegin) * sizeof(TCHAR));
+		acBuffer[nEnd - nBegin] = 0;
+		s.Push(_tstof(acBuffer));
+	} else {
+		s.Push(_tstof(CString(s.m_pInput + nBegin, nEnd - nBegin)));
+	}
+}
+
+inline void LookupIdent::Apply(CState& s, int, int)
+{
+	CState::SValue& v = s.Top();
+	v.m_nValue = 0; // undefined variables are 0
+	s.m_variables.Get(s.Name(v), v.m_nValue);
+}
+
+inline void Assign::Apply(CState& s, int, int)
+{
+	double nValue = s.Pop();
+	CState::SValue& v = s.Top();
+	s.m_variables.Put(s.Name(v), nValue);
+	v.m_nValue = nValue;
+}
+
+}
+
+class CCalculatorPegParser
+{
+private:
+	CalculatorPeg::CState _state;
+
+public:
+	bool Parse_ROOT(const TCHAR* input, int size, CString& output, int& pos)
+	{
+		_state.m_aValues.SetSize(0);
+		_state.m_nRoot = 0;
+		if(!IcbPeg::Parse<CalculatorPeg::ROOT>(_state, input, size, pos)) {
+			return false;
+		}
+		if(_state.m_nRoot == 1) {
+			output = _T("Version 1.11 for C++/MFC");
+		} else if(_state.m_nRoot == 2) {
+			output = _T("Copyright (C) 2010 Philip Oswald");
+		} else {
+			output.Format(_T("%f"), _state.Top().m_nValue);
+		}
+		return true;
+	}
+
+	bool Parse_EXPRESSION(const TCHAR* input, int size, double& output, int& pos)
+	{
+		_state.m_aValues.SetSize(0);
+		if(!IcbPeg::Parse<CalculatorPeg::EXPRESSION>(_state, input, size, pos)) {
+			return false;
+		}
+		output = _state.Top().m_nValue;
+		return true;
+	}
+
+	// The variables are kept from one Parse_X() to the next, as in the generated parsers.
+	void ResetVariables()
+	{
+		_state.m_variables.Reset();
+	}
+};
+
+}
@@ -0,0 +1,456 @@
+//
+// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).
+//       Do not modify the contents of this file as it will be overwritten!
+//
+#pragma once;
+#include <Math.h>
+
+namespace Parsers {
+
+class CCalculatorTableParser
+{
+private:
+    enum { OP_TC, OP_TS, OP_TSET, OP_TNOTSET, OP_TRANGE, OP_CALL, OP_CODE, OP_RETURN };
+
+    enum { NT_ROOT, NT_EXPRESSION, NT_EXPRESSION_SET, NT_ASSIGNMENT, NT_OPERATORS, NT_EXPRESSION_ADD, NT_OPERATOR_ADD, NT_EXPRESSION_MUL, NT_OPERATOR_MUL, NT_EXPRESSION_BRA, NT_IDENT, NT_IDENTCHARS_N, NT_IDENTCHAR_1, NT_IDENTCHAR_N, NT_CONST, NT_DIGITS };
+
+    struct SOp     { short code; short step; int a; int b; };
+    struct SProd   { int pc; int steps; int values[3]; };
+    struct SRule   { int type; int prod; int count; int row; };
+    struct SFrame  { int pc; int out; int pos; int values[3]; };
+
+    const TCHAR* _input;
+    int _size;
+    TIcbArray<SFrame> _frames;
+    TIcbArray<int> _positions;
+    TIcbArray<CString> _values_CString;
+    TIcbArray<double> _values_double;
+    TIcbArray<void*> _values_void_ptr;
+
+public:
+    CCalculatorTableParser() : _input(NULL), _size(0) { }
+
+    bool Parse_ROOT(const TCHAR* input, int size, CString& output, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        _values_CString.SetSize(0);
+        _values_double.SetSize(0);
+        _values_void_ptr.SetSize(0);
+        _values_CString.Add(output);
+        bool ok = Run(NT_ROOT, 0, pos) && pos == _size;
+        output = _values_CString[0];
+        return ok;
+    }
+
+    bool Parse_EXPRESSION(const TCHAR* input, int size, double& output, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        _values_CString.SetSize(0);
+        _values_double.SetSize(0);
+        _values_void_ptr.SetSize(0);
+        _values_double.Add(output);
+        bool ok = Run(NT_EXPRESSION, 0, pos) && pos == _size;
+        output = _values_double[0];
+        return ok;
+    }
+
+private:
+    static const SOp* Ops() {
+        static const SOp ops[] = {
+            { OP_CALL, 1, NT_EXPRESSION_SET, 0 },    //    0 ROOT/1 EXPRESSION_SET
+            { OP_CODE, 0, 0, 0 },                    //    1  {...}
+            { OP_RETURN, 0, 0, 0 },                  //    2
+            { OP_CALL, 1, NT_EXPRESSION_SET, 0 },    //    3 EXPRESSION/1 EXPRESSION_SET
+            { OP_CODE, 0, 1, 0 },                    //    4  {...}
+            { OP_RETURN, 0, 0, 0 },                  //    5
+            { OP_CALL, 1, NT_IDENT, 0 },             //    6 EXPRESSION_SET/1 IDENT
+            { OP_CODE, 0, 2, 0 },                    //    7  {...}
+            { OP_CALL, 2, NT_ASSIGNMENT, -1 },       //    8  ASSIGNMENT
+            { OP_CODE, 0, 3, 0 },                    //    9  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   10
+            { OP_TC, 1, '(', 0 },                    //   11 EXPRESSION_SET/2 (
+            { OP_CALL, 2, NT_EXPRESSION, 0 },        //   12  EXPRESSION
+            { OP_TC, 3, ')', 0 },                    //   13  )
+            { OP_CODE, 0, 4, 0 },                    //   14  {...}
+            { OP_CALL, 4, NT_OPERATORS, -1 },        //   15  OPERATORS
+            { OP_RETURN, 0, 0, 0 },                  //   16
+            { OP_CALL, 1, NT_CONST, 0 },             //   17 EXPRESSION_SET/3 CONST
+            { OP_CODE, 0, 5, 0 },                    //   18  {...}
+            { OP_CALL, 2, NT_OPERATORS, -1 },        //   19  OPERATORS
+            { OP_RETURN, 0, 0, 0 },                  //   20
+            { OP_TC, 1, '=', 0 },                    //   21 ASSIGNMENT/1 =
+            { OP_CALL, 2, NT_EXPRESSION_SET, 0 },    //   22  EXPRESSION_SET
+            { OP_CODE, 0, 6, 0 },                    //   23  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   24
+            { OP_CALL, 1, NT_OPERATORS, -1 },        //   25 ASSIGNMENT/2 OPERATORS
+            { OP_RETURN, 0, 0, 0 },                  //   26
+            { OP_CALL, 1, NT_OPERATOR_MUL, -1 },     //   27 OPERATORS/1 OPERATOR_MUL
+            { OP_CALL, 2, NT_OPERATOR_ADD, -1 },     //   28  OPERATOR_ADD
+            { OP_RETURN, 0, 0, 0 },                  //   29
+            { OP_CALL, 1, NT_EXPRESSION_MUL, 0 },    //   30 EXPRESSION_ADD/1 EXPRESSION_MUL
+            { OP_CALL, 2, NT_OPERATOR_ADD, 0 },      //   31  OPERATOR_ADD
+            { OP_CODE, 0, 7, 0 },                    //   32  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   33
+            { OP_TC, 1, '+', 0 },                    //   34 OPERATOR_ADD/1 +
+            { OP_CALL, 2, NT_EXPRESSION_MUL, 0 },    //   35  EXPRESSION_MUL
+            { OP_CODE, 0, 8, 0 },                    //   36  {...}
+            { OP_CALL, 3, NT_OPERATOR_ADD, -1 },     //   37  OPERATOR_ADD
+            { OP_RETURN, 0, 0, 0 },                  //   38
+            { OP_TC, 1, '-', 0 },                    //   39 OPERATOR_ADD/2 -
+            { OP_CALL, 2, NT_EXPRESSION_MUL, 0 },    //   40  EXPRESSION_MUL
+            { OP_CODE, 0, 9, 0 },                    //   41  {...}
+            { OP_CALL, 3, NT_OPERATOR_ADD, -1 },     //   42  OPERATOR_ADD
+            { OP_RETURN, 0, 0, 0 },                  //   43
+            { OP_RETURN, 0, 0, 0 },                  //   44 OPERATOR_ADD/3
+            { OP_CALL, 1, NT_EXPRESSION_BRA, 0 },    //   45 EXPRESSION_MUL/1 EXPRESSION_BRA
+            { OP_CALL, 2, NT_OPERATOR_MUL, 0 },      //   46  OPERATOR_MUL
+            { OP_CODE, 0, 10, 0 },                   //   47  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   48
+            { OP_TC, 1, '*', 0 },                    //   49 OPERATOR_MUL/1 *
+            { OP_CALL, 2, NT_EXPRESSION_BRA, 0 },    //   50  EXPRESSION_BRA
+            { OP_CODE, 0, 11, 0 },                   //   51  {...}
+            { OP_CALL, 3, NT_OPERATOR_MUL, -1 },     //   52  OPERATOR_MUL
+            { OP_RETURN, 0, 0, 0 },                  //   53
+            { OP_TC, 1, '/', 0 },                    //   54 OPERATOR_MUL/2  / 
+            { OP_CALL, 2, NT_EXPRESSION_BRA, 0 },    //   55  EXPRESSION_BRA
+            { OP_CODE, 0, 12, 0 },                   //   56  {...}
+            { OP_CALL, 3, NT_OPERATOR_MUL, -1 },     //   57  OPERATOR_MUL
+            { OP_RETURN, 0, 0, 0 },                  //   58
+            { OP_RETURN, 0, 0, 0 },                  //   59 OPERATOR_MUL/3
+            { OP_TC, 1, '(', 0 },                    //   60 EXPRESSION_BRA/1 (
+            { OP_CALL, 2, NT_EXPRESSION_SET, 0 },    //   61  EXPRESSION_SET
+            { OP_TC, 3, ')', 0 },                    //   62  )
+            { OP_CODE, 0, 13, 0 },                   //   63  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   64
+            { OP_CALL, 1, NT_CONST, 0 },             //   65 EXPRESSION_BRA/2 CONST
+            { OP_CODE, 0, 14, 0 },                   //   66  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   67
+            { OP_CALL, 1, NT_IDENT, 0 },             //   68 EXPRESSION_BRA/3 IDENT
+            { OP_CODE, 0, 15, 0 },                   //   69  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   70
+            { OP_CALL, 1, NT_IDENTCHAR_1, 0 },       //   71 IDENT/1 IDENTCHAR_1
+            { OP_CALL, 2, NT_IDENTCHARS_N, 1 },      //   72  IDENTCHARS_N
+            { OP_CODE, 0, 16, 0 },                   //   73  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   74
+            { OP_CALL, 1, NT_IDENTCHAR_N, 0 },       //   75 IDENTCHARS_N/1 IDENTCHAR_N
+            { OP_CALL, 2, NT_IDENTCHARS_N, 1 },      //   76  IDENTCHARS_N
+            { OP_RETURN, 0, 0, 0 },                  //   77
+            { OP_RETURN, 0, 0, 0 },                  //   78 IDENTCHARS_N/2
+            { OP_TRANGE, 1, 'a', 'z' },              //   79 IDENTCHAR_1/1 az
+            { OP_RETURN, 0, 0, 0 },                  //   80
+            { OP_TRANGE, 1, 'A', 'Z' },              //   81 IDENTCHAR_1/2 AZ
+            { OP_RETURN, 0, 0, 0 },                  //   82
+            { OP_TC, 1, '_', 0 },                    //   83 IDENTCHAR_1/3 _
+            { OP_RETURN, 0, 0, 0 },                  //   84
+            { OP_TRANGE, 1, 'a', 'z' },              //   85 IDENTCHAR_N/1 az
+            { OP_RETURN, 0, 0, 0 },                  //   86
+            { OP_TRANGE, 1, 'A', 'Z' },              //   87 IDENTCHAR_N/2 AZ
+            { OP_RETURN, 0, 0, 0 },                  //   88
+            { OP_TC, 1, '_', 0 },                    //   89 IDENTCHAR_N/3 _
+            { OP_RETURN, 0, 0, 0 },                  //   90
+            { OP_TRANGE, 1, '0', '9' },              //   91 IDENTCHAR_N/4 09
+            { OP_RETURN, 0, 0, 0 },                  //   92
+            { OP_TRANGE, 1, '0', '9' },              //   93 CONST/1 09
+            { OP_CALL, 2, NT_DIGITS, 0 },            //   94  DIGITS
+            { OP_CODE, 0, 17, 0 },                   //   95  {...}
+            { OP_RETURN, 0, 0, 0 },                  //   96
+            { OP_TRANGE, 1, '0', '9' },              //   97 DIGITS/1 09
+            { OP_CALL, 2, NT_DIGITS, 0 },            //   98  DIGITS
+            { OP_RETURN, 0, 0, 0 },                  //   99
+            { OP_RETURN, 0, 0, 0 }                   //  100 DIGITS/2
+        };
+        return ops;
+    }
+
+    static const SProd* Prods() {
+        static const SProd prods[] = {
+            { 0, 2, { 0, 1, 0 } },
+            { 3, 2, { 0, 1, 0 } },
+            { 6, 3, { 1, 0, 0 } },
+            { 11, 5, { 0, 1, 0 } },
+            { 17, 3, { 1, 0, 0 } },
+            { 21, 3, { 0, 1, 0 } },
+            { 25, 2, { 0, 0, 0 } },
+            { 27, 3, { 0, 0, 0 } },
+            { 30, 3, { 0, 1, 0 } },
+            { 34, 4, { 0, 1, 0 } },
+            { 39, 4, { 0, 1, 0 } },
+            { 44, 1, { 0, 0, 0 } },
+            { 45, 3, { 0, 1, 0 } },
+            { 49, 4, { 0, 1, 0 } },
+            { 54, 4, { 0, 1, 0 } },
+            { 59, 1, { 0, 0, 0 } },
+            { 60, 4, { 0, 1, 0 } },
+            { 65, 2, { 1, 0, 0 } },
+            { 68, 2, { 1, 0, 0 } },
+            { 71, 3, { 0, 0, 2 } },
+            { 75, 3, { 0, 0, 2 } },
+            { 78, 1, { 0, 0, 0 } },
+            { 79, 2, { 0, 0, 0 } },
+            { 81, 2, { 0, 0, 0 } },
+            { 83, 2, { 0, 0, 0 } },
+            { 85, 2, { 0, 0, 0 } },
+            { 87, 2, { 0, 0, 0 } },
+            { 89, 2, { 0, 0, 0 } },
+            { 91, 2, { 0, 0, 0 } },
+            { 93, 3, { 0, 0, 1 } },
+            { 97, 3, { 0, 0, 1 } },
+            { 100, 1, { 0, 0, 0 } }
+        };
+        return prods;
+    }
+
+    static const SRule* Rules() {
+        static const SRule rules[] = {
+            { 0, 0, 1, -1 },         // ROOT
+            { 1, 1, 1, -1 },         // EXPRESSION
+            { 1, 2, 3, 0 },          // EXPRESSION_SET
+            { 1, 5, 2, 1 },          // ASSIGNMENT
+            { 1, 7, 1, -1 },         // OPERATORS
+            { 1, 8, 1, -1 },         // EXPRESSION_ADD
+            { 1, 9, 3, 2 },          // OPERATOR_ADD
+            { 1, 12, 1, -1 },        // EXPRESSION_MUL
+            { 1, 13, 3, 3 },         // OPERATOR_MUL
+            { 1, 16, 3, 4 },         // EXPRESSION_BRA
+            { 0, 19, 1, -1 },        // IDENT
+            { 2, 20, 2, 5 },         // IDENTCHARS_N
+            { 2, 22, 3, 6 },         // IDENTCHAR_1
+            { 2, 25, 4, 7 },         // IDENTCHAR_N
+            { 0, 29, 1, -1 },        // CONST
+            { 2, 30, 2, 8 }          // DIGITS
+        };
+        return rules;
+    }
+
+    static int Class(unsigned c) { // the class of an input symbol, class 0 is the end of the input
+        static const unsigned char classes[128] = {
+              1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+              1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+              1,  1,  1,  1,  1,  1,  1,  1,  2,  3,  4,  5,  1,  6,  1,  7,
+              8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  1,  1,  1,  9,  1,  1,
+              1, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+             10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,  1,  1,  1,  1, 11,
+              1, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+             12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  1,  1,  1,  1,  1
+        };
+        if(c < 128) return classes[c];
+        return 1;
+    }
+
+    static int Predict(int row, int cls) { // the alternative of a rule selected by the next input symbol, or -1
+        static const short table[9][13] = {
+            { -1, -1,  3, -1, -1, -1, -1, -1,  4, -1,  2,  2,  2 }, // EXPRESSION_SET
+            {  6, -1, -1,  6,  6,  6,  6,  6, -1,  5, -1, -1, -1 }, // ASSIGNMENT
+            { 11, -1, -1, 11, -1,  9, 10, -1, -1, -1, -1, -1, -1 }, // OPERATOR_ADD
+            { 15, -1, -1, 15, 13, 15, 15, 14, -1, -1, -1, -1, -1 }, // OPERATOR_MUL
+            { -1, -1, 16, -1, -1, -1, -1, -1, 17, -1, 18, 18, 18 }, // EXPRESSION_BRA
+            { 21, -1, -1, 21, 21, 21, 21, 21, 20, 21, 20, 20, 20 }, // IDENTCHARS_N
+            { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 23, 24, 22 }, // IDENTCHAR_1
+            { -1, -1, -1, -1, -1, -1, -1, -1, 28, -1, 26, 27, 25 }, // IDENTCHAR_N
+            { 31, -1, -1, 31, 31, 31, 31, 31, 30, -1, -1, -1, -1 }  // DIGITS
+        };
+        return table[row][cls];
+    }
+
+    template<class T> static int Alloc(TIcbArray<T>& values, int count) {
+        int base = values.GetSize();
+        for(int i = 0; i < count; i++) {
+            values.Add(T());
+        }
+        return base;
+    }
+
+    bool Enter(int nt, int out, int pos) {
+        const SRule& rule = Rules()[nt];
+        int prod = rule.prod;
+        if(rule.count > 1) {
+            prod = Predict(rule.row, pos < _size ? Class((unsigned) _input[pos]) : 0);
+            if(prod < 0) return false;
+        }
+        const SProd& p = Prods()[prod];
+        SFrame f;
+        f.pc  = p.pc;
+        f.out = out;
+        f.pos = _positions.GetSize();
+        for(int i = 0; i < p.steps; i++) {
+            _positions.Add(pos);
+        }
+        f.values[0] = Alloc(_values_CString, p.values[0]);
+        f.values[1] = Alloc(_values_double, p.values[1]);
+        f.values[2] = Alloc(_values_void_ptr, p.values[2]);
+        _frames.Add(f);
+        return true;
+    }
+
+    void Leave() {
+        const SFrame& f = _frames[_frames.GetSize()-1];
+        _positions.SetSize(f.pos);
+        _values_CString.SetSize(f.values[0]);
+        _values_double.SetSize(f.values[1]);
+        _values_void_ptr.SetSize(f.values[2]);
+        _frames.SetSize(_frames.GetSize()-1);
+    }
+
+    // Parses the NTS into the given slot of the value stack. On failure, pos is the position of the error.
+    bool Run(int nt, int out, int& pos) {
+        const SOp* ops = Ops();
+        _frames.SetSize(0);
+        _positions.SetSize(0);
+        if(!Enter(nt, out, pos)) return false;
+        while(true) {
+            SFrame& f = _frames[_frames.GetSize()-1];
+            const SOp& op = ops[f.pc++];
+            switch(op.code) {
+                case OP_TC:
+                    if(pos >= _size || _input[pos] != (TCHAR) op.a) return false;
+                    pos++;
+                    break;
+                case OP_TRANGE:
+                    if(pos >= _size || _input[pos] < (TCHAR) op.a || _input[pos] > (TCHAR) op.b) return false;
+                    pos++;
+                    break;
+                case OP_CALL:
+                    if(!Enter(op.a, op.b < 0 ? f.out : f.values[Rules()[op.a].type] + op.b, pos)) return false;
+                    continue; // posN is set on return
+                case OP_CODE:
+                    Action(op.a, f);
+                    continue;
+                case OP_RETURN:
+                    Leave();
+                    if(_frames.GetSize() == 0) return true;
+                    _positions[_frames[_frames.GetSize()-1].pos + ops[_frames[_frames.GetSize()-1].pc-1].step] = pos;
+                    continue;
+            }
+            _positions[f.pos + op.step] = pos;
+        }
+    }
+
+    void Action(int action, const SFrame& f) {
+        switch(action) {
+            case 0: { // ROOT
+                CString& output = _values_CString[f.out];
+                double& output1 = _values_double[f.values[1] + 0];
+                output.Format(_T("%f"), output1);
+                break;
+            }
+            case 1: { // EXPRESSION
+                double& output = _values_double[f.out];
+                double& output1 = _values_double[f.values[1] + 0];
+                output = output1;
+                break;
+            }
+            case 2: { // EXPRESSION_SET
+                double& output = _values_double[f.out];
+                CString& output1 = _values_CString[f.values[0] + 0];
+                output = Variable(output1);
+                break;
+            }
+            case 3: { // EXPRESSION_SET
+                double& output = _values_double[f.out];
+                CString& output1 = _values_CString[f.values[0] + 0];
+                int pos1 = _positions[f.pos + 1];
+                if(pos1 < _size && _input[pos1] == '=') _variables.Put(output1, output);
+                break;
+            }
+            case 4: { // EXPRESSION_SET
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output = output2;
+                break;
+            }
+            case 5: { // EXPRESSION_SET
+                double& output = _values_double[f.out];
+                CString& output1 = _values_CString[f.values[0] + 0];
+                output = _tstof(output1);
+                break;
+            }
+            case 6: { // ASSIGNMENT
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output = output2;
+                break;
+            }
+            case 7: { // EXPRESSION_ADD
+                double& output = _values_double[f.out];
+                double& output1 = _values_double[f.values[1] + 0];
+                output = output1;
+                break;
+            }
+            case 8: { // OPERATOR_ADD
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output += output2;
+                break;
+            }
+            case 9: { // OPERATOR_ADD
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output -= output2;
+                break;
+            }
+            case 10: { // EXPRESSION_MUL
+                double& output = _values_double[f.out];
+                double& output1 = _values_double[f.values[1] + 0];
+                output = output1;
+                break;
+            }
+            case 11: { // OPERATOR_MUL
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output *= output2;
+                break;
+            }
+            case 12: { // OPERATOR_MUL
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output /= output2;
+                break;
+            }
+            case 13: { // EXPRESSION_BRA
+                double& output = _values_double[f.out];
+                double& output2 = _values_double[f.values[1] + 0];
+                output = output2;
+                break;
+            }
+            case 14: { // EXPRESSION_BRA
+                double& output = _values_double[f.out];
+                CString& output1 = _values_CString[f.values[0] + 0];
+                output = _tstof(output1);
+                break;
+            }
+            case 15: { // EXPRESSION_BRA
+                double& output = _values_double[f.out];
+                CString& output1 = _values_CString[f.values[0] + 0];
+                output = Variable(output1);
+                break;
+            }
+            case 16: { // IDENT
+                CString& output = _values_CString[f.out];
+                int pos0 = _positions[f.pos + 0];
+                int pos2 = _positions[f.pos + 2];
+                output = CString(_input+pos0, pos2-pos0);
+                break;
+            }
+            case 17: { // CONST
+                CString& output = _values_CString[f.out];
+                int pos0 = _positions[f.pos + 0];
+                int pos2 = _positions[f.pos + 2];
+                output = CString(_input+pos0, pos2-pos0);
+                break;
+            }
+        }
+    }
+
+    TIcbHashtable<CString,double> _variables;
+    double Variable(const CString& name) {
+        double value = 0;
+        if(name == _T("pi")) return 3.14;
+        if(name == _T("e"))  return 2.7;
+        _variables.Get(name, value);
+        return value;
+    }
+    public: void ResetVariables() { _variables.Reset(); }
+};
+}
@@ -19,4 +19,8 @@
 #define ICB_PACKAGE_DATATYPES
 #define ICB_DATATYPES_USE_ARRAY
 #define ICB_DATATYPES_USE_HASHTABLE
+#define ICB_DATATYPES_USE_ARENA
+#define ICB_PACKAGE_PARSER
+#define ICB_PARSER_USE_PEG
+#define ICB_PARSER_USE_POOL
 #include "..\BaseCPP\Include.h"
@@ -0,0 +1,309 @@
+#include "stdafx.h"
+#include "Grammar.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+static CStringW ToString(const TIcbArray<WCHAR>& acText)
+{
+	return CStringW(acText.GetData(), acText.GetSize());
+}
+
+// Returns whether sToken is an instruction <prefix...>.
+static bool IsInstr(const CStringW& sToken, LPCWSTR pszPrefix)
+{
+	int nLength = (int) wcslen(pszPrefix);
+	return sToken.GetLength() > nLength && sToken.Left(nLength) == pszPrefix && ((LPCWSTR) sToken)[sToken.GetLength()-1] == L'>';
+}
+
+// Returns the text between the prefix and the closing '>' of an instruction.
+static CStringW InstrArg(const CStringW& sToken, LPCWSTR pszPrefix)
+{
+	int nLength = (int) wcslen(pszPrefix);
+	return sToken.Mid(nLength, sToken.GetLength() - nLength - 1);
+}
+
+static bool IsIdent(const CStringW& sText)
+{
+	LPCWSTR p = sText;
+	for(int i = 0; i < sText.GetLength(); i++) {
+		WCHAR c = p[i];
+		if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c == '_') || (i > 0 && c >= '0' && c <= '9'))) {
+			return false;
+		}
+	}
+	return sText.GetLength() > 0;
+}
+
+bool CGrammar::Read(LPCTSTR pszFile, CString& sError)
+{
+	FILE* pFile = _tfopen(pszFile, _T("rb"));
+	if(pFile == NULL) {
+		sError.Format(_T("Cannot open the grammar '%s'."), pszFile);
+		return false;
+	}
+	TIcbArray<unsigned char> abFile;
+	unsigned char abBuffer[4096];
+	int nRead;
+	while((nRead = (int) fread(abBuffer, 1, sizeof(abBuffer), pFile)) > 0) {
+		abFile.Add(abBuffer, nRead);
+	}
+	fclose(pFile);
+
+	TIcbArray<CStringW> asTokens;
+	return Tokenize(Decode(abFile), asTokens, sError) && Parse(asTokens, sError);
+}
+
+// Decodes UTF-16 (little endian with BOM) or UTF-8 (with or without BOM), like the StreamReader of RSPT.
+// Invalid UTF-8 sequences become U+FFFD, code points beyond U+FFFF become surrogate pairs where WCHAR has 16 bits.
+CStringW CGrammar::Decode(const TIcbArray<unsigned char>& abFile)
+{
+	const unsigned char* p = abFile.GetData();
+	int					 n = abFile.GetSize();
+	TIcbArray<WCHAR>	 acText(n);
+
+	if(n >= 2 && p[0] == 0xFF && p[1] == 0xFE) {
+		for(int i = 2; i+1 < n; i += 2) {
+			acText.Add((WCHAR) (p[i] | (p[i+1] << 8)));
+		}
+		return ToString(acText);
+	}
+
+	int i = n >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF ? 3 : 0;
+	while(i < n) {
+		unsigned c = p[i++];
+		int nFollow = c < 0x80 ? 0 : (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : -1;
+		if(nFollow > 0) {
+			c &= 0x3F >> nFollow;
+			for(int j = 0; j < nFollow; j++, i++) {
+				if(i >= n || (p[i] & 0xC0) != 0x80) {
+					nFollow = -1;
+					break;
+				}
+				c = (c << 6) | (p[i] & 0x3F);
+			}
+		}
+		if(nFollow < 0) {
+			acText.Add((WCHAR) 0xFFFD);
+		} else if(c > 0xFFFF && sizeof(WCHAR) == 2) {
+			acText.Add((WCHAR) (0xD800 + ((c - 0x10000) >> 10)));
+			acText.Add((WCHAR) (0xDC00 + ((c - 0x10000) & 0x3FF)));
+		} else {
+			acText.Add((WCHAR) c);
+		}
+	}
+	return ToString(acText);
+}
+
+// Splits the grammar into tokens, see Grammar.Tokenize() of RSPT.
+bool CGrammar::Tokenize(const CStringW& sText, TIcbArray<CStringW>& asTokens, CString& sError)
+{
+	LPCWSTR			 p = sText;
+	int				 n = sText.GetLength();
+	TIcbArray<WCHAR> acToken;
+	TIcbArray<WCHAR> acBrace;
+	for(int i = 0; i < n; i++) {
+		WCHAR c = p[i];
+		if(acBrace.GetSize() > 0 && c == acBrace[acBrace.GetSize()-1]) { // closing brace
+			acBrace.SetSize(acBrace.GetSize()-1);
+			acToken.Add(c);
+		} else if((c == ' ' || c == '\t' || c == '\r' || c == '\n') && acBrace.GetSize() == 0) { // whitespace (not inside brace)
+			if(acToken.GetSize() > 0) {
+				asTokens.Add(ToString(acToken));
+				acToken.SetSize(0);
+			}
+		} else if(c == '#' && acBrace.GetSize() == 0) { // comment (not inside brace)
+			if(acToken.GetSize() > 0) {
+				asTokens.Add(ToString(acToken));
+				acToken.SetSize(0);
+			}
+			while(i+1 < n && p[i+1] != '\r' && p[i+1] != '\n') {
+				i++;
+			}
+		} else if(c == '\"' || c == '\'') { // quoted string
+			acToken.Add(c);
+			WCHAR cQuote = c;
+			while(true) {
+				if(++i >= n || p[i] == '\r' || p[i] == '\n') {
+					sError.Format(_T("Unexpected EOL, expected '%c'."), (TCHAR) cQuote);
+					return false;
+				}
+				c = p[i];
+				if(c == cQuote) {
+					acToken.Add(c);
+					break;
+				} else if(c == '\\') {
+					switch(++i < n ? p[i] : 0) {
+						case '\\': c = '\\'; break;
+						case '\'': c = '\''; break;
+						case '\"': c = '\"'; break;
+						case 't':  c = '\t'; break;
+						case 'r':  c = '\r'; break;
+						case 'n':  c = '\n'; break;
+						default:
+							sError = _T("Invalid escape sequence, expected one of: \\ \' \" t r n .");
+							return false;
+					}
+				}
+				acToken.Add(c);
+			}
+		} else if(c == '(') { // opening brace
+			acBrace.Add(')');
+			acToken.Add(c);
+		} else if(c == '{') { // opening brace
+			acBrace.Add('}');
+			acToken.Add(c);
+		} else if(c == '[') { // opening brace
+			acBrace.Add(']');
+			acToken.Add(c);
+		} else if(c == '<' && acBrace.GetSize() == 0) { // opening brace (only at top level)
+			acBrace.Add('>');
+			acToken.Add(c);
+		} else { // normal character
+			acToken.Add(c);
+		}
+	}
+	if(acToken.GetSize() > 0) {
+		asTokens.Add(ToString(acToken));
+	}
+	if(acBrace.GetSize() > 0) {
+		sError.Format(_T("Unexpected EOF, expected '%c'."), (TCHAR) acBrace[acBrace.GetSize()-1]);
+		return false;
+	}
+	return true;
+}
+
+// Reads the NTS and their rules from the tokens, see Grammar.Parse() of RSPT.
+bool CGrammar::Parse(const TIcbArray<CStringW>& asTokens, CString& sError)
+{
+	int	 nPos	  = 0;
+	bool bExport  = false;
+	int	 nOperand = -1;
+	while(nPos < asTokens.GetSize()) {
+		const CStringW& sToken = asTokens[nPos];
+		LPCWSTR			p	   = sToken;
+		int				n	   = sToken.GetLength();
+		if(sToken == L"<export>") {
+			bExport = true;
+		} else if(sToken == L"<memo>" || IsInstr(sToken, L"<sync:") || IsInstr(sToken, L"<include:") ||
+				  IsInstr(sToken, L"<namespace:") || IsInstr(sToken, L"<class:")) {
+			// only of interest to the code generators
+		} else if(IsInstr(sToken, L"<operators:")) {
+			nOperand = GetNonTerm(InstrArg(sToken, L"<operators:"), sError);
+			if(nOperand < 0) {
+				return false;
+			}
+		} else if(IsInstr(sToken, L"<option:")) {
+			m_asOptions.Add(InstrArg(sToken, L"<option:"));
+		} else if(n > 2 && p[0] == '{' && p[n-1] == '}') {
+			// a source code fragment of the parser class
+		} else {
+			int nNonTerm = GetNonTerm(sToken, sError);
+			if(nNonTerm < 0) {
+				return false;
+			}
+			if(bExport) {
+				m_anExports.Add(nNonTerm);
+			}
+			m_aNonTerms[nNonTerm].m_nOperand = nOperand;
+			bExport	 = false;
+			nOperand = -1;
+			if(++nPos < asTokens.GetSize() && asTokens[nPos] == L":") {
+				if(nPos+1 < asTokens.GetSize()) {
+					m_aNonTerms[nNonTerm].m_sType = asTokens[nPos+1];
+				}
+				nPos += 2;
+			}
+			if(nPos >= asTokens.GetSize() || asTokens[nPos] != L"=") {
+				sError.Format(_T("%ls: Unexpected token '%ls'. Expected: '='."), (LPCWSTR) sToken, nPos < asTokens.GetSize() ? (LPCWSTR) asTokens[nPos] : L"");
+				return false;
+			}
+			do {
+				if(++nPos >= asTokens.GetSize()) {
+					sError.Format(_T("%ls: Unexpected EOF, expected ';'."), (LPCWSTR) sToken);
+					return false;
+				}
+				CRule rule;
+				while(asTokens[nPos] != L"|" && asTokens[nPos] != L";") {
+					const CStringW& sSymbol = asTokens[nPos];
+					LPCWSTR			q		= sSymbol;
+					int				m		= sSymbol.GetLength();
+					SSymbol			sym;
+					sym.m_nNonTerm = -1;
+					sym.m_eInstr   = INSTR_NONE;
+					if(m >= 2 && q[0] == '\'' && q[m-1] == '\'') {
+						sym.m_eType = SYMBOL_TERM;
+						sym.m_sText = sSymbol.Mid(1, m-2);
+					} else if(m > 2 && q[0] == '{' && q[m-1] == '}') {
+						int i1 = 1, i2 = m-1; // the code without the surrounding blanks
+						while(i1 < i2 && q[i1] == ' ') i1++;
+						while(i2 > i1 && q[i2-1] == ' ') i2--;
+						sym.m_eType = SYMBOL_CODE;
+						sym.m_sText = sSymbol.Mid(i1, i2-i1);
+					} else if(m > 2 && q[0] == '<' && q[m-1] == '>') {
+						sym.m_eType = SYMBOL_INSTR;
+						if(IsInstr(sSymbol, L"<to:")) {
+							sym.m_eInstr = INSTR_TO;
+							sym.m_sText	 = InstrArg(sSymbol, L"<to:");
+						} else if(sSymbol == L"<set>") {
+							sym.m_eInstr = INSTR_SET;
+						} else if(sSymbol == L"<range>") {
+							sym.m_eInstr = INSTR_RANGE;
+						} else if(sSymbol == L"<notset>") {
+							sym.m_eInstr = INSTR_NOTSET;
+						} else if(IsInstr(sSymbol, L"<left:")) {
+							sym.m_eInstr = INSTR_LEFT;
+							sym.m_sText	 = InstrArg(sSymbol, L"<left:");
+						} else if(IsInstr(sSymbol, L"<right:")) {
+							sym.m_eInstr = INSTR_RIGHT;
+							sym.m_sText	 = InstrArg(sSymbol, L"<right:");
+						} else {
+							sError.Format(_T("Invalid instruction %ls."), q);
+							return false;
+						}
+					} else {
+						sym.m_eType	   = SYMBOL_NONTERM;
+						sym.m_nNonTerm = GetNonTerm(sSymbol, sError);
+						if(sym.m_nNonTerm < 0) {
+							return false;
+						}
+					}
+					rule.Add(sym);
+					if(++nPos >= asTokens.GetSize()) {
+						sError.Format(_T("%ls: Unexpected EOF, expected ';'."), (LPCWSTR) sToken);
+						return false;
+					}
+				}
+				m_aNonTerms[nNonTerm].m_aRules.Add(rule);
+			} while(asTokens[nPos] != L";");
+		}
+		nPos++;
+	}
+	for(int i = 0; i < m_aNonTerms.GetSize(); i++) {
+		if(m_aNonTerms[i].m_aRules.GetSize() == 0) {
+			sError.Format(_T("%ls: Symbol is used but not defined."), (LPCWSTR) m_aNonTerms[i].m_sName);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Returns the index of the NTS with the given name, adds the NTS if it is new.
+int CGrammar::GetNonTerm(const CStringW& sName, CString& sError)
+{
+	if(!IsIdent(sName)) {
+		sError.Format(_T("Invalid non terminal symbol name '%ls'."), (LPCWSTR) sName);
+		return -1;
+	}
+	int nNonTerm;
+	if(!m_index.Get(sName, nNonTerm)) {
+		SNonTerm nt;
+		nt.m_sName		= sName;
+		nt.m_nOperand = -1;
+		nNonTerm = m_aNonTerms.GetSize();
+		m_aNonTerms.Add(nt);
+		m_index.Put(sName, nNonTerm);
+	}
+	return nNonTerm;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// A grammar read from a grammar file, the C++ counterpart of cs/RSPT/Grammar.cs and cs/RSPT/Symbol.cs.
+// Only what the interpreter and the input generator need is kept: the NTS with their rules and the
+// exported NTS. Includes, namespace, class and source code fragments outside of rules are skipped.
+// The text of the grammar is kept as wide characters (CStringW) independent of TCHAR, so that TS
+// beyond ASCII (like U+263A in SyntaxHighlightCPP.txt) are compared to the input like the generated
+// parsers compare their character constants.
+
+// The kinds of symbols of a rule.
+enum ESymbol { SYMBOL_NONTERM, SYMBOL_TERM, SYMBOL_CODE, SYMBOL_INSTR };
+
+// The instructions, which modify the following TS or NTS.
+enum EInstruction { INSTR_NONE, INSTR_TO, INSTR_SET, INSTR_RANGE, INSTR_NOTSET, INSTR_LEFT, INSTR_RIGHT };
+
+struct SSymbol
+{
+	ESymbol			m_eType;
+	int				m_nNonTerm; ///< SYMBOL_NONTERM: the index of the NTS in CGrammar::m_aNonTerms.
+	EInstruction	m_eInstr;   ///< SYMBOL_INSTR: the instruction.
+	CStringW		m_sText;    ///< SYMBOL_TERM: the text without quotes, SYMBOL_CODE: the code without braces,
+								///< SYMBOL_INSTR: the argument of <to:xxx>, <left:n> and <right:n>.
+};
+
+typedef TIcbArray<SSymbol> CRule;
+
+struct SNonTerm
+{
+	CStringW			m_sName;
+	CStringW			m_sType;      ///< The type of the output, empty if none.
+	int					m_nOperand;   ///< The index of the operand if the NTS is an operator table (<operators:xxx>), -1 otherwise.
+	TIcbArray<CRule>	m_aRules;
+};
+
+class CGrammar
+{
+public:
+	TIcbArray<SNonTerm>	m_aNonTerms;
+	TIcbArray<int>		m_anExports; ///< The indexes of the exported NTS.
+	TIcbArray<CStringW>	m_asOptions; ///< The code generator options (<option:xxx>).
+
+	// Reads a grammar file, which is UTF-8 (with or without BOM) or UTF-16 (with BOM).
+	// Returns false and sets sError if the file cannot be read or the grammar is invalid.
+	bool Read(LPCTSTR pszFile, CString& sError);
+
+private:
+	TIcbFlatHashtable<CStringW,int> m_index; ///< The indexes of the NTS by name.
+
+	static CStringW Decode(const TIcbArray<unsigned char>& abFile);
+	static bool Tokenize(const CStringW& sText, TIcbArray<CStringW>& asTokens, CString& sError);
+	bool Parse(const TIcbArray<CStringW>& asTokens, CString& sError);
+	int  GetNonTerm(const CStringW& sName, CString& sError);
+};
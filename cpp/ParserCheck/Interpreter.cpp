@@ -0,0 +1,257 @@
+#include "stdafx.h"
+#include "Interpreter.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CInterpreter::CInterpreter(const CGrammar& grammar) : m_grammar(grammar), m_pInput(NULL), m_nSize(0), m_nFail(0)
+{
+}
+
+// Returns the index of the right operand of an operator, the last reference of the operator table to itself.
+static int GetSelf(const CRule& rule, int nNonTerm)
+{
+	for(int i = rule.GetSize()-1; i >= 0; i--) {
+		if(rule[i].m_eType == SYMBOL_NONTERM && rule[i].m_nNonTerm == nNonTerm) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool CInterpreter::Check(CString& sError) const
+{
+	for(int i = 0; i < m_grammar.m_aNonTerms.GetSize(); i++) {
+		const SNonTerm& nt = m_grammar.m_aNonTerms[i];
+		for(int j = 0; j < nt.m_aRules.GetSize(); j++) {
+			const CRule& rule = nt.m_aRules[j];
+			int nSelf = GetSelf(rule, i);
+			if(nt.m_nOperand >= 0) { // see GeneratorRecursiveCPP.GenerateOperators()
+				bool bOk = rule.GetSize() > 0 && rule[0].m_eType == SYMBOL_INSTR && (rule[0].m_eInstr == INSTR_LEFT || rule[0].m_eInstr == INSTR_RIGHT) &&
+						   _wtoi(rule[0].m_sText) > 0 && nSelf > 1 && rule[nSelf-1].m_eType != SYMBOL_INSTR;
+				for(int k = nSelf+1; k < rule.GetSize() && bOk; k++) {
+					bOk = rule[k].m_eType == SYMBOL_CODE;
+				}
+				if(!bOk) {
+					sError.Format(_T("%ls: Invalid operator, expected: <left:n> or <right:n>, the operator, %ls and source code."), (LPCWSTR) nt.m_sName, (LPCWSTR) nt.m_sName);
+					return false;
+				}
+				continue;
+			}
+			int nSymbols = 0; // the TS and NTS before the action
+			int nOutputs = 0; // the NTS before the action
+			for(int k = 0; k < rule.GetSize(); k++) {
+				const SSymbol& sym = rule[k];
+				if(sym.m_eType == SYMBOL_NONTERM) {
+					nSymbols++;
+					nOutputs++;
+				} else if(sym.m_eType == SYMBOL_TERM) {
+					nSymbols++;
+				} else if(sym.m_eType == SYMBOL_INSTR && (sym.m_eInstr == INSTR_LEFT || sym.m_eInstr == INSTR_RIGHT)) {
+					sError.Format(_T("%ls: <left:n> and <right:n> are only allowed in operator tables."), (LPCWSTR) nt.m_sName);
+					return false;
+				} else if(sym.m_eType == SYMBOL_CODE && nt.m_sType.GetLength() == 0) {
+					LPCWSTR p = sym.m_sText;
+					int		n = sym.m_sText.GetLength();
+					for(int c = 0; c < n; c++) {
+						if(p[c] != '$') {
+							continue;
+						}
+						bool bOk;
+						if(c+2 < n && p[c+1] == 'i' && p[c+2] >= '1' && p[c+2] <= '9') {
+							bOk = p[c+2] - '0' <= nSymbols;
+							c += 2;
+						} else if(c+1 < n && p[c+1] >= '1' && p[c+1] <= '9') {
+							bOk = p[c+1] - '0' <= nOutputs;
+							c++;
+						} else {
+							bOk = c+1 < n && p[c+1] == '$';
+							c++;
+						}
+						if(!bOk) {
+							sError.Format(_T("%ls: Invalid code '%ls'."), (LPCWSTR) nt.m_sName, p);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool CInterpreter::Parse(int nNonTerm, const TCHAR* input, int size, CString& output, int& pos)
+{
+	m_pInput = input;
+	m_nSize	 = size;
+	m_nFail	 = 0;
+	pos		 = 0;
+	TIcbArray<TCHAR> acOutput;
+	bool ok = ParseNT(nNonTerm, pos, acOutput);
+	if(!ok || pos != size) {
+		if(ok) {
+			Fail(pos); // the end of the input was expected
+		}
+		pos = m_nFail;
+		return false;
+	}
+	output = CString(acOutput.GetData(), acOutput.GetSize());
+	return true;
+}
+
+bool CInterpreter::ParseNT(int nNonTerm, int& nPos, TIcbArray<TCHAR>& acOutput)
+{
+	const SNonTerm& nt = m_grammar.m_aNonTerms[nNonTerm];
+	if(nt.m_nOperand >= 0) {
+		return ParseOperators(nNonTerm, 0, nPos);
+	}
+	for(int i = 0; i < nt.m_aRules.GetSize(); i++) {
+		int nOutput = acOutput.GetSize();
+		if(ParseSymbols(nt.m_aRules[i], 0, nt.m_aRules[i].GetSize(), nt.m_sType.GetLength() == 0, nPos, acOutput)) {
+			return true;
+		}
+		acOutput.SetSize(nOutput); // the output of the failed alternative
+	}
+	return false;
+}
+
+// Parses an operand, followed by as many operators with a precedence of at least nPrec as possible. The rules are
+// tried in their order after every operand, like the precedence climbing loop op_X of the C++ generator.
+bool CInterpreter::ParseOperators(int nNonTerm, int nPrec, int& nPos)
+{
+	const SNonTerm&	 nt = m_grammar.m_aNonTerms[nNonTerm];
+	TIcbArray<TCHAR> acOutput; // an operator table has a type, so there is no output
+	if(!ParseNT(nt.m_nOperand, nPos, acOutput)) {
+		return false;
+	}
+	for(int i = 0; i < nt.m_aRules.GetSize(); ) {
+		const CRule& rule	= nt.m_aRules[i];
+		int			 nLevel = _wtoi(rule[0].m_sText);
+		int			 nSelf	= GetSelf(rule, nNonTerm);
+		int			 nPos2	= nPos;
+		if(nLevel >= nPrec && ParseSymbols(rule, 1, nSelf, false, nPos2, acOutput) &&
+		   ParseOperators(nNonTerm, rule[0].m_eInstr == INSTR_LEFT ? nLevel+1 : nLevel, nPos2)) {
+			nPos = nPos2;
+			i	 = 0; // the next operator
+		} else {
+			i++;
+		}
+	}
+	return true;
+}
+
+// Parses the symbols [nStart, nEnd) of the rule. The actions are interpreted as output templates if bOutput is set,
+// otherwise they are skipped. nPos is only moved if all symbols matched.
+bool CInterpreter::ParseSymbols(const CRule& rule, int nStart, int nEnd, bool bOutput, int& nPos, TIcbArray<TCHAR>& acOutput)
+{
+	TIcbArray<int>					anPos;
+	TIcbArray< TIcbArray<TCHAR> >	aacOutputs;
+
+	bool ok	   = true;
+	int	 nPos2 = nPos;
+	anPos.Add(nPos2);
+
+	EInstruction eInstr = INSTR_NONE;
+	for(int j = nStart; j < nEnd && ok; j++) {
+		const SSymbol& sym = rule[j];
+		switch(sym.m_eType) {
+			case SYMBOL_NONTERM:
+				aacOutputs.SetSize(aacOutputs.GetSize()+1);
+				ok = ParseNT(sym.m_nNonTerm, nPos2, aacOutputs[aacOutputs.GetSize()-1]);
+				anPos.Add(nPos2);
+				eInstr = INSTR_NONE; // <to:xxx> has no meaning for output templates
+				break;
+
+			case SYMBOL_TERM:
+				switch(eInstr) {
+					case INSTR_SET:	   ok = ParseTSET(nPos2, sym.m_sText);	  break;
+					case INSTR_NOTSET: ok = ParseTNOTSET(nPos2, sym.m_sText); break;
+					case INSTR_RANGE:  ok = ParseTRGE(nPos2, ((LPCWSTR) sym.m_sText)[0], ((LPCWSTR) sym.m_sText)[1]); break;
+					default:		   ok = ParseTS(nPos2, sym.m_sText);	  break;
+				}
+				anPos.Add(nPos2);
+				eInstr = INSTR_NONE;
+				break;
+
+			case SYMBOL_CODE:
+				if(bOutput) {
+					InterpretCode(sym.m_sText, anPos, aacOutputs, acOutput);
+				}
+				break;
+
+			case SYMBOL_INSTR:
+				eInstr = sym.m_eInstr;
+				break;
+		}
+	}
+	if(ok) {
+		nPos = nPos2;
+	}
+	return ok;
+}
+
+bool CInterpreter::ParseTS(int& nPos, const CStringW& s)
+{
+	LPCWSTR p = s;
+	int		n = nPos;
+	for(int i = 0; i < s.GetLength(); i++, n++) {
+		if(n >= m_nSize || m_pInput[n] != p[i]) return Fail(nPos);
+	}
+	nPos = n;
+	return true;
+}
+
+bool CInterpreter::ParseTSET(int& nPos, const CStringW& s)
+{
+	LPCWSTR p = s;
+	if(nPos < m_nSize) {
+		for(int i = 0; i < s.GetLength(); i++) {
+			if(m_pInput[nPos] == p[i]) {
+				nPos++;
+				return true;
+			}
+		}
+	}
+	return Fail(nPos);
+}
+
+bool CInterpreter::ParseTNOTSET(int& nPos, const CStringW& s)
+{
+	LPCWSTR p = s;
+	if(nPos >= m_nSize) return Fail(nPos);
+	for(int i = 0; i < s.GetLength(); i++) {
+		if(m_pInput[nPos] == p[i]) return Fail(nPos);
+	}
+	nPos++;
+	return true;
+}
+
+bool CInterpreter::ParseTRGE(int& nPos, WCHAR c1, WCHAR c2)
+{
+	if(nPos >= m_nSize || m_pInput[nPos] < c1 || m_pInput[nPos] > c2) return Fail(nPos);
+	nPos++;
+	return true;
+}
+
+void CInterpreter::InterpretCode(const CStringW& sCode, const TIcbArray<int>& anPos, const TIcbArray< TIcbArray<TCHAR> >& aacOutputs, TIcbArray<TCHAR>& acOutput)
+{
+	// the code has been checked by Check()
+	LPCWSTR p = sCode;
+	int		n = sCode.GetLength();
+	for(int i = 0; i < n; i++) {
+		if(p[i] != '$') {
+			acOutput.Add((TCHAR) p[i]);
+		} else if(p[i+1] == 'i') {
+			int nSymbol = p[i+2] - '0';
+			acOutput.Add(m_pInput + anPos[nSymbol-1], anPos[nSymbol] - anPos[nSymbol-1]);
+			i += 2;
+		} else if(p[i+1] == '$') {
+			acOutput.Add('$');
+			i++;
+		} else {
+			acOutput.Add(aacOutputs[p[i+1] - '1']);
+			i++;
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Grammar.h"
+
+// The interpreter of RSPT (cs/RSPT/Interpreter.cs, -par=txt) in C++. It parses the input with the rules
+// of the grammar as they are written, without any of the transformations of the code generators
+// (inlining, scanners, keyword tries, memos, ...), so it serves as the reference the generated
+// parsers are compared to. The actions are output templates: $iN is the input matched by the Nth
+// symbol, $N the output of the Nth NTS and $$ a '$'.
+//
+// To be comparable to the C++ parsers generated with <option:append>, it differs from Interpreter.cs
+// in three places: <notset> is supported, operator tables are parsed like the precedence climbing loop
+// of the C++ generator and a failed parse returns the farthest position at which a TS failed.
+// The actions of NTS with a type are source code, they are skipped: such NTS are only recognized.
+class CInterpreter
+{
+public:
+	CInterpreter(const CGrammar& grammar);
+
+	// Returns false and sets sError if the grammar uses something the interpreter cannot parse:
+	// invalid output templates or operator tables.
+	bool Check(CString& sError) const;
+
+	// Parses the input with the given NTS, like Parse_X() of the generated parsers. pos receives the end
+	// of the input if the parse succeeded, the farthest failure otherwise. The output is empty if the NTS
+	// has a type.
+	bool Parse(int nNonTerm, const TCHAR* input, int size, CString& output, int& pos);
+
+private:
+	const CGrammar& m_grammar;
+	const TCHAR*	m_pInput;
+	int				m_nSize;
+	int				m_nFail; ///< The farthest position at which a TS failed.
+
+	bool ParseNT(int nNonTerm, int& nPos, TIcbArray<TCHAR>& acOutput);
+	bool ParseOperators(int nNonTerm, int nPrec, int& nPos);
+	bool ParseSymbols(const CRule& rule, int nStart, int nEnd, bool bOutput, int& nPos, TIcbArray<TCHAR>& acOutput);
+	bool ParseTS(int& nPos, const CStringW& s);
+	bool ParseTSET(int& nPos, const CStringW& s);
+	bool ParseTNOTSET(int& nPos, const CStringW& s);
+	bool ParseTRGE(int& nPos, WCHAR c1, WCHAR c2);
+	void InterpretCode(const CStringW& sCode, const TIcbArray<int>& anPos, const TIcbArray< TIcbArray<TCHAR> >& aacOutputs, TIcbArray<TCHAR>& acOutput);
+
+	inline bool Fail(int nPos)
+	{
+		if(nPos > m_nFail) {
+			m_nFail = nPos;
+		}
+		return false;
+	}
+};
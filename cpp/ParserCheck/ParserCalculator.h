@@ -0,0 +1,873 @@
+//
+// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).
+//       Do not modify the contents of this file as it will be overwritten!
+//
+#pragma once;
+#include <Math.h>
+
+namespace Parsers {
+
+class CCalculatorParser
+{
+private:
+    const TCHAR* _input;
+    int _size;
+
+    CIcbArena  _arena;     // the arena of the values allocated by Str() and New(), reset by each Parse_X
+    CIcbArena* _arena_set; // the arena used instead, if set by SetArena()
+
+    int            _fail_pos; // the farthest position at which a TS failed
+    TIcbArray<int> _fail_at;  // the last position at which each TS failed, the TS expected at _fail_pos failed there
+
+    enum { BUDGET_CHECK = 1024 }; // the number of steps between two calls of Budget()
+
+    int   _budget_steps; // the number of nt_ calls allowed per parse (0 for no limit)
+    DWORD _budget_ms;    // the time allowed per parse in milliseconds (0 for no limit)
+    int   _steps;        // the steps until Budget() is called again
+    int   _steps_left;   // the steps left after those (-1 for no limit)
+    DWORD _deadline;     // GetTickCount() at which the parse is abandoned
+    bool  _exceeded;     // the budget of the last parse was exceeded
+
+public:
+    CCalculatorParser() : _input(NULL), _size(0), _arena_set(NULL), _fail_pos(0) { SetBudget(0, 0); }
+
+    bool Parse_ROOT(const TCHAR* input, int size, CString& output, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        ResetBudget();
+        Arena().Reset();
+        _memo_IDENT_pos = -1;
+        TLazy<CString> lazy; // nt_ROOT constructs its output only if it succeeds
+        CString& out = *lazy;
+        bool ok = nt_ROOT(pos, out);
+        if(ok) {
+            output = out;
+            IcbDestruct(&out, 1);
+        }
+        return (ok && pos == _size && !_exceeded) || Error(pos, ok);
+    }
+
+    bool Parse_EXPRESSION(const TCHAR* input, int size, double& output, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        ResetBudget();
+        Arena().Reset();
+        _memo_IDENT_pos = -1;
+        /*output = default(double);*/
+        bool ok = nt_EXPRESSION(pos, output);
+        return (ok && pos == _size && !_exceeded) || Error(pos, ok);
+    }
+
+    bool Validate_ROOT(const TCHAR* input, int size, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        ResetBudget();
+        bool ok = vnt_ROOT(pos);
+        return (ok && pos == _size && !_exceeded) || Error(pos, ok);
+    }
+
+    bool Validate_EXPRESSION(const TCHAR* input, int size, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        ResetBudget();
+        bool ok = vnt_EXPRESSION(pos);
+        return (ok && pos == _size && !_exceeded) || Error(pos, ok);
+    }
+
+    // Returns the position at which the last parse failed, the same as pos after Parse_X() or Validate_X().
+    int GetFailurePos() const {
+        return _fail_pos;
+    }
+
+    // Returns the TS that were expected at GetFailurePos(), e.g. "'+', '-' or end of input".
+    CString GetExpected() const {
+        TIcbArray<const TCHAR*> names;
+        for(int t = 0; t < _fail_at.GetSize(); t++) {
+            if(_fail_at[t] == _fail_pos) {
+                names.Add(TerminalName(t));
+            }
+        }
+        CString expected;
+        for(int i = 0; i < names.GetSize(); i++) {
+            expected += i == 0 ? _T("") : (i+1 < names.GetSize() ? _T(", ") : _T(" or "));
+            expected += names[i];
+        }
+        return expected;
+    }
+
+    // Limits the following parses to the given number of nt_ calls and milliseconds (0 for no limit).
+    // The time is checked every BUDGET_CHECK calls. If a limit is exceeded, Parse_X() and Validate_X()
+    // return false and IsBudgetExceeded() returns true.
+    void SetBudget(int steps, DWORD ms) {
+        _budget_steps = steps;
+        _budget_ms    = ms;
+        _exceeded     = false;
+    }
+
+    bool IsBudgetExceeded() const {
+        return _exceeded;
+    }
+
+    // Sets the arena used by the following parses (NULL for the arena of the parser), e.g. to keep the values
+    // of a parse while parsing with another parser. The arena is reset at the start of each Parse_X.
+    void SetArena(CIcbArena* arena) {
+        _arena_set = arena;
+    }
+
+    // The arena of the values of the last parse, which are valid until the next Parse_X.
+    CIcbArena& Arena() {
+        return _arena_set != NULL ? *_arena_set : _arena;
+    }
+
+private:
+    bool nt_ROOT(int& pos, CString& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) { // 2 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'A':
+                        if(pos0+5 <= _size && _input[pos0+1] == 'b' && _input[pos0+2] == 'o' && _input[pos0+3] == 'u' && _input[pos0+4] == 't') {
+                            kw = 1;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                    case 'V':
+                        if(pos0+7 <= _size && _input[pos0+1] == 'e' && _input[pos0+2] == 'r' && _input[pos0+3] == 's' && _input[pos0+4] == 'i' && _input[pos0+5] == 'o' && _input[pos0+6] == 'n') {
+                            kw = 2;
+                            pos1 = pos0+7;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 1);
+            }
+            switch(kw) {
+                case 1: {
+                    IcbConstruct(&output, 1);
+                    output = _T("Copyright (C) 2010 Philip Oswald");
+                    pos = pos1;
+                    return true;
+                }
+                case 2: {
+                    IcbConstruct(&output, 1);
+                    output = _T("Version 1.11 for C++/MFC");
+                    pos = pos1;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            double output1 /*= default(double)*/;
+            int pos1 = pos0;
+            if(nt_EXPRESSION_SET(pos1, output1)) {
+                IcbConstruct(&output, 1);
+                output.Format(_T("%f"), output1);
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_EXPRESSION(int& pos, double& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            double output1 /*= default(double)*/;
+            int pos1 = pos0;
+            if(nt_EXPRESSION_SET(pos1, output1)) {
+                output = output1;
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_EXPRESSION_SET(int& pos, double& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            LPCTSTR output1 /*= default(LPCTSTR)*/;
+            int pos1 = pos0;
+            if(nt_IDENT(pos1, output1)) {
+                int pos2 = pos1;
+                if(tc(pos2, '=', 2)) {
+                    double output3 /*= default(double)*/;
+                    int pos3 = pos2;
+                    if(nt_EXPRESSION_SET(pos3, output3)) {
+                        output = output3; _variables.Put(output1, output);
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        if(true) {
+            double output1 /*= default(double)*/;
+            int pos1 = pos0;
+            if(nt_EXPRESSION_OP(pos1, output1)) {
+                output = output1;
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __forceinline bool nt_EXPRESSION_OP(int& pos, double& output) {
+        return op_EXPRESSION_OP(pos, output, 0);
+    }
+
+    bool op_EXPRESSION_OP(int& pos, double& output, int prec) {
+        if(--_steps < 0 && !Budget()) return false;
+        if(!nt_EXPRESSION_BRA(pos, output)) {
+            return false;
+        }
+        while(true) {
+            int pos0 = pos;
+            if(prec <= 1) {
+                int pos1 = pos0;
+                if(tc(pos1, '+', 3)) {
+                    double output2 /*= default(double)*/;
+                    int pos2 = pos1;
+                    if(op_EXPRESSION_OP(pos2, output2, 2)) {
+                        output += output2;
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            if(prec <= 1) {
+                int pos1 = pos0;
+                if(tc(pos1, '-', 4)) {
+                    double output2 /*= default(double)*/;
+                    int pos2 = pos1;
+                    if(op_EXPRESSION_OP(pos2, output2, 2)) {
+                        output -= output2;
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            if(prec <= 2) {
+                int pos1 = pos0;
+                if(tc(pos1, '*', 5)) {
+                    double output2 /*= default(double)*/;
+                    int pos2 = pos1;
+                    if(op_EXPRESSION_OP(pos2, output2, 3)) {
+                        output *= output2;
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            if(prec <= 2) {
+                int pos1 = pos0;
+                if(tc(pos1, '/', 6)) {
+                    double output2 /*= default(double)*/;
+                    int pos2 = pos1;
+                    if(op_EXPRESSION_OP(pos2, output2, 3)) {
+                        output /= output2;
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    __forceinline bool nt_EXPRESSION_BRA(int& pos, double& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '(', 7)) {
+                double output2 /*= default(double)*/;
+                int pos2 = pos1;
+                if(nt_EXPRESSION_SET(pos2, output2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, ')', 8)) {
+                        output = output2;
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        if(true) {
+            double output1 /*= default(double)*/;
+            int pos1 = pos0;
+            if(nt_VALUE(pos1, output1)) {
+                output = output1;
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __forceinline bool nt_VALUE(int& pos, double& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            double output1 /*= default(double)*/;
+            int pos1 = pos0;
+            if(nt_SYMBOL(pos1, output1)) {
+                output = output1;
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            LPCTSTR output1 /*= default(LPCTSTR)*/;
+            int pos1 = pos0;
+            if(nt_CONST(pos1, output1)) {
+                output = _tstof(output1);
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __forceinline bool nt_SYMBOL(int& pos, double& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) { // 2 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'e':
+                        kw = 2;
+                        pos1 = pos0+1;
+                        break;
+                    case 'p':
+                        if(pos0+2 <= _size && _input[pos0+1] == 'i') {
+                            kw = 1;
+                            pos1 = pos0+2;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 9);
+            }
+            switch(kw) {
+                case 1: {
+                    output = 3.14;
+                    pos = pos1;
+                    return true;
+                }
+                case 2: {
+                    output = 2.7;
+                    pos = pos1;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            LPCTSTR output1 /*= default(LPCTSTR)*/;
+            int pos1 = pos0;
+            if(nt_IDENT(pos1, output1)) {
+                _variables.Get(output1, output);
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int _memo_IDENT_pos; // the position, end position (-1 if failed) and output of the last call of nt_IDENT_body
+    int _memo_IDENT_end;
+    LPCTSTR _memo_IDENT_output;
+
+    bool nt_IDENT(int& pos, LPCTSTR& output) {
+        if(pos != _memo_IDENT_pos) {
+            _memo_IDENT_pos = pos;
+            _memo_IDENT_end = pos;
+            if(!nt_IDENT_body(_memo_IDENT_end, _memo_IDENT_output)) {
+                _memo_IDENT_end = -1;
+            }
+        }
+        if(_memo_IDENT_end < 0) {
+            return false;
+        }
+        output = _memo_IDENT_output;
+        pos    = _memo_IDENT_end;
+        return true;
+    }
+
+    bool nt_IDENT_body(int& pos, LPCTSTR& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            void* output1 /*= default(void*)*/;
+            int pos1 = pos0;
+            if(nt_IDENTCHAR_1(pos1, output1)) {
+                void* output2 /*= default(void*)*/;
+                int pos2 = pos1;
+                if(nt_IDENTCHARS_N(pos2, output2)) {
+                    output = Str(pos0, pos2);
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool nt_IDENTCHARS_N(int& pos, void*& /*output*/) { // scanner, 1 state
+        int p   = pos;
+        int end = -1;
+        TCHAR c;
+    s0:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s0; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    __forceinline bool nt_IDENTCHAR_1(int& pos, void*& /*output*/) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        TCHAR c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if((c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+    f0:
+        Fail(p, 10);
+        goto done;
+    s1:
+        end = p;
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    __forceinline bool nt_CONST(int& pos, LPCTSTR& output) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '0', '9', 11)) {
+                void* output2 /*= default(void*)*/;
+                int pos2 = pos1;
+                if(nt_DIGITS(pos2, output2)) {
+                    output = Str(pos0, pos2);
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool nt_DIGITS(int& pos, void*& /*output*/) { // scanner, 1 state
+        int p   = pos;
+        int end = -1;
+        TCHAR c;
+    s0:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s0; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_ROOT(int& pos) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) { // 2 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'A':
+                        if(pos0+5 <= _size && _input[pos0+1] == 'b' && _input[pos0+2] == 'o' && _input[pos0+3] == 'u' && _input[pos0+4] == 't') {
+                            kw = 1;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                    case 'V':
+                        if(pos0+7 <= _size && _input[pos0+1] == 'e' && _input[pos0+2] == 'r' && _input[pos0+3] == 's' && _input[pos0+4] == 'i' && _input[pos0+5] == 'o' && _input[pos0+6] == 'n') {
+                            kw = 2;
+                            pos1 = pos0+7;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 1);
+            }
+            if(kw != 0) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_EXPRESSION_SET(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_EXPRESSION(int& pos) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_EXPRESSION_SET(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_EXPRESSION_SET(int& pos) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_IDENT(pos1)) {
+                int pos2 = pos1;
+                if(tc(pos2, '=', 2)) {
+                    int pos3 = pos2;
+                    if(vnt_EXPRESSION_SET(pos3)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_EXPRESSION_OP(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __forceinline bool vnt_EXPRESSION_OP(int& pos) {
+        return vop_EXPRESSION_OP(pos, 0);
+    }
+
+    bool vop_EXPRESSION_OP(int& pos, int prec) {
+        if(--_steps < 0 && !Budget()) return false;
+        if(!vnt_EXPRESSION_BRA(pos)) {
+            return false;
+        }
+        while(true) {
+            int pos0 = pos;
+            if(prec <= 1) {
+                int pos1 = pos0;
+                if(tc(pos1, '+', 3)) {
+                    int pos2 = pos1;
+                    if(vop_EXPRESSION_OP(pos2, 2)) {
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            if(prec <= 1) {
+                int pos1 = pos0;
+                if(tc(pos1, '-', 4)) {
+                    int pos2 = pos1;
+                    if(vop_EXPRESSION_OP(pos2, 2)) {
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            if(prec <= 2) {
+                int pos1 = pos0;
+                if(tc(pos1, '*', 5)) {
+                    int pos2 = pos1;
+                    if(vop_EXPRESSION_OP(pos2, 3)) {
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            if(prec <= 2) {
+                int pos1 = pos0;
+                if(tc(pos1, '/', 6)) {
+                    int pos2 = pos1;
+                    if(vop_EXPRESSION_OP(pos2, 3)) {
+                        pos = pos2;
+                        continue;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    __forceinline bool vnt_EXPRESSION_BRA(int& pos) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '(', 7)) {
+                int pos2 = pos1;
+                if(vnt_EXPRESSION_SET(pos2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, ')', 8)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_VALUE(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __forceinline bool vnt_VALUE(int& pos) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_SYMBOL(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_CONST(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    __forceinline bool vnt_SYMBOL(int& pos) {
+        if(--_steps < 0 && !Budget()) return false;
+        int pos0 = pos;
+        if(true) { // 2 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'e':
+                        kw = 2;
+                        pos1 = pos0+1;
+                        break;
+                    case 'p':
+                        if(pos0+2 <= _size && _input[pos0+1] == 'i') {
+                            kw = 1;
+                            pos1 = pos0+2;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 9);
+            }
+            if(kw != 0) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_IDENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_IDENT(int& pos) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        TCHAR c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if((c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+    f0:
+        Fail(p, 10);
+        goto done;
+    s1:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    __forceinline bool vnt_CONST(int& pos) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        TCHAR c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s1; }
+    f0:
+        Fail(p, 11);
+        goto done;
+    s1:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s1; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    void ResetFailure() {
+        _fail_pos = 0;
+        _fail_at.SetSize(12);
+        for(int t = 0; t < _fail_at.GetSize(); t++) {
+            _fail_at[t] = -1;
+        }
+    }
+
+    // Records that the TS t failed at pos. Failures before the farthest position are ignored, the others
+    // cost a comparison and two stores, as nothing has to be cleared when the farthest position moves on.
+    bool Fail(int pos, int t) {
+        if(pos >= _fail_pos) {
+            _fail_pos = pos;
+            _fail_at[t] = pos;
+        }
+        return false;
+    }
+
+    // Ends a failed parse: if the exported NTS matched, but not the whole input, the end of the input
+    // was expected. pos is set to the farthest failure.
+    bool Error(int& pos, bool matched) {
+        if(matched && !_exceeded) {
+            Fail(pos, 0);
+        }
+        pos = _fail_pos;
+        return false;
+    }
+
+    static const TCHAR* TerminalName(int t) {
+        static const TCHAR* names[] = {
+            _T("end of input"),
+            _T("\'About\', \'Version\'"),
+            _T("\'=\'"),
+            _T("\'+\'"),
+            _T("\'-\'"),
+            _T("\'*\'"),
+            _T("\'/\'"),
+            _T("\'(\'"),
+            _T("\')\'"),
+            _T("\'pi\', \'e\'"),
+            _T("\'A\'-\'Z\', \'_\', \'a\'-\'z\'"),
+            _T("\'0\'-\'9\'"),
+        };
+        return names[t];
+    }
+
+    bool tc(int& pos, TCHAR c, int t) {
+        if(pos >= _size || _input[pos] != c) return Fail(pos, t);
+        pos++;
+        return true;
+    }
+
+    bool trange(int& pos, TCHAR c1, TCHAR c2, int t) {
+        if(pos >= _size || _input[pos] < c1 || _input[pos] > c2) return Fail(pos, t);
+        pos++;
+        return true;
+    }
+
+    // The storage for the output of a NTS that is constructed by nt_X only if it succeeds, so a failed call
+    // costs no construction and destruction. The caller destroys the output after a successful call.
+    template <class T> union TLazy {
+        char    data[sizeof(T)];
+        double  align1; // aligns the storage like T
+        void*   align2;
+        __int64 align3;
+
+        T& operator*() {
+            return *(T*) data;
+        }
+    };
+
+    // Returns a copy of _input[begin, end) in the arena, terminated by a 0.
+    const TCHAR* Str(int begin, int end) {
+        return Arena().AllocString(_input+begin, end-begin);
+    }
+
+    // Returns a default constructed value in the arena, its destructor is never called.
+    template <class T> T* New() {
+        return Arena().AllocArray<T>(1);
+    }
+
+    void ResetBudget() {
+        _steps      = 0;
+        _steps_left = _budget_steps > 0 ? _budget_steps : -1;
+        _deadline   = GetTickCount() + _budget_ms;
+        _exceeded   = false;
+    }
+
+    // Called when _steps is used up: returns false if the budget is exceeded, otherwise grants the next steps.
+    bool Budget() {
+        if(_exceeded || _steps_left == 0 || (_budget_ms > 0 && (int) (GetTickCount() - _deadline) >= 0)) {
+            _exceeded = true;
+            _steps    = 0;
+            return false;
+        }
+        _steps = BUDGET_CHECK;
+        if(_steps_left >= 0) {
+            _steps       = _steps_left < BUDGET_CHECK ? _steps_left : BUDGET_CHECK;
+            _steps_left -= _steps;
+        }
+        _steps--; // the step of the caller
+        return true;
+    }
+
+    class CVariables : public TIcbHashtable<CString,double> { public: CVariables() { SetSlabSize(16); } };
+    CVariables _variables;
+    public: void ResetVariables() { _variables.Reset(); }
+};
+}
@@ -0,0 +1,914 @@
+#include "stdafx.h"
+#include "Grammar.h"
+#include "Interpreter.h"
+#include "Parser.h"
+#include "ParserCalculator.h"
+namespace Utf8 { // the class of Parser.h once more
+#include "ParserUtf8.h"
+}
+namespace SyncEvents { // the same grammar for events and for a tree
+#include "ParserSyncEvents.h"
+}
+namespace SyncTree {
+#include "ParserSyncTree.h"
+}
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+// The largest character the input generator produces.
+static const int s_nMaxChar = sizeof(TCHAR) == 1 ? 0x7F : 0xFFFF;
+
+// Returns the input encoded as UTF-8. anChars receives the character offset of every byte and of the end,
+// or -1 for the bytes after the first one of a character.
+static CStringA EncodeUtf8(const CString& s, TIcbArray<int>& anChars)
+{
+	TIcbArray<char> acBytes(s.GetLength());
+	LPCTSTR			p = s;
+	anChars.SetSize(0);
+	for(int i = 0; i < s.GetLength(); i++) {
+		unsigned c = (unsigned) p[i] & s_nMaxChar;
+		if(c < 0x80) {
+			acBytes.Add((char) c);
+		} else if(c < 0x800) {
+			acBytes.Add((char) (0xC0 | (c >> 6)));
+			acBytes.Add((char) (0x80 | (c & 0x3F)));
+		} else {
+			acBytes.Add((char) (0xE0 | (c >> 12)));
+			acBytes.Add((char) (0x80 | ((c >> 6) & 0x3F)));
+			acBytes.Add((char) (0x80 | (c & 0x3F)));
+		}
+		anChars.Add(i);
+		while(anChars.GetSize() < acBytes.GetSize()) {
+			anChars.Add(-1);
+		}
+	}
+	anChars.Add(s.GetLength());
+	return CStringA(acBytes.GetData(), acBytes.GetSize());
+}
+
+// Returns the UTF-8 output of a parser as TCHAR. It is made of the input and ASCII, so it is valid UTF-8
+// of at most three bytes per character.
+static CString DecodeUtf8(const CStringA& s)
+{
+	TIcbArray<TCHAR>	 acChars(s.GetLength());
+	const unsigned char* p = (const unsigned char*) (LPCSTR) s;
+	for(int i = 0; i < s.GetLength(); ) {
+		unsigned c		 = p[i++];
+		int		 nFollow = c < 0xC0 ? 0 : c < 0xE0 ? 1 : 2;
+		if(nFollow > 0) {
+			c &= 0x3F >> nFollow;
+		}
+		for(; nFollow > 0 && i < s.GetLength(); nFollow--) {
+			c = (c << 6) | (p[i++] & 0x3F);
+		}
+		acChars.Add((TCHAR) c);
+	}
+	return CString(acChars.GetData(), acChars.GetSize());
+}
+
+// A generated parser under test. The inputs are handed over once, so that a parser for another input type
+// converts them before the comparison and the timing.
+class CCheckedParser
+{
+public:
+	virtual ~CCheckedParser() { }
+
+	virtual void SetInputs(const TIcbArray<CString>& asInputs) = 0;
+
+	// Parse_ROOT() and Validate_ROOT() with the input nInput. pos is a character offset into the input.
+	virtual bool Parse(int nInput, CString& output, int& pos) = 0;
+	virtual bool Validate(int nInput, int& pos) = 0;
+
+	// Parse_ROOT() (or Validate_ROOT() if bValidate) with a budget of nSteps nt_ calls, for the parsers with
+	// <option:budget>. Returns false if the parser has no budget, else whether it accepted the input and whether
+	// the budget was exceeded.
+	virtual bool ParseWithBudget(int nInput, int nSteps, bool bValidate, bool& bAccepted, bool& bExceeded) { return false; }
+
+	// Parse_ROOT() (or Validate_ROOT() if bValidate) of sInput on nThreads threads, for the parsers with
+	// <sync:'xxx'>. Returns false if the parser has no threads, else whether it accepted the input, the position
+	// and a digest of its events or nodes (0 for Validate_ROOT()).
+	virtual bool ParseOnThreads(const CString& sInput, int nThreads, bool bValidate, bool& bAccepted, int& pos, DWORD& nDigest) { return false; }
+};
+
+// A parser for TCHAR, which parses the inputs as they are.
+template <class TParser>
+class TCheckedParser : public CCheckedParser
+{
+protected:
+	TParser						m_parser;
+	const TIcbArray<CString>*	m_pasInputs;
+
+public:
+	TCheckedParser() : m_pasInputs(NULL) { }
+
+	virtual void SetInputs(const TIcbArray<CString>& asInputs)
+	{
+		m_pasInputs = &asInputs;
+	}
+
+	virtual bool Parse(int nInput, CString& output, int& pos)
+	{
+		const CString& input = (*m_pasInputs)[nInput];
+		return m_parser.Parse_ROOT(input, input.GetLength(), output, pos);
+	}
+
+	virtual bool Validate(int nInput, int& pos)
+	{
+		const CString& input = (*m_pasInputs)[nInput];
+		return m_parser.Validate_ROOT(input, input.GetLength(), pos);
+	}
+};
+
+// A parser for TCHAR with <option:budget>.
+template <class TParser>
+class TBudgetCheckedParser : public TCheckedParser<TParser>
+{
+public:
+	virtual bool ParseWithBudget(int nInput, int nSteps, bool bValidate, bool& bAccepted, bool& bExceeded)
+	{
+		CString output;
+		int		pos;
+		this->m_parser.SetBudget(nSteps, 0);
+		bAccepted = bValidate ? this->Validate(nInput, pos) : this->Parse(nInput, output, pos);
+		bExceeded = this->m_parser.IsBudgetExceeded();
+		this->m_parser.SetBudget(0, 0);
+		return true;
+	}
+};
+
+// The parser for UTF-8, which parses the inputs encoded as UTF-8. Its byte offsets are converted into character
+// offsets, an offset within a character becomes -1 (which the interpreter never returns).
+class CUtf8CheckedParser : public CCheckedParser
+{
+private:
+	Utf8::CSyntaxHighlightParser m_parser;
+	TIcbArray<CStringA>			 m_asInputs;
+	TIcbArray< TIcbArray<int> >	 m_aanChars; ///< See EncodeUtf8().
+
+	int ToChars(int nInput, int pos) const
+	{
+		return pos >= 0 && pos < m_aanChars[nInput].GetSize() ? m_aanChars[nInput][pos] : -1;
+	}
+
+public:
+	virtual void SetInputs(const TIcbArray<CString>& asInputs)
+	{
+		m_asInputs.SetSize(asInputs.GetSize());
+		m_aanChars.SetSize(asInputs.GetSize());
+		for(int i = 0; i < asInputs.GetSize(); i++) {
+			m_asInputs[i] = EncodeUtf8(asInputs[i], m_aanChars[i]);
+		}
+	}
+
+	virtual bool Parse(int nInput, CString& output, int& pos)
+	{
+		CStringA sOutput;
+		bool	 ok = m_parser.Parse_ROOT(m_asInputs[nInput], m_asInputs[nInput].GetLength(), sOutput, pos);
+		output = DecodeUtf8(sOutput);
+		pos	   = ToChars(nInput, pos);
+		return ok;
+	}
+
+	virtual bool Validate(int nInput, int& pos)
+	{
+		bool ok = m_parser.Validate_ROOT(m_asInputs[nInput], m_asInputs[nInput].GetLength(), pos);
+		pos = ToChars(nInput, pos);
+		return ok;
+	}
+};
+
+// A handler that digests the events of a parse.
+template <class TBase>
+struct TDigestHandler : public TBase
+{
+	enum { Events = true };
+
+	DWORD m_nDigest;
+
+	TDigestHandler() : m_nDigest(0) { }
+
+	void Enter(int rule, int pos)			 { Digest(0, rule, pos, 0); }
+	void Exit(int rule, int begin, int end)	 { Digest(1, rule, begin, end); }
+	void Token(int rule, int begin, int end) { Digest(2, rule, begin, end); }
+
+	void Digest(int nEvent, int nRule, int nBegin, int nEnd)
+	{
+		m_nDigest = (((m_nDigest * 31 + nEvent) * 31 + nRule) * 31 + nBegin) * 31 + nEnd;
+	}
+};
+
+// A parser with <sync:'xxx'>, generated with <option:events> or <option:tree>. It has no output, so the
+// parse on several threads is compared to the parse on one by the digest of its events or its tree.
+template <class TParser>
+class TSyncCheckedParser : public CCheckedParser
+{
+protected:
+	TParser						m_parser;
+	const TIcbArray<CString>*	m_pasInputs;
+
+	virtual bool ParseDigest(const CString& sInput, int& pos, DWORD& nDigest) = 0;
+
+public:
+	TSyncCheckedParser() : m_pasInputs(NULL) { }
+
+	virtual void SetInputs(const TIcbArray<CString>& asInputs)
+	{
+		m_pasInputs = &asInputs;
+	}
+
+	virtual bool Parse(int nInput, CString& output, int& pos)
+	{
+		DWORD nDigest;
+		output.Empty();
+		return ParseDigest((*m_pasInputs)[nInput], pos, nDigest);
+	}
+
+	virtual bool Validate(int nInput, int& pos)
+	{
+		const CString& input = (*m_pasInputs)[nInput];
+		return m_parser.Validate_ROOT(input, input.GetLength(), pos);
+	}
+
+	virtual bool ParseOnThreads(const CString& sInput, int nThreads, bool bValidate, bool& bAccepted, int& pos, DWORD& nDigest)
+	{
+		m_parser.SetThreads(nThreads);
+		nDigest	  = 0;
+		bAccepted = bValidate ? m_parser.Validate_ROOT(sInput, sInput.GetLength(), pos) : ParseDigest(sInput, pos, nDigest);
+		m_parser.SetThreads(1);
+		return true;
+	}
+};
+
+template <class THandler>
+class TSyncEventsCheckedParser : public TSyncCheckedParser< SyncEvents::CSyncLinesParser<THandler> >
+{
+protected:
+	virtual bool ParseDigest(const CString& sInput, int& pos, DWORD& nDigest)
+	{
+		THandler handler;
+		bool	 ok = this->m_parser.Parse_ROOT(sInput, sInput.GetLength(), handler, pos);
+		nDigest = handler.m_nDigest;
+		return ok;
+	}
+};
+
+class CSyncTreeCheckedParser : public TSyncCheckedParser<SyncTree::CSyncLinesParser>
+{
+protected:
+	virtual bool ParseDigest(const CString& sInput, int& pos, DWORD& nDigest)
+	{
+		bool ok = m_parser.Parse_ROOT(sInput, sInput.GetLength(), pos);
+		nDigest = 0;
+		for(int i = 0; ok && i < m_parser.GetTree().GetSize(); i++) {
+			const SyncTree::CSyncLinesParser::SNode& n = m_parser.GetTree()[i];
+			nDigest = ((((nDigest * 31 + n.rule) * 31 + n.begin) * 31 + n.end) * 31 + n.child) * 31 + n.next;
+		}
+		return ok;
+	}
+};
+
+template <class TChecked>
+static CCheckedParser* CreateParser()
+{
+	return new TChecked();
+}
+
+struct SParserUnderTest
+{
+	LPCTSTR			pszName;	///< The header file of the parser.
+	LPCTSTR			pszGrammar; ///< The name of the grammar file it is generated from.
+	LPCTSTR			pszOptions; ///< What it is generated with, for the report.
+	CCheckedParser* (*pfnCreate)();
+};
+
+// The generated parsers under test. Parser.h uses <option:append> and <option:scanner> of its grammar, so
+// the outputs of the output templates are compared, and it has a keyword trie and left-factored alternatives.
+// ParserUtf8.h is the same for UTF-8 input. ParserCalculator.h has <option:inline>, <option:scanner> and
+// <option:arena> of its grammar, an operator table, a <memo> rule, a keyword trie, outputs that are only
+// constructed on success, alternatives reordered by CalculatorProfile.txt and a budget, which each accepted input
+// is parsed with again until it is enough. Its actions are source code, which the interpreter skips, so only the
+// acceptance and the offsets of failures are compared. ParserSyncEvents.h and ParserSyncTree.h have a rule with
+// <sync:'xxx'>, which is searched on several threads in large inputs (see CheckThreads()). After a change of the
+// generator, they are generated again in this directory with:
+//   RSPT.exe -gen=cpp ..\..\grammar\SyntaxHighlightCPP.txt Parser.h
+//   RSPT.exe -opt=utf8 -gen=cpp ..\..\grammar\SyntaxHighlightCPP.txt ParserUtf8.h
+//   RSPT.exe -opt=budget -prof=CalculatorProfile.txt -gen=cpp ..\..\grammar\CalculatorCPP.txt ParserCalculator.h
+//   RSPT.exe -opt=events -gen=cpp ..\..\grammar\Tests\SyncLinesCPP.txt ParserSyncEvents.h
+//   RSPT.exe -opt=tree -gen=cpp ..\..\grammar\Tests\SyncLinesCPP.txt ParserSyncTree.h
+static const SParserUnderTest s_aParsers[] = {
+	{ _T("Parser.h"),			_T("SyntaxHighlightCPP.txt"), _T("append, scanner"),						&CreateParser< TCheckedParser<CSyntaxHighlightParser> > },
+	{ _T("ParserUtf8.h"),		_T("SyntaxHighlightCPP.txt"), _T("append, scanner, utf8"),					&CreateParser<CUtf8CheckedParser> },
+	{ _T("ParserCalculator.h"), _T("CalculatorCPP.txt"),	  _T("inline, scanner, arena, budget, -prof"), &CreateParser< TBudgetCheckedParser<Parsers::CCalculatorParser> > },
+	{ _T("ParserSyncEvents.h"), _T("SyncLinesCPP.txt"),		  _T("events, sync"),							&CreateParser< TSyncEventsCheckedParser< TDigestHandler<SyncEvents::CSyncLinesParserHandler> > > },
+	{ _T("ParserSyncTree.h"),	_T("SyncLinesCPP.txt"),		  _T("tree, sync"),								&CreateParser<CSyncTreeCheckedParser> },
+};
+
+// A linear congruential generator, like the one of the benchmark, so that a seed gives the same inputs everywhere.
+class CCheckRandom
+{
+private:
+	unsigned m_nState;
+
+public:
+	CCheckRandom(unsigned nSeed) : m_nState(nSeed) { }
+
+	int Next(int nRange)
+	{
+		m_nState = m_nState * 1103515245 + 12345;
+		int n = (m_nState >> 16) & 0x7FFF;
+		if(nRange > 0x8000) {
+			m_nState = m_nState * 1103515245 + 12345;
+			n = (n << 15) | ((m_nState >> 16) & 0x7FFF);
+		}
+		return n % nRange;
+	}
+};
+
+// Generates inputs from the rules of the grammar: a random alternative for every NTS, down to the given
+// depth. The alternatives that recurse are preferred, as otherwise most inputs would be a few characters
+// short. Below the depth, the alternatives that end the recursion soonest are taken. An operator table
+// gives an operand, followed by operators and operands. Characters of <set>, <range> and <notset> are drawn
+// at random, so many of the inputs are not in the language (the rules are ordered choices), which is as
+// interesting for the comparison as those that are.
+class CInputGenerator
+{
+private:
+	const CGrammar&	m_grammar;
+	CCheckRandom&	m_random;
+	int				m_nDepth;
+	int				m_nLength;	   ///< The length at which the generator ends the recursion like at the depth limit.
+	TIcbArray<int>	m_anMinDepth;  ///< The least depth of the derivations of every NTS.
+	TIcbArray<int>	m_anChars;	   ///< The characters that appear in the grammar and their neighbours, for the mutations.
+
+	int GetMinDepth(const CRule& rule) const
+	{
+		int nDepth = 1;
+		for(int i = 0; i < rule.GetSize(); i++) {
+			if(rule[i].m_eType == SYMBOL_NONTERM && m_anMinDepth[rule[i].m_nNonTerm] + 1 > nDepth) {
+				nDepth = m_anMinDepth[rule[i].m_nNonTerm] + 1;
+			}
+		}
+		return nDepth;
+	}
+
+	void AddChar(int c)
+	{
+		if(c > 0 && c <= s_nMaxChar && !m_anChars.Contains(c)) {
+			m_anChars.Add(c);
+		}
+	}
+
+	TCHAR RandomRange(int c1, int c2)
+	{
+		if(c2 > s_nMaxChar) {
+			c2 = s_nMaxChar;
+		}
+		if(c2 < c1) {
+			return (TCHAR) c1;
+		}
+		switch(m_random.Next(4)) { // the bounds of the range are hit more often than the rest
+			case 0:	 return (TCHAR) c1;
+			case 1:	 return (TCHAR) c2;
+			default: return (TCHAR) (c1 + m_random.Next(c2 - c1 + 1));
+		}
+	}
+
+	void Generate(int nNonTerm, int nDepth, TIcbArray<TCHAR>& acInput)
+	{
+		const SNonTerm& nt = m_grammar.m_aNonTerms[nNonTerm];
+		int nRules = nt.m_aRules.GetSize();
+		int nRule  = m_random.Next(nRules);
+		bool bEnd  = nDepth >= m_nDepth || acInput.GetSize() >= m_nLength;
+		if(nt.m_nOperand >= 0) {
+			// the operand, then an operator and its right operand (the table itself) or nothing
+			Generate(nt.m_nOperand, nDepth+1, acInput);
+			if(!bEnd && m_random.Next(2) == 0) {
+				Generate(nt.m_aRules[nRule], nDepth, acInput);
+			}
+			return;
+		}
+		if(bEnd || m_random.Next(4) > 0) {
+			// the alternative that ends soonest (the first one of them), or a random one of those that go deeper
+			int nShortest = 0;
+			for(int i = 1; i < nRules; i++) {
+				if(GetMinDepth(nt.m_aRules[i]) < GetMinDepth(nt.m_aRules[nShortest])) {
+					nShortest = i;
+				}
+			}
+			if(bEnd) {
+				nRule = nShortest;
+			} else {
+				for(int i = 0; i < nRules && GetMinDepth(nt.m_aRules[nRule]) <= GetMinDepth(nt.m_aRules[nShortest]); i++) {
+					nRule = (nRule + 1) % nRules;
+				}
+			}
+		}
+
+		Generate(nt.m_aRules[nRule], nDepth, acInput);
+	}
+
+	void Generate(const CRule& rule, int nDepth, TIcbArray<TCHAR>& acInput)
+	{
+		EInstruction eInstr = INSTR_NONE;
+		for(int i = 0; i < rule.GetSize(); i++) {
+			const SSymbol& sym = rule[i];
+			LPCWSTR		   p   = sym.m_sText;
+			int			   n   = sym.m_sText.GetLength();
+			if(sym.m_eType == SYMBOL_NONTERM) {
+				Generate(sym.m_nNonTerm, nDepth+1, acInput);
+			} else if(sym.m_eType == SYMBOL_TERM) {
+				if(eInstr == INSTR_SET && n > 0) {
+					acInput.Add((TCHAR) p[m_random.Next(n)]);
+				} else if(eInstr == INSTR_RANGE && n >= 2) {
+					acInput.Add(RandomRange(p[0], p[1]));
+				} else if(eInstr == INSTR_NOTSET) {
+					TCHAR c = RandomRange(' ', '~');
+					for(int nTries = 0; nTries < 100 && n > 0 && wcschr(p, c) != NULL; nTries++) {
+						c = RandomRange(' ', '~');
+					}
+					acInput.Add(c);
+				} else {
+					for(int j = 0; j < n; j++) {
+						acInput.Add((TCHAR) p[j]);
+					}
+				}
+			}
+			eInstr = sym.m_eType == SYMBOL_INSTR ? sym.m_eInstr : INSTR_NONE;
+		}
+	}
+
+public:
+	CInputGenerator(const CGrammar& grammar, CCheckRandom& random, int nDepth, int nLength)
+		: m_grammar(grammar), m_random(random), m_nDepth(nDepth), m_nLength(nLength)
+	{
+		// the least depths are found by iterating to the fixpoint, NTS without a finite derivation keep INT_MAX/2
+		int nNonTerms = grammar.m_aNonTerms.GetSize();
+		m_anMinDepth.SetSize(nNonTerms);
+		for(int i = 0; i < nNonTerms; i++) {
+			m_anMinDepth[i] = INT_MAX/2;
+		}
+		for(bool bChanged = true; bChanged; ) {
+			bChanged = false;
+			for(int i = 0; i < nNonTerms; i++) {
+				const SNonTerm& nt = grammar.m_aNonTerms[i];
+				if(nt.m_nOperand >= 0 && m_anMinDepth[nt.m_nOperand] + 1 < m_anMinDepth[i]) {
+					m_anMinDepth[i] = m_anMinDepth[nt.m_nOperand] + 1; // the operand alone
+					bChanged		= true;
+				}
+				for(int j = 0; j < nt.m_aRules.GetSize() && nt.m_nOperand < 0; j++) {
+					int nDepth = GetMinDepth(nt.m_aRules[j]);
+					if(nDepth < m_anMinDepth[i]) {
+						m_anMinDepth[i] = nDepth;
+						bChanged		= true;
+					}
+				}
+			}
+		}
+
+		// the characters for the mutations: those of the TS, just outside the ranges, controls and beyond ASCII
+		for(int i = 0; i < nNonTerms; i++) {
+			const SNonTerm& nt = grammar.m_aNonTerms[i];
+			for(int j = 0; j < nt.m_aRules.GetSize(); j++) {
+				const CRule& rule = nt.m_aRules[j];
+				for(int k = 0; k < rule.GetSize(); k++) {
+					LPCWSTR p = rule[k].m_sText;
+					if(rule[k].m_eType != SYMBOL_TERM) {
+						continue;
+					}
+					for(int c = 0; c < rule[k].m_sText.GetLength(); c++) {
+						AddChar(p[c] - 1);
+						AddChar(p[c]);
+						AddChar(p[c] + 1);
+					}
+				}
+			}
+		}
+		static const int anSpecial[] = { 0x01, 0x1F, 0x7F, 0x80, 0xE9, 0xFF, 0x100, 0x263A, 0xFFFD };
+		for(int i = 0; i < (int) (sizeof(anSpecial) / sizeof(anSpecial[0])); i++) {
+			AddChar(anSpecial[i]);
+		}
+	}
+
+	// Returns whether every NTS has a finite derivation, i.e. inputs can be generated.
+	bool IsFinite() const
+	{
+		for(int i = 0; i < m_anMinDepth.GetSize(); i++) {
+			if(m_anMinDepth[i] >= INT_MAX/2) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Generates an input for the given NTS.
+	CString Generate(int nNonTerm)
+	{
+		TIcbArray<TCHAR> acInput;
+		Generate(nNonTerm, 0, acInput);
+		return CString(acInput.GetData(), acInput.GetSize());
+	}
+
+	// Changes the input at random: deletes, inserts, replaces or duplicates characters or cuts it off.
+	CString Mutate(const CString& sInput)
+	{
+		TIcbArray<TCHAR> acInput;
+		acInput.Add((LPCTSTR) sInput, sInput.GetLength());
+		for(int nMutations = 1 + m_random.Next(3); nMutations > 0; nMutations--) {
+			int n	 = acInput.GetSize();
+			int nPos = m_random.Next(n + 1);
+			int nLen = 1 + m_random.Next(8);
+			if(nPos + nLen > n) {
+				nLen = n - nPos;
+			}
+			TCHAR c = (TCHAR) m_anChars[m_random.Next(m_anChars.GetSize())];
+			switch(m_random.Next(5)) {
+				case 0: // delete
+					acInput.RemoveAt(nPos, nLen);
+					break;
+				case 1: // insert
+					acInput.InsertAt(nPos, c);
+					break;
+				case 2: // replace
+					if(nPos < n) {
+						acInput[nPos] = c;
+					}
+					break;
+				case 3: // duplicate
+					acInput.InsertAt(nPos, acInput.GetSubArray(nPos, nLen));
+					break;
+				default: // cut off
+					acInput.SetSize(nPos);
+					break;
+			}
+		}
+		return CString(acInput.GetData(), acInput.GetSize());
+	}
+};
+
+// Returns the input with the characters that cannot be printed escaped, cut off after nMax characters.
+static CString Escape(const CString& s, int nMax = 120)
+{
+	CString sEscaped;
+	LPCTSTR p = s;
+	for(int i = 0; i < s.GetLength() && i < nMax; i++) {
+		int c = (int) p[i] & s_nMaxChar;
+		if(c >= ' ' && c <= '~' && c != '\\') {
+			sEscaped += p[i];
+		} else {
+			CString sChar;
+			sChar.Format(c <= 0xFF ? _T("\\x%02X") : _T("\\u%04X"), c);
+			sEscaped += sChar;
+		}
+	}
+	if(s.GetLength() > nMax) {
+		sEscaped += _T("...");
+	}
+	return sEscaped;
+}
+
+// Parses an accepted input with budgets of 1, 2, 3, ... nt_ calls until it is enough, if the parser has a budget.
+// Returns false and sets sDiff if Parse_ROOT() or Validate_ROOT() accepted the input although the budget was
+// exceeded (e.g. a repetition that stops where its NTS ran out of budget), or rejected it within the budget.
+static bool CheckBudget(CCheckedParser& parser, int nInput, CString& sDiff)
+{
+	for(int nMode = 0; nMode < 2; nMode++) {
+		bool bAccepted, bExceeded = true;
+		for(int nSteps = 1; bExceeded && parser.ParseWithBudget(nInput, nSteps, nMode == 1, bAccepted, bExceeded); nSteps++) {
+			if(bAccepted == bExceeded) {
+				sDiff.Format(_T("%s with a budget of %i steps: accepted %i, exceeded %i"), nMode == 1 ? _T("Validate") : _T("Parse"),
+					nSteps, bAccepted, bExceeded);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Parses the input with the interpreter and with the generated parser (Parse and Validate). Returns false and
+// prints the difference if they do not agree on the acceptance, the output or the position of the failure, or
+// if the parser does not keep its budget (see CheckBudget()).
+// The outputs are only compared if bOutputs is set, i.e. if the actions of the NTS are output templates.
+static bool Compare(CInterpreter& interpreter, int nRoot, CCheckedParser& parser, const TIcbArray<CString>& asInputs, int nInput,
+					bool bOutputs, bool bOffsets, bool& bAccepted)
+{
+	const CString& sInput = asInputs[nInput];
+	CString		   sOutput1, sOutput2;
+	int			   nPos1 = 0, nPos2 = 0, nPos3 = 0;
+	bool		   bOk1	 = interpreter.Parse(nRoot, sInput, sInput.GetLength(), sOutput1, nPos1);
+	bool		   bOk2	 = parser.Parse(nInput, sOutput2, nPos2);
+	bool		   bOk3	 = parser.Validate(nInput, nPos3);
+	bAccepted = bOk1;
+
+	CString sDiff;
+	if(bOk1 != bOk2 || bOk1 != bOk3) {
+		sDiff.Format(_T("accepted: interpreter %i, Parse %i, Validate %i"), bOk1, bOk2, bOk3);
+	} else if(bOk1 && bOutputs && !(sOutput1 == sOutput2)) {
+		int		nDiff = 0; // the outputs are shown from the first difference on
+		LPCTSTR p1	  = sOutput1;
+		LPCTSTR p2	  = sOutput2;
+		while(p1[nDiff] != 0 && p1[nDiff] == p2[nDiff]) {
+			nDiff++;
+		}
+		sDiff.Format(_T("output at offset %i: interpreter '%s', Parse '%s'"), nDiff+1,
+			(LPCTSTR) Escape(sOutput1.Mid(nDiff)), (LPCTSTR) Escape(sOutput2.Mid(nDiff)));
+	} else if(!bOk1 && bOffsets && (nPos1 != nPos2 || nPos1 != nPos3)) {
+		sDiff.Format(_T("error offset: interpreter %i, Parse %i, Validate %i"), nPos1+1, nPos2+1, nPos3+1);
+	} else if(bOk1 && !CheckBudget(parser, nInput, sDiff)) {
+	} else {
+		return true;
+	}
+	_tprintf(_T("Mismatch: input '%s' (%i characters)\n          %s\n"), (LPCTSTR) Escape(sInput), sInput.GetLength(), (LPCTSTR) sDiff);
+	return false;
+}
+
+// Parses all inputs nIterations times, returns the elapsed ticks. nMode: 0 interpreter, 1 Parse, 2 Validate.
+static LONGLONG TimeInputs(CInterpreter& interpreter, int nRoot, CCheckedParser& parser, const TIcbArray<CString>& asInputs, int nMode, int nIterations)
+{
+	LARGE_INTEGER nStart, nStop;
+	::QueryPerformanceCounter(&nStart);
+	for(int i = 0; i < nIterations; i++) {
+		for(int j = 0; j < asInputs.GetSize(); j++) {
+			CString output;
+			int		pos = 0;
+			if(nMode == 0) {
+				interpreter.Parse(nRoot, asInputs[j], asInputs[j].GetLength(), output, pos);
+			} else if(nMode == 1) {
+				parser.Parse(j, output, pos);
+			} else {
+				parser.Validate(j, pos);
+			}
+		}
+	}
+	::QueryPerformanceCounter(&nStop);
+	return nStop.QuadPart - nStart.QuadPart;
+}
+
+// Parses the accepted inputs concatenated into one large input on one thread and on four (Validate, then Parse),
+// if the parser has threads, and then once more with a rejected input inserted. Returns false and prints the
+// difference if the parses do not agree on the acceptance, the position or the events or nodes.
+static bool CheckThreads(CCheckedParser& parser, const TIcbArray<CString>& asInputs, const TIcbArray<bool>& abAccepted)
+{
+	// the input has more than the two chunks of SYNC_CHUNK (65536) characters the parser needs for threads
+	CString sLarge;
+	int		nRejected = -1;
+	for(int i = 0; i < asInputs.GetSize() && sLarge.GetLength() < 4 * 65536; i++) {
+		if(abAccepted[i]) {
+			sLarge += asInputs[i];
+		} else if(nRejected < 0) {
+			nRejected = i;
+		}
+		if(i+1 == asInputs.GetSize() && sLarge.GetLength() > 0) {
+			i = -1; // again
+		}
+	}
+	if(sLarge.GetLength() == 0) {
+		return true;
+	}
+	for(int nLarge = 0; nLarge < (nRejected < 0 ? 1 : 2); nLarge++) {
+		CString sInput = sLarge;
+		if(nLarge == 1) {
+			sInput.Insert(sLarge.GetLength() * 3 / 4, asInputs[nRejected]);
+		}
+		for(int nMode = 0; nMode < 2; nMode++) {
+			bool  bOk1, bOk4;
+			int	  nPos1 = 0, nPos4 = 0;
+			DWORD nDigest1, nDigest4;
+			if(!parser.ParseOnThreads(sInput, 1, nMode == 0, bOk1, nPos1, nDigest1)) {
+				return true;
+			}
+			parser.ParseOnThreads(sInput, 4, nMode == 0, bOk4, nPos4, nDigest4);
+			if(bOk1 != bOk4 || nPos1 != nPos4 || nDigest1 != nDigest4) {
+				_tprintf(_T("Mismatch: %s of %i characters on 4 threads: accepted %i, offset %i, digest %08X instead of %i, %i, %08X\n"),
+					nMode == 0 ? _T("Validate") : _T("Parse"), sInput.GetLength(), bOk4, nPos4+1, nDigest4, bOk1, nPos1+1, nDigest1);
+				return false;
+			}
+		}
+	}
+	_tprintf(_T("The parses on 4 threads agree with the parses on one (%i characters).\n"), sLarge.GetLength());
+	return true;
+}
+
+struct SCheckOptions
+{
+	int	 nCount;
+	int	 nSeed;
+	int	 nDepth;
+	int	 nLength;
+	int	 nMutate;
+	int	 nIterations;
+	int	 nMaxErrors;
+	bool bOffsets;
+};
+
+// Compares a parser under test to the interpreter of its grammar and times both.
+// Returns the exit code: 0 if they agree, 1 if they do not and 2 if the grammar cannot be checked.
+static int Check(const SParserUnderTest& test, LPCTSTR pszGrammar, const SCheckOptions& options)
+{
+	_tprintf(_T("ParserCheck: parser=%s (%s) grammar=%s count=%i seed=%i depth=%i length=%i mutate=%i%% iterations=%i\n"),
+		test.pszName, test.pszOptions, pszGrammar, options.nCount, options.nSeed, options.nDepth, options.nLength, options.nMutate, options.nIterations);
+
+	CGrammar grammar;
+	CString	 sError;
+	if(!grammar.Read(pszGrammar, sError)) {
+		_tprintf(_T("Error: Failed to read the grammar: %s\n"), (LPCTSTR) sError);
+		return 2;
+	}
+	CInterpreter interpreter(grammar);
+	if(!interpreter.Check(sError)) {
+		_tprintf(_T("Error: %s\n"), (LPCTSTR) sError);
+		return 2;
+	}
+	int nRoot = -1;
+	for(int i = 0; i < grammar.m_anExports.GetSize(); i++) {
+		if(grammar.m_aNonTerms[grammar.m_anExports[i]].m_sName == L"ROOT") {
+			nRoot = grammar.m_anExports[i];
+		}
+	}
+	if(nRoot < 0) {
+		_tprintf(_T("Error: The grammar does not export ROOT.\n"));
+		return 2;
+	}
+	CCheckRandom	r(options.nSeed);
+	CInputGenerator generator(grammar, r, options.nDepth, options.nLength);
+	if(!generator.IsFinite()) {
+		_tprintf(_T("Error: The grammar has NTS that derive no finite input.\n"));
+		return 2;
+	}
+
+	// the inputs: the empty input first, then the generated ones. A mutated input that is still accepted is
+	// mutated again (up to ten times), as the rejected inputs are where backtracking, the offsets of failures
+	// and the transformations of the generator are put to the test.
+	TIcbArray<CString> asInputs(options.nCount);
+	asInputs.Add(CString());
+	while(asInputs.GetSize() < options.nCount) {
+		CString sInput = generator.Generate(nRoot);
+		if(r.Next(100) < options.nMutate) {
+			sInput = generator.Mutate(sInput);
+			CString sOutput;
+			int		nPos;
+			for(int nTries = 0; nTries < 10 && interpreter.Parse(nRoot, sInput, sInput.GetLength(), sOutput, nPos); nTries++) {
+				sInput = generator.Mutate(sInput);
+			}
+		}
+		asInputs.Add(sInput);
+	}
+
+	// the comparison
+	CCheckedParser* pParser	  = test.pfnCreate();
+	bool			bOutputs  = grammar.m_aNonTerms[nRoot].m_sType.GetLength() == 0;
+	int				nAccepted = 0;
+	int				nChecked  = 0;
+	int				nErrors	  = 0;
+	double			nChars	  = 0;
+	TIcbArray<bool> abAccepted(asInputs.GetSize());
+	pParser->SetInputs(asInputs);
+	for(; nChecked < asInputs.GetSize() && nErrors < options.nMaxErrors; nChecked++) {
+		bool bAccepted;
+		if(!Compare(interpreter, nRoot, *pParser, asInputs, nChecked, bOutputs, options.bOffsets, bAccepted)) {
+			nErrors++;
+		}
+		abAccepted.Add(bAccepted);
+		nAccepted += bAccepted ? 1 : 0;
+		nChars	  += asInputs[nChecked].GetLength();
+	}
+	if(nErrors > 0) {
+		_tprintf(_T("Error: The parsers do not agree on %i of %i inputs checked.\n"), nErrors, nChecked);
+		delete pParser;
+		return 1;
+	}
+	_tprintf(_T("The parsers agree on %i inputs (%i accepted, %i rejected, %.1f characters on average).\n"),
+		asInputs.GetSize(), nAccepted, asInputs.GetSize() - nAccepted, nChars / asInputs.GetSize());
+	if(!CheckThreads(*pParser, asInputs, abAccepted)) {
+		delete pParser;
+		return 1;
+	}
+
+	// the throughput of the same inputs
+	if(options.nIterations > 0) {
+		static const TCHAR* apszModes[] = { _T("interpreter"), _T("Parse"), _T("Validate") };
+		LARGE_INTEGER nFreq;
+		::QueryPerformanceFrequency(&nFreq);
+		_tprintf(_T("%-12s %10s %12s %10s\n"), _T("parser"), _T("MB/s"), _T("inputs/s"), _T("speedup"));
+		double nSeconds0 = 0;
+		for(int nMode = 0; nMode < 3; nMode++) {
+			TimeInputs(interpreter, nRoot, *pParser, asInputs, nMode, 1); // warm up
+			double nSeconds = (double) TimeInputs(interpreter, nRoot, *pParser, asInputs, nMode, options.nIterations) / nFreq.QuadPart;
+			if(nMode == 0) {
+				nSeconds0 = nSeconds;
+			}
+			_tprintf(_T("%-12s %10.2f %12.0f %9.1fx\n"), apszModes[nMode], nChars * sizeof(TCHAR) * options.nIterations / nSeconds / (1024*1024),
+				asInputs.GetSize() * options.nIterations / nSeconds, nSeconds0 / nSeconds);
+		}
+	}
+	delete pParser;
+	return 0;
+}
+
+// Returns the name of the file without the directory.
+static CString GetFileName(const CString& sPath)
+{
+	LPCTSTR p = sPath;
+	int		i = sPath.GetLength();
+	while(i > 0 && p[i-1] != '\\' && p[i-1] != '/') {
+		i--;
+	}
+	return sPath.Mid(i);
+}
+
+static void PrintUsage()
+{
+	_tprintf(_T("ParserCheck -- Compares the generated parsers to the interpreter of their grammar\n"));
+	_tprintf(_T("Syntax: $ ParserCheck <grammar.txt> ... [--count=<n>] [--seed=<n>] [--depth=<n>] [--length=<n>]\n"));
+	_tprintf(_T("                                        [--mutate=<n>] [--iterations=<n>] [--max-errors=<n>] [--no-offsets]\n"));
+	_tprintf(_T("Where:\n"));
+	_tprintf(_T("    <grammar.txt> a grammar, all parsers generated from it are checked:\n"));
+	for(int i = 0; i < (int) (sizeof(s_aParsers) / sizeof(s_aParsers[0])); i++) {
+		_tprintf(_T("                  %-22s %-18s (%s)\n"), s_aParsers[i].pszGrammar, s_aParsers[i].pszName, s_aParsers[i].pszOptions);
+	}
+	_tprintf(_T("    --count      number of generated inputs (default: 10000)\n"));
+	_tprintf(_T("    --seed       seed of the input generator (default: 1)\n"));
+	_tprintf(_T("    --depth      depth up to which the rules are chosen at random (default: 30)\n"));
+	_tprintf(_T("    --length     length up to which the rules are chosen at random (default: 1000)\n"));
+	_tprintf(_T("    --mutate     percentage of the inputs that are mutated after generation, an input that\n"));
+	_tprintf(_T("                 is still accepted is mutated again (default: 75)\n"));
+	_tprintf(_T("    --iterations number of timed passes over the inputs, 0 to skip the timing (default: 5)\n"));
+	_tprintf(_T("    --max-errors number of mismatches to print before the check stops (default: 10)\n"));
+	_tprintf(_T("    --no-offsets does not compare the offsets of failed parses\n"));
+	_tprintf(_T("The exit code is 0 if the parsers agree on all inputs, 1 if they do not and 2 for invalid arguments.\n"));
+}
+
+int _tmain(int argc, TCHAR* argv[], TCHAR* envp[])
+{
+	SCheckOptions options;
+	options.nCount		= 10000;
+	options.nSeed		= 1;
+	options.nDepth		= 30;
+	options.nLength		= 1000;
+	options.nMutate		= 75;
+	options.nIterations = 5;
+	options.nMaxErrors	= 10;
+	options.bOffsets	= true;
+
+	TIcbArray<CString> asGrammars;
+	for(int i = 1; i < argc; i++) {
+		CString arg = argv[i];
+		int nEq = arg.Find('=');
+		CString name  = nEq >= 0 ? arg.Left(nEq) : arg;
+		CString value = nEq >= 0 ? arg.Mid(nEq+1) : CString();
+		if(arg.Left(2) != _T("--")) {
+			asGrammars.Add(arg);
+		} else if(name == _T("--count")) {
+			options.nCount = _ttoi(value);
+		} else if(name == _T("--seed")) {
+			options.nSeed = _ttoi(value);
+		} else if(name == _T("--depth")) {
+			options.nDepth = _ttoi(value);
+		} else if(name == _T("--length")) {
+			options.nLength = _ttoi(value);
+		} else if(name == _T("--mutate")) {
+			options.nMutate = _ttoi(value);
+		} else if(name == _T("--iterations")) {
+			options.nIterations = _ttoi(value);
+		} else if(name == _T("--max-errors")) {
+			options.nMaxErrors = _ttoi(value);
+		} else if(name == _T("--no-offsets")) {
+			options.bOffsets = false;
+		} else {
+			_tprintf(_T("Error: Invalid argument '%s'.\n"), (LPCTSTR) arg);
+			PrintUsage();
+			return 2;
+		}
+	}
+	if(asGrammars.GetSize() == 0 || options.nCount <= 0 || options.nDepth < 0 || options.nLength < 0 || options.nMutate < 0 || options.nMutate > 100 ||
+	   options.nIterations < 0 || options.nMaxErrors <= 0) {
+		PrintUsage();
+		return 2;
+	}
+
+	int nResult = 0;
+	for(int i = 0; i < asGrammars.GetSize(); i++) {
+		int nParsers = 0;
+		for(int j = 0; j < (int) (sizeof(s_aParsers) / sizeof(s_aParsers[0])); j++) {
+			if(GetFileName(asGrammars[i]).CompareNoCase(s_aParsers[j].pszGrammar) != 0) {
+				continue;
+			}
+			int nCheck = Check(s_aParsers[j], asGrammars[i], options);
+			if(nCheck == 2) {
+				return 2;
+			}
+			if(nCheck > nResult) {
+				nResult = nCheck;
+			}
+			nParsers++;
+		}
+		if(nParsers == 0) {
+			_tprintf(_T("Error: No parser under test is generated from '%s'.\n"), (LPCTSTR) asGrammars[i]);
+			return 2;
+		}
+	}
+	return nResult;
+}
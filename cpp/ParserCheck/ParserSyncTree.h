@@ -0,0 +1,1425 @@
+//
+// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).
+//       Do not modify the contents of this file as it will be overwritten!
+//
+#pragma once;
+
+class CSyncLinesParser
+{
+public:
+    enum ERule {
+        RULE_ROOT,
+        RULE_LINES,
+        RULE_LINE,
+        RULE_ITEMS,
+        RULE_ITEM,
+        RULE_KEYWORD,
+        RULE_WS,
+        RULE_IDENT,
+        RULE_IDENTCHARS_N,
+        RULE_IDENTCHAR_1,
+        RULE_IDENTCHAR_N,
+        RULE_NUMBER,
+        RULE_DIGITS,
+        RULE_DIGIT,
+        RULE_STRING,
+        RULE_STRINGCHARS,
+        RULE_STRINGCHAR,
+        RULE_COMMENT,
+        RULE_NOT_COMMENTEND
+    };
+
+    static const TCHAR* RuleName(int rule) {
+        static const TCHAR* names[] = {
+            _T("ROOT"),
+            _T("LINES"),
+            _T("LINE"),
+            _T("ITEMS"),
+            _T("ITEM"),
+            _T("KEYWORD"),
+            _T("WS"),
+            _T("IDENT"),
+            _T("IDENTCHARS_N"),
+            _T("IDENTCHAR_1"),
+            _T("IDENTCHAR_N"),
+            _T("NUMBER"),
+            _T("DIGITS"),
+            _T("DIGIT"),
+            _T("STRING"),
+            _T("STRINGCHARS"),
+            _T("STRINGCHAR"),
+            _T("COMMENT"),
+            _T("NOT_COMMENTEND"),
+        };
+        return names[rule];
+    }
+
+    // A node of the concrete syntax tree (<option:tree>): a rule that matched _input[begin, end) or, for a
+    // lexical rule (terminals only), a leaf. The nodes are stored in preorder, child is the first child and
+    // next the next sibling (or -1).
+    struct SNode {
+        int rule;
+        int begin;
+        int end;
+        int child;
+        int next;
+    };
+
+private:
+    const TCHAR* _input;
+    int _size;
+
+    TIcbArray<SNode> _tree; // appended while parsing, truncated on backtracking
+
+    int            _fail_pos; // the farthest position at which a TS failed
+    TIcbArray<int> _fail_at;  // the last position at which each TS failed, the TS expected at _fail_pos failed there
+
+    enum { SYNC_CHUNK = 65536 }; // the minimum size of a chunk of the input searched by one thread
+    enum { SYNC_VALIDATE, SYNC_PARSE, SYNC_COPY }; // the tasks of the threads
+
+    struct SSync { // a match of a NTS with <sync:'xxx'> found in a chunk
+        int rule;
+        int begin;
+        int end;
+        int first; // the events or nodes of the match recorded by the parser of the chunk
+        int count;
+        int chunk;
+        int at;    // where they are copied to
+    };
+
+    int              _threads;    // the number of threads (see SetThreads())
+    TIcbArray<CSyncLinesParser> _chunks; // the parsers of the chunks
+    int              _sync_task;  // the task of the threads and the number of its parts
+    int              _sync_parts;
+    int volatile     _sync_next;  // the next part taken by a thread
+    TIcbArray<SSync> _found;      // the matches found in the chunk of this parser
+    TIcbArray<SSync> _synced;     // the matches of all chunks in input order
+    int              _sync_at;    // the match behind the last copied one
+    TIcbArray<SSync> _copies;     // the matches to be copied after the parse
+
+public:
+    CSyncLinesParser() : _input(NULL), _size(0), _fail_pos(0), _threads(1) { }
+
+    bool Parse_ROOT(const TCHAR* input, int size, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        Speculate(SYNC_PARSE);
+        Rollback(0);
+        bool ok = nt_ROOT(pos);
+        if((!ok || pos != _size) && Unsync()) {
+            pos = 0;
+            Rollback(0);
+            ok  = nt_ROOT(pos);
+        }
+        if(!ok || pos != _size) {
+            return Error(pos, ok);
+        }
+        Copy();
+        _tree[0].next = -1; // the root has no sibling
+        return true;
+    }
+
+    bool Validate_ROOT(const TCHAR* input, int size, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        Speculate(SYNC_VALIDATE);
+        bool ok = vnt_ROOT(pos);
+        if((!ok || pos != _size) && Unsync()) {
+            pos = 0;
+            ok  = vnt_ROOT(pos);
+        }
+        return (ok && pos == _size) || Error(pos, ok);
+    }
+
+    // Returns the position at which the last parse failed, the same as pos after Parse_X() or Validate_X().
+    int GetFailurePos() const {
+        return _fail_pos;
+    }
+
+    // Returns the TS that were expected at GetFailurePos(), e.g. "'+', '-' or end of input".
+    CString GetExpected() const {
+        TIcbArray<const TCHAR*> names;
+        for(int t = 0; t < _fail_at.GetSize(); t++) {
+            if(_fail_at[t] == _fail_pos) {
+                names.Add(TerminalName(t));
+            }
+        }
+        CString expected;
+        for(int i = 0; i < names.GetSize(); i++) {
+            expected += i == 0 ? _T("") : (i+1 < names.GetSize() ? _T(", ") : _T(" or "));
+            expected += names[i];
+        }
+        return expected;
+    }
+
+    // Searches the matches of the NTS with <sync:'xxx'> on up to the given number of threads before the
+    // following parses (1 for none). The input is split into chunks, which are parsed at every position
+    // behind xxx. Where the parse then calls the NTS at the position of a match, the match is copied instead.
+    // As a NTS does not depend on its caller, the copy is the same as the parse of the NTS. Matches the
+    // parse does not call are not used (e.g. behind a xxx in a comment), it parses the NTS there itself.
+    void SetThreads(int threads) {
+        _threads = threads;
+    }
+
+    // The tree of the last successful parse, its root is node 0. As the nodes refer to each other by
+    // index, the tree can be copied or written as one block of GetSize() * sizeof(SNode) bytes.
+    const TIcbArray<SNode>& GetTree() const {
+        return _tree;
+    }
+
+private:
+    bool nt_ROOT(int& pos) {
+        int pos0 = pos;
+        int mark0 = Mark();
+        Open(RULE_ROOT, pos0);
+        int mark1 = Mark();
+        if(true) {
+            int pos1 = pos0;
+            if(nt_LINES(pos1)) {
+                Close(mark0, pos1);
+                pos = pos1;
+                return true;
+            }
+        }
+        Rollback(mark1);
+        Rollback(mark0);
+        return false;
+    }
+
+    bool nt_LINES(int& pos) {
+        int pos0 = pos;
+        int mark0 = Mark();
+        Open(RULE_LINES, pos0);
+        int mark1 = Mark();
+        if(true) {
+            int pos1 = pos0;
+            if(nt_LINE(pos1)) {
+                int pos2 = pos1;
+                if(nt_LINES(pos2)) {
+                    Close(mark0, pos2);
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        Rollback(mark1);
+        if(true) {
+            Close(mark0, pos0);
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_LINE(int& pos) {
+        if(_synced.GetSize() > 0 && Synced(2, pos)) return true;
+        int pos0 = pos;
+        int mark0 = Mark();
+        Open(RULE_LINE, pos0);
+        int mark1 = Mark();
+        if(true) {
+            int pos1 = pos0;
+            if(nt_WS(pos1)) {
+                Leaf(RULE_WS, pos0, pos1);
+                int pos2 = pos1;
+                if(nt_ITEMS(pos2)) {
+                    Leaf(RULE_ITEMS, pos1, pos2);
+                    int pos3 = pos2;
+                    if(tc(pos3, '\n', 1)) {
+                        Close(mark0, pos3);
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        Rollback(mark1);
+        Rollback(mark0);
+        return false;
+    }
+
+    bool nt_ITEMS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_ITEM(pos1)) {
+                int pos2 = pos1;
+                if(nt_WS(pos2)) {
+                    int pos3 = pos2;
+                    if(nt_ITEMS(pos3)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_ITEM(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_KEYWORD(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(nt_IDENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(nt_NUMBER(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(nt_STRING(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(nt_COMMENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tset(pos1, _T("=+-*/;,(){}"), 11, 2)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_KEYWORD(int& pos) {
+        int pos0 = pos;
+        if(true) { // 5 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'e':
+                        if(pos0+4 <= _size && _input[pos0+1] == 'l' && _input[pos0+2] == 's' && _input[pos0+3] == 'e') {
+                            kw = 3;
+                            pos1 = pos0+4;
+                        }
+                        break;
+                    case 'i':
+                        if(pos0+2 <= _size && _input[pos0+1] == 'f') {
+                            kw = 2;
+                            pos1 = pos0+2;
+                        }
+                        break;
+                    case 'l':
+                        if(pos0+3 <= _size && _input[pos0+1] == 'e' && _input[pos0+2] == 't') {
+                            kw = 1;
+                            pos1 = pos0+3;
+                        }
+                        break;
+                    case 'r':
+                        if(pos0+6 <= _size && _input[pos0+1] == 'e' && _input[pos0+2] == 't' && _input[pos0+3] == 'u' && _input[pos0+4] == 'r' && _input[pos0+5] == 'n') {
+                            kw = 5;
+                            pos1 = pos0+6;
+                        }
+                        break;
+                    case 'w':
+                        if(pos0+5 <= _size && _input[pos0+1] == 'h' && _input[pos0+2] == 'i' && _input[pos0+3] == 'l' && _input[pos0+4] == 'e') {
+                            kw = 4;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 3);
+            }
+            if(kw != 0) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_WS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tset(pos1, _T(" \t"), 2, 4)) {
+                int pos2 = pos1;
+                if(nt_WS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_IDENT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_IDENTCHAR_1(pos1)) {
+                int pos2 = pos1;
+                if(nt_IDENTCHARS_N(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool nt_IDENTCHARS_N(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_IDENTCHAR_N(pos1)) {
+                int pos2 = pos1;
+                if(nt_IDENTCHARS_N(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_IDENTCHAR_1(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'a', 'z', 5)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'A', 'Z', 6)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '_', 7)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_IDENTCHAR_N(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'a', 'z', 5)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'A', 'Z', 6)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '_', 7)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '0', '9', 8)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_NUMBER(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_DIGIT(pos1)) {
+                int pos2 = pos1;
+                if(nt_DIGITS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool nt_DIGITS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_DIGIT(pos1)) {
+                int pos2 = pos1;
+                if(nt_DIGITS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_DIGIT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '0', '9', 8)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_STRING(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '\"', 9)) {
+                int pos2 = pos1;
+                if(nt_STRINGCHARS(pos2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, '\"', 9)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool nt_STRINGCHARS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(nt_STRINGCHAR(pos1)) {
+                int pos2 = pos1;
+                if(nt_STRINGCHARS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_STRINGCHAR(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, ' ', '!', 10)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '#', '~', 11)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_COMMENT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(ts(pos1, _T("/*"), 2, 12)) {
+                int pos2 = pos1;
+                if(nt_NOT_COMMENTEND(pos2)) {
+                    int pos3 = pos2;
+                    if(ts(pos3, _T("*/"), 2, 13)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool nt_NOT_COMMENTEND(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '\t', ')', 14)) {
+                int pos2 = pos1;
+                if(nt_NOT_COMMENTEND(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '+', '~', 15)) {
+                int pos2 = pos1;
+                if(nt_NOT_COMMENTEND(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '*', 16)) {
+                if(true) {
+                    int pos2 = pos1;
+                    if(trange(pos2, '\t', '.', 17)) {
+                        int pos3 = pos2;
+                        if(nt_NOT_COMMENTEND(pos3)) {
+                            pos = pos3;
+                            return true;
+                        }
+                    }
+                }
+                if(true) {
+                    int pos2 = pos1;
+                    if(trange(pos2, '0', '~', 18)) {
+                        int pos3 = pos2;
+                        if(nt_NOT_COMMENTEND(pos3)) {
+                            pos = pos3;
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_ROOT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_LINES(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_LINES(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_LINE(pos1)) {
+                int pos2 = pos1;
+                if(vnt_LINES(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_LINE(int& pos) {
+        if(_synced.GetSize() > 0 && vSynced(2, pos)) return true;
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_WS(pos1)) {
+                int pos2 = pos1;
+                if(vnt_ITEMS(pos2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, '\n', 1)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_ITEMS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_ITEM(pos1)) {
+                int pos2 = pos1;
+                if(vnt_WS(pos2)) {
+                    int pos3 = pos2;
+                    if(vnt_ITEMS(pos3)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_ITEM(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_KEYWORD(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_IDENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_NUMBER(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_STRING(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_COMMENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tset(pos1, _T("=+-*/;,(){}"), 11, 2)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_KEYWORD(int& pos) {
+        int pos0 = pos;
+        if(true) { // 5 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'e':
+                        if(pos0+4 <= _size && _input[pos0+1] == 'l' && _input[pos0+2] == 's' && _input[pos0+3] == 'e') {
+                            kw = 3;
+                            pos1 = pos0+4;
+                        }
+                        break;
+                    case 'i':
+                        if(pos0+2 <= _size && _input[pos0+1] == 'f') {
+                            kw = 2;
+                            pos1 = pos0+2;
+                        }
+                        break;
+                    case 'l':
+                        if(pos0+3 <= _size && _input[pos0+1] == 'e' && _input[pos0+2] == 't') {
+                            kw = 1;
+                            pos1 = pos0+3;
+                        }
+                        break;
+                    case 'r':
+                        if(pos0+6 <= _size && _input[pos0+1] == 'e' && _input[pos0+2] == 't' && _input[pos0+3] == 'u' && _input[pos0+4] == 'r' && _input[pos0+5] == 'n') {
+                            kw = 5;
+                            pos1 = pos0+6;
+                        }
+                        break;
+                    case 'w':
+                        if(pos0+5 <= _size && _input[pos0+1] == 'h' && _input[pos0+2] == 'i' && _input[pos0+3] == 'l' && _input[pos0+4] == 'e') {
+                            kw = 4;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 3);
+            }
+            if(kw != 0) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_WS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tset(pos1, _T(" \t"), 2, 4)) {
+                int pos2 = pos1;
+                if(vnt_WS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_IDENT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_IDENTCHAR_1(pos1)) {
+                int pos2 = pos1;
+                if(vnt_IDENTCHARS_N(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_IDENTCHARS_N(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_IDENTCHAR_N(pos1)) {
+                int pos2 = pos1;
+                if(vnt_IDENTCHARS_N(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_IDENTCHAR_1(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'a', 'z', 5)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'A', 'Z', 6)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '_', 7)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_IDENTCHAR_N(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'a', 'z', 5)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, 'A', 'Z', 6)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '_', 7)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '0', '9', 8)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_NUMBER(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_DIGIT(pos1)) {
+                int pos2 = pos1;
+                if(vnt_DIGITS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_DIGITS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_DIGIT(pos1)) {
+                int pos2 = pos1;
+                if(vnt_DIGITS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_DIGIT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '0', '9', 8)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_STRING(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '\"', 9)) {
+                int pos2 = pos1;
+                if(vnt_STRINGCHARS(pos2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, '\"', 9)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_STRINGCHARS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_STRINGCHAR(pos1)) {
+                int pos2 = pos1;
+                if(vnt_STRINGCHARS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_STRINGCHAR(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, ' ', '!', 10)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '#', '~', 11)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_COMMENT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(ts(pos1, _T("/*"), 2, 12)) {
+                int pos2 = pos1;
+                if(vnt_NOT_COMMENTEND(pos2)) {
+                    int pos3 = pos2;
+                    if(ts(pos3, _T("*/"), 2, 13)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_NOT_COMMENTEND(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '\t', ')', 14)) {
+                int pos2 = pos1;
+                if(vnt_NOT_COMMENTEND(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, '+', '~', 15)) {
+                int pos2 = pos1;
+                if(vnt_NOT_COMMENTEND(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '*', 16)) {
+                if(true) {
+                    int pos2 = pos1;
+                    if(trange(pos2, '\t', '.', 17)) {
+                        int pos3 = pos2;
+                        if(vnt_NOT_COMMENTEND(pos3)) {
+                            pos = pos3;
+                            return true;
+                        }
+                    }
+                }
+                if(true) {
+                    int pos2 = pos1;
+                    if(trange(pos2, '0', '~', 18)) {
+                        int pos3 = pos2;
+                        if(vnt_NOT_COMMENTEND(pos3)) {
+                            pos = pos3;
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    void ResetFailure() {
+        _fail_pos = 0;
+        _fail_at.SetSize(19);
+        for(int t = 0; t < _fail_at.GetSize(); t++) {
+            _fail_at[t] = -1;
+        }
+    }
+
+    // Records that the TS t failed at pos. Failures before the farthest position are ignored, the others
+    // cost a comparison and two stores, as nothing has to be cleared when the farthest position moves on.
+    bool Fail(int pos, int t) {
+        if(pos >= _fail_pos) {
+            _fail_pos = pos;
+            _fail_at[t] = pos;
+        }
+        return false;
+    }
+
+    // Ends a failed parse: if the exported NTS matched, but not the whole input, the end of the input
+    // was expected. pos is set to the farthest failure.
+    bool Error(int& pos, bool matched) {
+        if(matched) {
+            Fail(pos, 0);
+        }
+        pos = _fail_pos;
+        return false;
+    }
+
+    static const TCHAR* TerminalName(int t) {
+        static const TCHAR* names[] = {
+            _T("end of input"),
+            _T("\'\\n\'"),
+            _T("one of \'=+-*/;,(){}\'"),
+            _T("\'let\', \'if\', \'else\', \'while\', \'return\'"),
+            _T("one of \' \\t\'"),
+            _T("\'a\'-\'z\'"),
+            _T("\'A\'-\'Z\'"),
+            _T("\'_\'"),
+            _T("\'0\'-\'9\'"),
+            _T("\'\"\'"),
+            _T("\' \'-\'!\'"),
+            _T("\'#\'-\'~\'"),
+            _T("\'/*\'"),
+            _T("\'*/\'"),
+            _T("\'\\t\'-\')\'"),
+            _T("\'+\'-\'~\'"),
+            _T("\'*\'"),
+            _T("\'\\t\'-\'.\'"),
+            _T("\'0\'-\'~\'"),
+        };
+        return names[t];
+    }
+
+    bool ts(int& pos, const TCHAR* s, int slen, int t) {
+        for(int i = 0; i < slen; i++) {
+            if(pos+i >= _size || _input[pos+i] != s[i]) return Fail(pos, t);
+        }
+        pos += slen;
+        return true;
+    }
+
+    bool tc(int& pos, TCHAR c, int t) {
+        if(pos >= _size || _input[pos] != c) return Fail(pos, t);
+        pos++;
+        return true;
+    }
+
+    bool tset(int& pos, const TCHAR* s, int slen, int t) {
+        for(int i = 0; i < slen; i++) {
+            if(pos < _size && s[i] == _input[pos]) {
+                pos++;
+                return true;
+            }
+        }
+        return Fail(pos, t);
+    }
+
+    bool trange(int& pos, TCHAR c1, TCHAR c2, int t) {
+        if(pos >= _size || _input[pos] < c1 || _input[pos] > c2) return Fail(pos, t);
+        pos++;
+        return true;
+    }
+
+    int Mark() {
+        return _tree.GetSize();
+    }
+
+    void Rollback(int mark) {
+        _tree.SetSize(mark);
+        Uncopy(mark);
+    }
+
+    void Open(int rule, int begin) {
+        SNode n = { rule, begin, begin, -1, -1 };
+        _tree.Add(n);
+    }
+
+    void Leaf(int rule, int begin, int end) {
+        SNode n = { rule, begin, end, -1, _tree.GetSize()+1 };
+        _tree.Add(n);
+    }
+
+    // Closes the node added by Open(). Until its parent is closed, next is the end of the subtree, so the
+    // children of the node can be linked by skipping from one to the next.
+    void Close(int node, int end) {
+        int size = _tree.GetSize();
+        _tree[node].end  = end;
+        _tree[node].next = size;
+        if(node+1 < size) {
+            _tree[node].child = node+1;
+            for(int i = node+1; i < size; ) {
+                SNode& child = _tree[i];
+                i = child.next;
+                child.next = i < size ? i : -1;
+            }
+        }
+    }
+
+    // Searches the chunks of the input for matches (see SetThreads()) and collects them in _synced.
+    void Speculate(int task) {
+        _synced.SetSize(0);
+        _sync_at = 0;
+        int chunks = _size / SYNC_CHUNK < _threads * 4 ? _size / SYNC_CHUNK : _threads * 4;
+        if(_threads < 2 || chunks < 2) {
+            return;
+        }
+        _chunks.SetSize(chunks);
+        for(int i = 0; i < chunks; i++) {
+            _chunks[i]._input = _input;
+            _chunks[i]._size  = _size;
+        }
+        RunThreads(task, chunks);
+        for(int i = 0; i < chunks; i++) {
+            TIcbArray<SSync>& found = _chunks[i]._found;
+            for(int j = 0; j < found.GetSize(); j++) {
+                found[j].chunk = i;
+            }
+            _synced.Add(found);
+        }
+    }
+
+    // Runs the parts of the task on the calling thread and up to _threads-1 threads started here, which
+    // take one part after the other.
+    void RunThreads(int task, int parts) {
+        _sync_task  = task;
+        _sync_parts = parts;
+        _sync_next  = 0;
+        HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+        int    count = 0;
+        while(count < _threads-1 && count < parts-1 && count < MAXIMUM_WAIT_OBJECTS) {
+            HANDLE thread = CreateThread(NULL, 0, SyncThread, this, 0, NULL);
+            if(thread == NULL) {
+                break; // the threads started so far do the rest
+            }
+            threads[count++] = thread;
+        }
+        SyncThread(this);
+        if(count > 0) {
+            WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+        }
+        for(int i = 0; i < count; i++) {
+            CloseHandle(threads[i]);
+        }
+    }
+
+    static DWORD WINAPI SyncThread(LPVOID param) {
+        CSyncLinesParser* parser = (CSyncLinesParser*) param;
+        int part;
+        while((part = IcbAtomicInc(&parser->_sync_next) - 1) < parser->_sync_parts) {
+            parser->SyncPart(part);
+        }
+        return 0;
+    }
+
+    void SyncPart(int part) {
+        int size  = _sync_task == SYNC_COPY ? _copies.GetSize() : _size;
+        int begin = (int) ((__int64) size * part / _sync_parts);
+        int end   = (int) ((__int64) size * (part+1) / _sync_parts);
+        switch(_sync_task) {
+            case SYNC_VALIDATE: _chunks[part].vSyncChunk(begin, end); break;
+            case SYNC_PARSE:    _chunks[part].SyncChunk(begin, end);  break;
+            case SYNC_COPY:     CopySynced(begin, end);               break;
+        }
+    }
+
+    // Searches [begin, end) of the input for matches for Parse_X(): the NTS with <sync:'xxx'> are tried in
+    // their order at every position behind their text. The search goes on at the end of a match.
+    void SyncChunk(int begin, int end) {
+        ResetFailure();
+        Rollback(0);
+        _found.SetSize(0);
+        int pos = begin;
+        while(pos < end) {
+            int pos1 = pos;
+            int mark = Mark();
+            if(SyncPoint(pos, _T("\n"), 1)) {
+                if(nt_LINE(pos1) && pos1 > pos) {
+                    SSync s = { 2, pos, pos1, mark, Mark() - mark, 0, 0 }; // chunk is set by Speculate(), at by Synced()
+                    _found.Add(s);
+                    pos = pos1;
+                    continue;
+                }
+                Rollback(mark);
+                pos1 = pos;
+            }
+            pos++;
+        }
+    }
+
+    // Searches [begin, end) of the input for matches for Validate_X(): the NTS with <sync:'xxx'> are tried in
+    // their order at every position behind their text. The search goes on at the end of a match.
+    void vSyncChunk(int begin, int end) {
+        ResetFailure();
+        _found.SetSize(0);
+        int pos = begin;
+        while(pos < end) {
+            int pos1 = pos;
+            int mark = 0;
+            if(SyncPoint(pos, _T("\n"), 1)) {
+                if(vnt_LINE(pos1) && pos1 > pos) {
+                    SSync s = { 2, pos, pos1, mark, 0, 0, 0 }; // chunk is set by Speculate(), at by Synced()
+                    _found.Add(s);
+                    pos = pos1;
+                    continue;
+                }
+                pos1 = pos;
+            }
+            pos++;
+        }
+    }
+
+    // Returns true if a NTS with <sync:'s'> may start at pos: at the start of the input or behind s.
+    bool SyncPoint(int pos, const TCHAR* s, int slen) const {
+        if(pos < slen) {
+            return pos == 0;
+        }
+        for(int i = 0; i < slen; i++) {
+            if(_input[pos-slen+i] != s[i]) return false;
+        }
+        return true;
+    }
+
+    // Returns the match of the rule at pos found by Speculate(), or -1 if there is none. Usually, it is the
+    // one behind the last match taken, otherwise it is searched.
+    int FindSynced(int rule, int pos) const {
+        int i = _sync_at;
+        if(i >= _synced.GetSize() || _synced[i].begin != pos) {
+            int hi = _synced.GetSize();
+            i = 0;
+            while(i < hi) {
+                int mid = (i + hi) / 2;
+                if(_synced[mid].begin < pos) i = mid+1; else hi = mid;
+            }
+            if(i == _synced.GetSize() || _synced[i].begin != pos) {
+                return -1;
+            }
+        }
+        return _synced[i].rule == rule ? i : -1;
+    }
+
+    // Takes the match of the rule at pos for Validate_X(), which skips it: its chunk was only validated.
+    bool vSynced(int rule, int& pos) {
+        int i = FindSynced(rule, pos);
+        if(i < 0) {
+            return false;
+        }
+        _sync_at = i+1;
+        pos = _synced[i].end;
+        return true;
+    }
+
+    // Takes the match of the rule at pos for Parse_X(), its events or nodes are copied after the parse.
+    bool Synced(int rule, int& pos) {
+        int i = FindSynced(rule, pos);
+        if(i < 0) {
+            return false;
+        }
+        _sync_at = i+1;
+        SSync s = _synced[i];
+        s.at = _tree.GetSize();
+        if(s.at + s.count > _tree.GetCapacity()) {
+            _tree.SetCapacity(2 * (s.at + s.count));
+        }
+        _tree.SetSize(s.at + s.count);
+        _copies.Add(s);
+        CopyNode(s, 0); // the root links the subtree to its siblings, the rest is copied after the parse
+        pos = _synced[i].end;
+        return true;
+    }
+
+    // Drops the copies of the matches that are removed on backtracking.
+    void Uncopy(int mark) {
+        int n = _copies.GetSize();
+        while(n > 0 && _copies[n-1].at >= mark) {
+            n--;
+        }
+        _copies.SetSize(n);
+    }
+
+    // Copies the matches taken by a successful parse in parallel.
+    void Copy() {
+        if(_copies.GetSize() > 0) {
+            RunThreads(SYNC_COPY, _copies.GetSize() < _threads * 4 ? _copies.GetSize() : _threads * 4);
+        }
+    }
+
+    void CopySynced(int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            const SSync& s = _copies[i];
+            for(int j = 1; j < s.count; j++) {
+                CopyNode(s, j);
+            }
+        }
+    }
+
+    // Copies a node of a match, the nodes refer to each other by index.
+    void CopyNode(const SSync& s, int j) {
+        SNode& n = _tree[s.at + j];
+        n = _chunks[s.chunk]._tree[s.first + j];
+        if(n.child >= 0) n.child += s.at - s.first;
+        if(n.next  >= 0) n.next  += s.at - s.first;
+    }
+
+    // Forgets the matches of Speculate() after a failed parse, which is then repeated to find the TS that
+    // failed within the copied matches. Returns false if there were none.
+    bool Unsync() {
+        if(_synced.GetSize() == 0) {
+            return false;
+        }
+        _synced.SetSize(0);
+        ResetFailure();
+        return true;
+    }
+
+};
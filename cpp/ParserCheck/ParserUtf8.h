@@ -0,0 +1,1557 @@
+//
+// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).
+//       Do not modify the contents of this file as it will be overwritten!
+//
+#pragma once;
+
+class CSyntaxHighlightParser
+{
+private:
+    const char* _input;
+    int _size;
+
+    struct SOutput { // the output of a NTS without type: the records _out[begin, end)
+        int begin;
+        int end;
+    };
+
+    struct SRecord { // a part of the output: text[begin, end) or, if text is NULL, the records _out[begin, end)
+        const char* text;
+        int begin;
+        int end;
+    };
+
+    TIcbArray<SRecord> _out;   // appended by the output templates, truncated on backtracking
+    TIcbArray<SOutput> _stack; // the records still to be copied by Flatten()
+
+    int            _fail_pos; // the farthest position at which a TS failed
+    TIcbArray<int> _fail_at;  // the last position at which each TS failed, the TS expected at _fail_pos failed there
+
+public:
+    CSyntaxHighlightParser() : _input(NULL), _size(0), _fail_pos(0) { }
+
+    bool Parse_ROOT(const char* input, int size, CStringA& output, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        _out.SetSize(0);
+        SOutput out;
+        bool ok = nt_ROOT(pos, out);
+        if(!ok || pos != _size) {
+            return Error(pos, ok);
+        }
+        Flatten(out, output);
+        return true;
+    }
+
+    bool Validate_ROOT(const char* input, int size, int& pos) {
+        _input = input;
+        _size  = size;
+        pos    = 0;
+        ResetFailure();
+        bool ok = vnt_ROOT(pos);
+        return (ok && pos == _size) || Error(pos, ok);
+    }
+
+    // Returns the position at which the last parse failed, the same as pos after Parse_X() or Validate_X().
+    int GetFailurePos() const {
+        return _fail_pos;
+    }
+
+    // Returns the TS that were expected at GetFailurePos(), e.g. "'+', '-' or end of input".
+    CString GetExpected() const {
+        TIcbArray<const TCHAR*> names;
+        for(int t = 0; t < _fail_at.GetSize(); t++) {
+            if(_fail_at[t] == _fail_pos) {
+                names.Add(TerminalName(t));
+            }
+        }
+        CString expected;
+        for(int i = 0; i < names.GetSize(); i++) {
+            expected += i == 0 ? _T("") : (i+1 < names.GetSize() ? _T(", ") : _T(" or "));
+            expected += names[i];
+        }
+        return expected;
+    }
+
+private:
+    bool nt_ROOT(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_TEXT(pos1, output1)) {
+                output.begin = _out.GetSize();
+                Out("<html><body><pre>", 0, 17);
+                Out(NULL, output1.begin, output1.end);
+                Out("</pre></body></html>", 0, 20);
+                output.end = _out.GetSize();
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        return false;
+    }
+
+    bool nt_TEXT(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_WHITESPACE(pos1, output1)) {
+                int mark2 = _out.GetSize();
+                if(true) {
+                    SOutput output2 /*= default(SOutput)*/;
+                    int pos2 = pos1;
+                    if(nt_SOMETHING(pos2, output2)) {
+                        SOutput output3 /*= default(SOutput)*/;
+                        int pos3 = pos2;
+                        if(nt_TEXT(pos3, output3)) {
+                            output.begin = _out.GetSize();
+                            Out(_input, pos0, pos1);
+                            Out(NULL, output2.begin, output2.end);
+                            Out(NULL, output3.begin, output3.end);
+                            output.end = _out.GetSize();
+                            pos = pos3;
+                            return true;
+                        }
+                    }
+                }
+                _out.SetSize(mark2);
+                if(true) {
+                    output.begin = _out.GetSize();
+                    Out(_input, pos0, pos1);
+                    output.end = _out.GetSize();
+                    pos = pos1;
+                    return true;
+                }
+            }
+        }
+        _out.SetSize(mark1);
+        return false;
+    }
+
+    bool nt_WHITESPACE(int& pos, SOutput& output) { // scanner, 1 state
+        int p   = pos;
+        int end = -1;
+        output.begin = output.end = 0;
+        unsigned char c;
+    s0:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= '\t' && c <= '\n') || c == '\r' || c == ' ') { p++; goto s0; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool nt_SOMETHING(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_RESERVED(pos1, output1)) {
+                int pos2 = pos1;
+                if(tset(pos2, " \t\r\n();,", 8, 1)) {
+                    output.begin = _out.GetSize();
+                    Out("<b>", 0, 3);
+                    Out(_input, pos0, pos1);
+                    Out("</b>", 0, 4);
+                    Out(_input, pos1, pos2);
+                    output.end = _out.GetSize();
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_IDENT(pos1, output1)) {
+                output.begin = _out.GetSize();
+                Out("<u>", 0, 3);
+                Out(_input, pos0, pos1);
+                Out("</u>", 0, 4);
+                output.end = _out.GetSize();
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_NUMBER(pos1, output1)) {
+                output.begin = _out.GetSize();
+                Out(_input, pos0, pos1);
+                output.end = _out.GetSize();
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_STRING(pos1, output1)) {
+                output.begin = _out.GetSize();
+                Out("<font color=\'red\'><i>", 0, 21);
+                Out(_input, pos0, pos1);
+                Out("</i></font>", 0, 11);
+                output.end = _out.GetSize();
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_COMMENT(pos1, output1)) {
+                output.begin = _out.GetSize();
+                Out("<font color=\'green\'><i>", 0, 23);
+                Out(_input, pos0, pos1);
+                Out("</i></font>", 0, 11);
+                output.end = _out.GetSize();
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_SOMETHING_UTF8_1(pos1, output1)) {
+                output.begin = _out.GetSize();
+                Out(_input, pos0, pos1);
+                output.end = _out.GetSize();
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        return false;
+    }
+
+    bool nt_RESERVED(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        if(true) { // 25 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'b':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'o':
+                                    if(pos0+4 <= _size && _input[pos0+2] == 'o' && _input[pos0+3] == 'l') {
+                                        kw = 13;
+                                        pos1 = pos0+4;
+                                    }
+                                    break;
+                                case 'r':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'e' && _input[pos0+3] == 'a' && _input[pos0+4] == 'k') {
+                                        kw = 21;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'c':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'a':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 't' && _input[pos0+3] == 'c' && _input[pos0+4] == 'h') {
+                                        kw = 24;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                                case 'l':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'a' && _input[pos0+3] == 's' && _input[pos0+4] == 's') {
+                                        kw = 3;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'e':
+                        if(pos0+4 <= _size && _input[pos0+1] == 'l' && _input[pos0+2] == 's' && _input[pos0+3] == 'e') {
+                            kw = 17;
+                            pos1 = pos0+4;
+                        }
+                        break;
+                    case 'f':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'a':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'l' && _input[pos0+3] == 's' && _input[pos0+4] == 'e') {
+                                        kw = 15;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                                case 'i':
+                                    if(pos0+7 <= _size && _input[pos0+2] == 'n' && _input[pos0+3] == 'a' && _input[pos0+4] == 'l' && _input[pos0+5] == 'l' && _input[pos0+6] == 'y') {
+                                        kw = 25;
+                                        pos1 = pos0+7;
+                                    }
+                                    break;
+                                case 'o':
+                                    if(pos0+3 <= _size && _input[pos0+2] == 'r') {
+                                        kw = 18;
+                                        pos1 = pos0+3;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'i':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'f':
+                                    kw = 16;
+                                    pos1 = pos0+2;
+                                    break;
+                                case 'n':
+                                    kw = 9;
+                                    pos1 = pos0+2;
+                                    if(pos0+3 <= _size && _input[pos0+2] == 't') {
+                                        kw = 8;
+                                        pos1 = pos0+3;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'n':
+                        if(pos0+9 <= _size && _input[pos0+1] == 'a' && _input[pos0+2] == 'm' && _input[pos0+3] == 'e' && _input[pos0+4] == 's' && _input[pos0+5] == 'p' && _input[pos0+6] == 'a' && _input[pos0+7] == 'c' && _input[pos0+8] == 'e') {
+                            kw = 2;
+                            pos1 = pos0+9;
+                        }
+                        break;
+                    case 'o':
+                        if(pos0+3 <= _size && _input[pos0+1] == 'u' && _input[pos0+2] == 't') {
+                            kw = 11;
+                            pos1 = pos0+3;
+                        }
+                        break;
+                    case 'p':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'r':
+                                    if(pos0+7 <= _size && _input[pos0+2] == 'i' && _input[pos0+3] == 'v' && _input[pos0+4] == 'a' && _input[pos0+5] == 't' && _input[pos0+6] == 'e') {
+                                        kw = 5;
+                                        pos1 = pos0+7;
+                                    }
+                                    break;
+                                case 'u':
+                                    if(pos0+6 <= _size && _input[pos0+2] == 'b' && _input[pos0+3] == 'l' && _input[pos0+4] == 'i' && _input[pos0+5] == 'c') {
+                                        kw = 4;
+                                        pos1 = pos0+6;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'r':
+                        if(pos0+2 <= _size && _input[pos0+1] == 'e') {
+                            if(pos0+2 < _size) {
+                                switch(_input[pos0+2]) {
+                                    case 'a':
+                                        if(pos0+8 <= _size && _input[pos0+3] == 'd' && _input[pos0+4] == 'o' && _input[pos0+5] == 'n' && _input[pos0+6] == 'l' && _input[pos0+7] == 'y') {
+                                            kw = 6;
+                                            pos1 = pos0+8;
+                                        }
+                                        break;
+                                    case 'f':
+                                        kw = 10;
+                                        pos1 = pos0+3;
+                                        break;
+                                    case 't':
+                                        if(pos0+6 <= _size && _input[pos0+3] == 'u' && _input[pos0+4] == 'r' && _input[pos0+5] == 'n') {
+                                            kw = 20;
+                                            pos1 = pos0+6;
+                                        }
+                                        break;
+                                }
+                            }
+                        }
+                        break;
+                    case 's':
+                        if(pos0+6 <= _size && _input[pos0+1] == 't' && _input[pos0+2] == 'a' && _input[pos0+3] == 't' && _input[pos0+4] == 'i' && _input[pos0+5] == 'c') {
+                            kw = 7;
+                            pos1 = pos0+6;
+                        }
+                        break;
+                    case 't':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'h':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'r' && _input[pos0+3] == 'o' && _input[pos0+4] == 'w') {
+                                        kw = 22;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                                case 'r':
+                                    if(pos0+2 < _size) {
+                                        switch(_input[pos0+2]) {
+                                            case 'u':
+                                                if(pos0+4 <= _size && _input[pos0+3] == 'e') {
+                                                    kw = 14;
+                                                    pos1 = pos0+4;
+                                                }
+                                                break;
+                                            case 'y':
+                                                kw = 23;
+                                                pos1 = pos0+3;
+                                                break;
+                                        }
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'u':
+                        if(pos0+5 <= _size && _input[pos0+1] == 's' && _input[pos0+2] == 'i' && _input[pos0+3] == 'n' && _input[pos0+4] == 'g') {
+                            kw = 1;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                    case 'v':
+                        if(pos0+4 <= _size && _input[pos0+1] == 'o' && _input[pos0+2] == 'i' && _input[pos0+3] == 'd') {
+                            kw = 12;
+                            pos1 = pos0+4;
+                        }
+                        break;
+                    case 'w':
+                        if(pos0+5 <= _size && _input[pos0+1] == 'h' && _input[pos0+2] == 'i' && _input[pos0+3] == 'l' && _input[pos0+4] == 'e') {
+                            kw = 19;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 2);
+            }
+            if(kw != 0) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool nt_IDENT(int& pos, SOutput& output) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        output.begin = output.end = 0;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if((c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+    f0:
+        Fail(p, 3);
+        goto done;
+    s1:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool nt_NUMBER(int& pos, SOutput& output) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        output.begin = output.end = 0;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s1; }
+    f0:
+        Fail(p, 4);
+        goto done;
+    s1:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s1; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool nt_STRING(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '"', 5)) {
+                SOutput output2 /*= default(SOutput)*/;
+                int pos2 = pos1;
+                if(nt_STRINGCHARS(pos2, output2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, '"', 5)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        _out.SetSize(mark1);
+        return false;
+    }
+
+    bool nt_STRINGCHARS(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_STRINGCHAR(pos1, output1)) {
+                SOutput output2 /*= default(SOutput)*/;
+                int pos2 = pos1;
+                if(nt_STRINGCHARS(pos2, output2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool nt_STRINGCHAR(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, ' ', '!', 6)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            SOutput output1 /*= default(SOutput)*/;
+            int pos1 = pos0;
+            if(nt_STRINGCHAR_UTF8_1(pos1, output1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        _out.SetSize(mark1);
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '\\', 7)) {
+                SOutput output2 /*= default(SOutput)*/;
+                int pos2 = pos1;
+                if(nt_SOMETHING_UTF8_1(pos2, output2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        _out.SetSize(mark1);
+        return false;
+    }
+
+    bool nt_COMMENT(int& pos, SOutput& output) {
+        int pos0 = pos;
+        output.begin = output.end = 0;
+        int mark1 = _out.GetSize();
+        if(true) {
+            int pos1 = pos0;
+            if(ts(pos1, "/*", 2, 8)) {
+                SOutput output2 /*= default(SOutput)*/;
+                int pos2 = pos1;
+                if(nt_NOT_COMMENTEND(pos2, output2)) {
+                    int pos3 = pos2;
+                    if(ts(pos3, "*/", 2, 9)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        _out.SetSize(mark1);
+        return false;
+    }
+
+    bool nt_NOT_COMMENTEND(int& pos, SOutput& output) { // scanner, 7 states
+        int p   = pos;
+        int end = -1;
+        output.begin = output.end = 0;
+        unsigned char c;
+    s0:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= ' ' && c <= ')') || (c >= '+' && c <= 0x7F)) { p++; goto s0; }
+        if(c == '*') { p++; goto s1; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+        goto done;
+    s1:
+        if(p >= _size) goto f1;
+        c = _input[p];
+        if((c >= ' ' && c <= '.') || (c >= '0' && c <= 0x7F)) { p++; goto s0; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+    f1:
+        Fail(p, 10);
+        goto done;
+    s2:
+        if(p >= _size) goto f2;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s0; }
+    f2:
+        Fail(p, 11);
+        goto done;
+    s3:
+        if(p >= _size) goto f3;
+        c = _input[p];
+        if(c >= 0xA0 && c <= 0xBF) { p++; goto s2; }
+    f3:
+        Fail(p, 12);
+        goto done;
+    s4:
+        if(p >= _size) goto f4;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s2; }
+    f4:
+        Fail(p, 11);
+        goto done;
+    s5:
+        if(p >= _size) goto f5;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0x97) { p++; goto s2; }
+        if(c == 0x98) { p++; goto s6; }
+    f5:
+        Fail(p, 13);
+        goto done;
+    s6:
+        if(p >= _size) goto f6;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBA) { p++; goto s0; }
+    f6:
+        Fail(p, 14);
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool nt_SOMETHING_UTF8_1(int& pos, SOutput& output) { // scanner, 7 states
+        int p   = pos;
+        int end = -1;
+        output.begin = output.end = 0;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= ' ' && c <= 0x7F) { p++; goto s1; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+    f0:
+        Fail(p, 15);
+        goto done;
+    s1:
+        end = p;
+        goto done;
+    s2:
+        if(p >= _size) goto f2;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s1; }
+    f2:
+        Fail(p, 11);
+        goto done;
+    s3:
+        if(p >= _size) goto f3;
+        c = _input[p];
+        if(c >= 0xA0 && c <= 0xBF) { p++; goto s2; }
+    f3:
+        Fail(p, 12);
+        goto done;
+    s4:
+        if(p >= _size) goto f4;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s2; }
+    f4:
+        Fail(p, 11);
+        goto done;
+    s5:
+        if(p >= _size) goto f5;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0x97) { p++; goto s2; }
+        if(c == 0x98) { p++; goto s6; }
+    f5:
+        Fail(p, 13);
+        goto done;
+    s6:
+        if(p >= _size) goto f6;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBA) { p++; goto s1; }
+    f6:
+        Fail(p, 14);
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool nt_STRINGCHAR_UTF8_1(int& pos, SOutput& output) { // scanner, 7 states
+        int p   = pos;
+        int end = -1;
+        output.begin = output.end = 0;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= '#' && c <= 0x7F) { p++; goto s1; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+    f0:
+        Fail(p, 16);
+        goto done;
+    s1:
+        end = p;
+        goto done;
+    s2:
+        if(p >= _size) goto f2;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s1; }
+    f2:
+        Fail(p, 11);
+        goto done;
+    s3:
+        if(p >= _size) goto f3;
+        c = _input[p];
+        if(c >= 0xA0 && c <= 0xBF) { p++; goto s2; }
+    f3:
+        Fail(p, 12);
+        goto done;
+    s4:
+        if(p >= _size) goto f4;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s2; }
+    f4:
+        Fail(p, 11);
+        goto done;
+    s5:
+        if(p >= _size) goto f5;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0x97) { p++; goto s2; }
+        if(c == 0x98) { p++; goto s6; }
+    f5:
+        Fail(p, 13);
+        goto done;
+    s6:
+        if(p >= _size) goto f6;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBA) { p++; goto s1; }
+    f6:
+        Fail(p, 14);
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_ROOT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_TEXT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_TEXT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_WHITESPACE(pos1)) {
+                if(true) {
+                    int pos2 = pos1;
+                    if(vnt_SOMETHING(pos2)) {
+                        int pos3 = pos2;
+                        if(vnt_TEXT(pos3)) {
+                            pos = pos3;
+                            return true;
+                        }
+                    }
+                }
+                if(true) {
+                    pos = pos1;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_WHITESPACE(int& pos) { // scanner, 1 state
+        int p   = pos;
+        int end = -1;
+        unsigned char c;
+    s0:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= '\t' && c <= '\n') || c == '\r' || c == ' ') { p++; goto s0; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_SOMETHING(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_RESERVED(pos1)) {
+                int pos2 = pos1;
+                if(tset(pos2, " \t\r\n();,", 8, 1)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_IDENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_NUMBER(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_STRING(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_COMMENT(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_SOMETHING_UTF8_1(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_RESERVED(int& pos) {
+        int pos0 = pos;
+        if(true) { // 25 keywords
+            int kw = 0; // the alternative that matched
+            int pos1 = pos0;
+            if(pos0 < _size) {
+                switch(_input[pos0]) {
+                    case 'b':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'o':
+                                    if(pos0+4 <= _size && _input[pos0+2] == 'o' && _input[pos0+3] == 'l') {
+                                        kw = 13;
+                                        pos1 = pos0+4;
+                                    }
+                                    break;
+                                case 'r':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'e' && _input[pos0+3] == 'a' && _input[pos0+4] == 'k') {
+                                        kw = 21;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'c':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'a':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 't' && _input[pos0+3] == 'c' && _input[pos0+4] == 'h') {
+                                        kw = 24;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                                case 'l':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'a' && _input[pos0+3] == 's' && _input[pos0+4] == 's') {
+                                        kw = 3;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'e':
+                        if(pos0+4 <= _size && _input[pos0+1] == 'l' && _input[pos0+2] == 's' && _input[pos0+3] == 'e') {
+                            kw = 17;
+                            pos1 = pos0+4;
+                        }
+                        break;
+                    case 'f':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'a':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'l' && _input[pos0+3] == 's' && _input[pos0+4] == 'e') {
+                                        kw = 15;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                                case 'i':
+                                    if(pos0+7 <= _size && _input[pos0+2] == 'n' && _input[pos0+3] == 'a' && _input[pos0+4] == 'l' && _input[pos0+5] == 'l' && _input[pos0+6] == 'y') {
+                                        kw = 25;
+                                        pos1 = pos0+7;
+                                    }
+                                    break;
+                                case 'o':
+                                    if(pos0+3 <= _size && _input[pos0+2] == 'r') {
+                                        kw = 18;
+                                        pos1 = pos0+3;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'i':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'f':
+                                    kw = 16;
+                                    pos1 = pos0+2;
+                                    break;
+                                case 'n':
+                                    kw = 9;
+                                    pos1 = pos0+2;
+                                    if(pos0+3 <= _size && _input[pos0+2] == 't') {
+                                        kw = 8;
+                                        pos1 = pos0+3;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'n':
+                        if(pos0+9 <= _size && _input[pos0+1] == 'a' && _input[pos0+2] == 'm' && _input[pos0+3] == 'e' && _input[pos0+4] == 's' && _input[pos0+5] == 'p' && _input[pos0+6] == 'a' && _input[pos0+7] == 'c' && _input[pos0+8] == 'e') {
+                            kw = 2;
+                            pos1 = pos0+9;
+                        }
+                        break;
+                    case 'o':
+                        if(pos0+3 <= _size && _input[pos0+1] == 'u' && _input[pos0+2] == 't') {
+                            kw = 11;
+                            pos1 = pos0+3;
+                        }
+                        break;
+                    case 'p':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'r':
+                                    if(pos0+7 <= _size && _input[pos0+2] == 'i' && _input[pos0+3] == 'v' && _input[pos0+4] == 'a' && _input[pos0+5] == 't' && _input[pos0+6] == 'e') {
+                                        kw = 5;
+                                        pos1 = pos0+7;
+                                    }
+                                    break;
+                                case 'u':
+                                    if(pos0+6 <= _size && _input[pos0+2] == 'b' && _input[pos0+3] == 'l' && _input[pos0+4] == 'i' && _input[pos0+5] == 'c') {
+                                        kw = 4;
+                                        pos1 = pos0+6;
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'r':
+                        if(pos0+2 <= _size && _input[pos0+1] == 'e') {
+                            if(pos0+2 < _size) {
+                                switch(_input[pos0+2]) {
+                                    case 'a':
+                                        if(pos0+8 <= _size && _input[pos0+3] == 'd' && _input[pos0+4] == 'o' && _input[pos0+5] == 'n' && _input[pos0+6] == 'l' && _input[pos0+7] == 'y') {
+                                            kw = 6;
+                                            pos1 = pos0+8;
+                                        }
+                                        break;
+                                    case 'f':
+                                        kw = 10;
+                                        pos1 = pos0+3;
+                                        break;
+                                    case 't':
+                                        if(pos0+6 <= _size && _input[pos0+3] == 'u' && _input[pos0+4] == 'r' && _input[pos0+5] == 'n') {
+                                            kw = 20;
+                                            pos1 = pos0+6;
+                                        }
+                                        break;
+                                }
+                            }
+                        }
+                        break;
+                    case 's':
+                        if(pos0+6 <= _size && _input[pos0+1] == 't' && _input[pos0+2] == 'a' && _input[pos0+3] == 't' && _input[pos0+4] == 'i' && _input[pos0+5] == 'c') {
+                            kw = 7;
+                            pos1 = pos0+6;
+                        }
+                        break;
+                    case 't':
+                        if(pos0+1 < _size) {
+                            switch(_input[pos0+1]) {
+                                case 'h':
+                                    if(pos0+5 <= _size && _input[pos0+2] == 'r' && _input[pos0+3] == 'o' && _input[pos0+4] == 'w') {
+                                        kw = 22;
+                                        pos1 = pos0+5;
+                                    }
+                                    break;
+                                case 'r':
+                                    if(pos0+2 < _size) {
+                                        switch(_input[pos0+2]) {
+                                            case 'u':
+                                                if(pos0+4 <= _size && _input[pos0+3] == 'e') {
+                                                    kw = 14;
+                                                    pos1 = pos0+4;
+                                                }
+                                                break;
+                                            case 'y':
+                                                kw = 23;
+                                                pos1 = pos0+3;
+                                                break;
+                                        }
+                                    }
+                                    break;
+                            }
+                        }
+                        break;
+                    case 'u':
+                        if(pos0+5 <= _size && _input[pos0+1] == 's' && _input[pos0+2] == 'i' && _input[pos0+3] == 'n' && _input[pos0+4] == 'g') {
+                            kw = 1;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                    case 'v':
+                        if(pos0+4 <= _size && _input[pos0+1] == 'o' && _input[pos0+2] == 'i' && _input[pos0+3] == 'd') {
+                            kw = 12;
+                            pos1 = pos0+4;
+                        }
+                        break;
+                    case 'w':
+                        if(pos0+5 <= _size && _input[pos0+1] == 'h' && _input[pos0+2] == 'i' && _input[pos0+3] == 'l' && _input[pos0+4] == 'e') {
+                            kw = 19;
+                            pos1 = pos0+5;
+                        }
+                        break;
+                }
+            }
+            if(kw == 0) {
+                Fail(pos0, 2);
+            }
+            if(kw != 0) {
+                pos = pos1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vnt_IDENT(int& pos) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if((c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+    f0:
+        Fail(p, 3);
+        goto done;
+    s1:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= 'a' && c <= 'z')) { p++; goto s1; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_NUMBER(int& pos) { // scanner, 2 states
+        int p   = pos;
+        int end = -1;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s1; }
+    f0:
+        Fail(p, 4);
+        goto done;
+    s1:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if(c >= '0' && c <= '9') { p++; goto s1; }
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_STRING(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '"', 5)) {
+                int pos2 = pos1;
+                if(vnt_STRINGCHARS(pos2)) {
+                    int pos3 = pos2;
+                    if(tc(pos3, '"', 5)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_STRINGCHARS(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_STRINGCHAR(pos1)) {
+                int pos2 = pos1;
+                if(vnt_STRINGCHARS(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        if(true) {
+            pos = pos0;
+            return true;
+        }
+    }
+
+    bool vnt_STRINGCHAR(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(trange(pos1, ' ', '!', 6)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(vnt_STRINGCHAR_UTF8_1(pos1)) {
+                pos = pos1;
+                return true;
+            }
+        }
+        if(true) {
+            int pos1 = pos0;
+            if(tc(pos1, '\\', 7)) {
+                int pos2 = pos1;
+                if(vnt_SOMETHING_UTF8_1(pos2)) {
+                    pos = pos2;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_COMMENT(int& pos) {
+        int pos0 = pos;
+        if(true) {
+            int pos1 = pos0;
+            if(ts(pos1, "/*", 2, 8)) {
+                int pos2 = pos1;
+                if(vnt_NOT_COMMENTEND(pos2)) {
+                    int pos3 = pos2;
+                    if(ts(pos3, "*/", 2, 9)) {
+                        pos = pos3;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    bool vnt_NOT_COMMENTEND(int& pos) { // scanner, 7 states
+        int p   = pos;
+        int end = -1;
+        unsigned char c;
+    s0:
+        end = p;
+        if(p >= _size) goto done;
+        c = _input[p];
+        if((c >= ' ' && c <= ')') || (c >= '+' && c <= 0x7F)) { p++; goto s0; }
+        if(c == '*') { p++; goto s1; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+        goto done;
+    s1:
+        if(p >= _size) goto f1;
+        c = _input[p];
+        if((c >= ' ' && c <= '.') || (c >= '0' && c <= 0x7F)) { p++; goto s0; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+    f1:
+        Fail(p, 10);
+        goto done;
+    s2:
+        if(p >= _size) goto f2;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s0; }
+    f2:
+        Fail(p, 11);
+        goto done;
+    s3:
+        if(p >= _size) goto f3;
+        c = _input[p];
+        if(c >= 0xA0 && c <= 0xBF) { p++; goto s2; }
+    f3:
+        Fail(p, 12);
+        goto done;
+    s4:
+        if(p >= _size) goto f4;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s2; }
+    f4:
+        Fail(p, 11);
+        goto done;
+    s5:
+        if(p >= _size) goto f5;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0x97) { p++; goto s2; }
+        if(c == 0x98) { p++; goto s6; }
+    f5:
+        Fail(p, 13);
+        goto done;
+    s6:
+        if(p >= _size) goto f6;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBA) { p++; goto s0; }
+    f6:
+        Fail(p, 14);
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_SOMETHING_UTF8_1(int& pos) { // scanner, 7 states
+        int p   = pos;
+        int end = -1;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= ' ' && c <= 0x7F) { p++; goto s1; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+    f0:
+        Fail(p, 15);
+        goto done;
+    s1:
+        end = p;
+        goto done;
+    s2:
+        if(p >= _size) goto f2;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s1; }
+    f2:
+        Fail(p, 11);
+        goto done;
+    s3:
+        if(p >= _size) goto f3;
+        c = _input[p];
+        if(c >= 0xA0 && c <= 0xBF) { p++; goto s2; }
+    f3:
+        Fail(p, 12);
+        goto done;
+    s4:
+        if(p >= _size) goto f4;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s2; }
+    f4:
+        Fail(p, 11);
+        goto done;
+    s5:
+        if(p >= _size) goto f5;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0x97) { p++; goto s2; }
+        if(c == 0x98) { p++; goto s6; }
+    f5:
+        Fail(p, 13);
+        goto done;
+    s6:
+        if(p >= _size) goto f6;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBA) { p++; goto s1; }
+    f6:
+        Fail(p, 14);
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    bool vnt_STRINGCHAR_UTF8_1(int& pos) { // scanner, 7 states
+        int p   = pos;
+        int end = -1;
+        unsigned char c;
+        if(p >= _size) goto f0;
+        c = _input[p];
+        if(c >= '#' && c <= 0x7F) { p++; goto s1; }
+        if(c >= 0xC2 && c <= 0xDF) { p++; goto s2; }
+        if(c == 0xE0) { p++; goto s3; }
+        if(c == 0xE1) { p++; goto s4; }
+        if(c == 0xE2) { p++; goto s5; }
+    f0:
+        Fail(p, 16);
+        goto done;
+    s1:
+        end = p;
+        goto done;
+    s2:
+        if(p >= _size) goto f2;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s1; }
+    f2:
+        Fail(p, 11);
+        goto done;
+    s3:
+        if(p >= _size) goto f3;
+        c = _input[p];
+        if(c >= 0xA0 && c <= 0xBF) { p++; goto s2; }
+    f3:
+        Fail(p, 12);
+        goto done;
+    s4:
+        if(p >= _size) goto f4;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBF) { p++; goto s2; }
+    f4:
+        Fail(p, 11);
+        goto done;
+    s5:
+        if(p >= _size) goto f5;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0x97) { p++; goto s2; }
+        if(c == 0x98) { p++; goto s6; }
+    f5:
+        Fail(p, 13);
+        goto done;
+    s6:
+        if(p >= _size) goto f6;
+        c = _input[p];
+        if(c >= 0x80 && c <= 0xBA) { p++; goto s1; }
+    f6:
+        Fail(p, 14);
+        goto done;
+    done:
+        if(end < 0) return false;
+        pos = end;
+        return true;
+    }
+
+    void ResetFailure() {
+        _fail_pos = 0;
+        _fail_at.SetSize(17);
+        for(int t = 0; t < _fail_at.GetSize(); t++) {
+            _fail_at[t] = -1;
+        }
+    }
+
+    // Records that the TS t failed at pos. Failures before the farthest position are ignored, the others
+    // cost a comparison and two stores, as nothing has to be cleared when the farthest position moves on.
+    bool Fail(int pos, int t) {
+        if(pos >= _fail_pos) {
+            _fail_pos = Utf8Start(pos);
+            _fail_at[t] = _fail_pos;
+        }
+        return false;
+    }
+
+    // Returns the start of the UTF-8 sequence that pos is within, pos itself if it is not within one. The bytes of
+    // <set>, <range> and <notset> beyond ASCII are matched one by one, but fail at the start of the character,
+    // like those of a parser for TCHAR. A failure within a sequence is at or beyond the farthest failure, which
+    // is always at the start of a character, so the start is as well.
+    int Utf8Start(int pos) const {
+        for(int k = 1; k <= 3 && pos < _size && pos-k >= 0 && ((unsigned char) _input[pos-k+1] & 0xC0) == 0x80; k++) {
+            unsigned char c = (unsigned char) _input[pos-k];
+            if((c & 0xC0) != 0x80) {
+                return k < (c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1) ? pos-k : pos; // pos is a stray byte otherwise
+            }
+        }
+        return pos;
+    }
+
+    // Ends a failed parse: if the exported NTS matched, but not the whole input, the end of the input
+    // was expected. pos is set to the farthest failure.
+    bool Error(int& pos, bool matched) {
+        if(matched) {
+            Fail(pos, 0);
+        }
+        pos = _fail_pos;
+        return false;
+    }
+
+    static const TCHAR* TerminalName(int t) {
+        static const TCHAR* names[] = {
+            _T("end of input"),
+            _T("one of \' \\t\\r\\n();,\'"),
+            _T("\'using\', \'namespace\', \'class\', \'public\', \'private\', \'readonly\', \'static\', \'int\', \'in\', \'ref\', \'out\', \'void\', \'bool\', \'true\', \'false\', \'if\', \'else\', \'for\', \'while\', \'return\', \'break\', \'throw\', \'try\', \'catch\', \'finally\'"),
+            _T("\'A\'-\'Z\', \'_\', \'a\'-\'z\'"),
+            _T("\'0\'-\'9\'"),
+            _T("\'\"\'"),
+            _T("\' \'-\'!\'"),
+            _T("\'\\\'"),
+            _T("\'/*\'"),
+            _T("\'*/\'"),
+            _T("\' \'-\'.\', \'0\'-\'U+007F\', \'\\xC2\'-\'\\xE2\'"),
+            _T("\'\\x80\'-\'\\xBF\'"),
+            _T("\'\\xA0\'-\'\\xBF\'"),
+            _T("\'\\x80\'-\'\\x98\'"),
+            _T("\'\\x80\'-\'\\xBA\'"),
+            _T("\' \'-\'U+007F\', \'\\xC2\'-\'\\xE2\'"),
+            _T("\'#\'-\'U+007F\', \'\\xC2\'-\'\\xE2\'"),
+        };
+        return names[t];
+    }
+
+    bool ts(int& pos, const char* s, int slen, int t) {
+        for(int i = 0; i < slen; i++) {
+            if(pos+i >= _size || _input[pos+i] != s[i]) return Fail(pos, t);
+        }
+        pos += slen;
+        return true;
+    }
+
+    bool tc(int& pos, char c, int t) {
+        if(pos >= _size || _input[pos] != c) return Fail(pos, t);
+        pos++;
+        return true;
+    }
+
+    bool tset(int& pos, const char* s, int slen, int t) {
+        for(int i = 0; i < slen; i++) {
+            if(pos < _size && s[i] == _input[pos]) {
+                pos++;
+                return true;
+            }
+        }
+        return Fail(pos, t);
+    }
+
+    bool trange(int& pos, char c1, char c2, int t) {
+        if(pos >= _size || (unsigned char) _input[pos] < (unsigned char) c1 || (unsigned char) _input[pos] > (unsigned char) c2) return Fail(pos, t);
+        pos++;
+        return true;
+    }
+
+    void Out(const char* text, int begin, int end) {
+        SRecord record = { text, begin, end };
+        _out.Add(record);
+    }
+
+    void Flatten(const SOutput& out, CStringA& output) {
+        int size = Flatten(out, NULL);
+        Flatten(out, output.GetBufferSetLength(size));
+        output.ReleaseBuffer(size);
+    }
+
+    // Copies the text of the output into the buffer (if not NULL) and returns its length. The nested
+    // records are expanded with an explicit stack, a range is removed before its last record is
+    // expanded, so right recursive rules do not make the stack grow.
+    int Flatten(const SOutput& out, char* buffer) {
+        int size = 0;
+        _stack.SetSize(0);
+        if(out.begin < out.end) {
+            _stack.Add(out);
+        }
+        while(!_stack.IsEmpty()) {
+            SOutput& top    = _stack[_stack.GetSize()-1];
+            SRecord  record = _out[top.begin++];
+            if(top.begin == top.end) {
+                _stack.SetSize(_stack.GetSize()-1);
+            }
+            if(record.text == NULL) {
+                if(record.begin < record.end) {
+                    SOutput next = { record.begin, record.end };
+                    _stack.Add(next);
+                }
+            } else {
+                if(buffer != NULL) {
+                    memcpy(buffer+size, record.text+record.begin, (record.end-record.begin)*sizeof(char));
+                }
+                size += record.end-record.begin;
+            }
+        }
+        return size;
+    }
+
+};
@@ -0,0 +1,340 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+
+namespace RSPT
+{
+    public class CharSet { // an immutable set of input symbols, stored as a sorted list of disjoint ranges
+
+        public const int MaxChar = 0xFFFF;
+
+        public static readonly CharSet Empty = new CharSet(new List<int>());
+        public static readonly CharSet All   = new CharSet(new List<int>(new int[] { 0, MaxChar }));
+
+        private readonly List<int> _bounds; // pairs of inclusive lower and upper bounds
+
+        private CharSet(List<int> bounds) {
+            _bounds = bounds;
+        }
+
+        public static CharSet Range(int lo, int hi)
+        {
+            if(lo > hi) {
+                return Empty;
+            }
+            return new CharSet(new List<int>(new int[] { lo, hi }));
+        }
+
+        public static CharSet Single(int c)
+        {
+            return Range(c, c);
+        }
+
+        public static CharSet Of(string chars)
+        {
+            CharSet set = Empty;
+            foreach(char c in chars) {
+                set = set.Union(Single(c));
+            }
+            return set;
+        }
+
+        public bool IsEmpty {
+            get { return _bounds.Count == 0; }
+        }
+
+        public int RangeCount {
+            get { return _bounds.Count / 2; }
+        }
+
+        public int RangeLo(int i) { return _bounds[2*i];   }
+        public int RangeHi(int i) { return _bounds[2*i+1]; }
+
+        public bool Contains(int c)
+        {
+            for(int i = 0; i < _bounds.Count; i += 2) {
+                if(c >= _bounds[i] && c <= _bounds[i+1]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        public CharSet Union(CharSet other)
+        {
+            if(other.IsEmpty) return this;
+            if(IsEmpty)       return other;
+            List<int> bounds = new List<int>();
+            int i = 0, j = 0;
+            while(i < _bounds.Count || j < other._bounds.Count) {
+                int lo, hi;
+                if(j >= other._bounds.Count || (i < _bounds.Count && _bounds[i] <= other._bounds[j])) {
+                    lo = _bounds[i]; hi = _bounds[i+1]; i += 2;
+                } else {
+                    lo = other._bounds[j]; hi = other._bounds[j+1]; j += 2;
+                }
+                if(bounds.Count > 0 && lo <= bounds[bounds.Count-1] + 1) {
+                    bounds[bounds.Count-1] = Math.Max(bounds[bounds.Count-1], hi);
+                } else {
+                    bounds.Add(lo);
+                    bounds.Add(hi);
+                }
+            }
+            return new CharSet(bounds);
+        }
+
+        public CharSet Complement()
+        {
+            List<int> bounds = new List<int>();
+            int next = 0;
+            for(int i = 0; i < _bounds.Count; i += 2) {
+                if(_bounds[i] > next) {
+                    bounds.Add(next);
+                    bounds.Add(_bounds[i]-1);
+                }
+                next = _bounds[i+1]+1;
+            }
+            if(next <= MaxChar) {
+                bounds.Add(next);
+                bounds.Add(MaxChar);
+            }
+            return new CharSet(bounds);
+        }
+
+        public CharSet Intersect(CharSet other)
+        {
+            return Complement().Union(other.Complement()).Complement();
+        }
+
+        public bool Intersects(CharSet other)
+        {
+            return !Intersect(other).IsEmpty;
+        }
+
+        public override bool Equals(object obj)
+        {
+            CharSet other = obj as CharSet;
+            if(other == null || other._bounds.Count != _bounds.Count) {
+                return false;
+            }
+            for(int i = 0; i < _bounds.Count; i++) {
+                if(_bounds[i] != other._bounds[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        public override int GetHashCode()
+        {
+            int hash = 17;
+            foreach(int b in _bounds) {
+                hash = hash * 31 + b;
+            }
+            return hash;
+        }
+
+        public override string ToString()
+        {
+            StringBuilder sb = new StringBuilder("[");
+            for(int i = 0; i < _bounds.Count; i += 2) {
+                sb.Append(Format(_bounds[i]));
+                if(_bounds[i+1] > _bounds[i]) {
+                    sb.Append('-');
+                    sb.Append(Format(_bounds[i+1]));
+                }
+            }
+            return sb.Append(']').ToString();
+        }
+
+        private static string Format(int c)
+        {
+            return c > ' ' && c < 127 ? ((char) c).ToString() : string.Format("\\x{0:X2}", c);
+        }
+    }
+
+    public class Analysis { // computes the nullable, FIRST and FOLLOW sets of all NTS of a grammar
+
+        private readonly Dictionary<SymbolNonTerm, bool>    _nullable = new Dictionary<SymbolNonTerm, bool>();
+        private readonly Dictionary<SymbolNonTerm, bool>    _code     = new Dictionary<SymbolNonTerm, bool>();
+        private readonly Dictionary<SymbolNonTerm, CharSet> _first    = new Dictionary<SymbolNonTerm, CharSet>();
+        private readonly Dictionary<SymbolNonTerm, CharSet> _follow   = new Dictionary<SymbolNonTerm, CharSet>();
+        private readonly Dictionary<SymbolNonTerm, bool>    _end      = new Dictionary<SymbolNonTerm, bool>(); // the end of input follows
+
+        public Analysis(Grammar grammar) {
+            foreach(SymbolNonTerm sym in grammar.NonTerms) {
+                _nullable[sym] = false;
+                _code[sym]     = false;
+                _first[sym]    = CharSet.Empty;
+            }
+            bool changed = true;
+            while(changed) { // iterate until a fixpoint is reached, the sets only grow
+                changed = false;
+                foreach(SymbolNonTerm sym in grammar.NonTerms) {
+                    bool    nullable = _nullable[sym];
+                    bool    code     = _code[sym];
+                    CharSet first    = _first[sym];
+                    if(sym.Operand != null) { // an operator table starts with its operand
+                        nullable = _nullable[sym.Operand];
+                        code     = _code[sym.Operand];
+                        first    = _first[sym.Operand];
+                    } else {
+                        foreach(List<Symbol> rule in sym.Rules) {
+                            nullable = nullable || IsNullable(rule);
+                            code     = code     || HasLeadingCode(rule);
+                            first    = first.Union(First(rule));
+                        }
+                    }
+                    if(nullable != _nullable[sym] || code != _code[sym] || !first.Equals(_first[sym])) {
+                        _nullable[sym] = nullable;
+                        _code[sym]     = code;
+                        _first[sym]    = first;
+                        changed = true;
+                    }
+                }
+            }
+
+            foreach(SymbolNonTerm sym in grammar.NonTerms) {
+                _follow[sym] = CharSet.Empty;
+                _end[sym]    = grammar.Exports.Contains(sym);
+            }
+            changed = true;
+            while(changed) {
+                changed = false;
+                foreach(SymbolNonTerm sym in grammar.NonTerms) {
+                    if(sym.Operand != null) { // the operand is followed by the operators or whatever follows the table
+                        foreach(List<Symbol> rule in sym.Rules) {
+                            changed |= AddFollow(sym.Operand, First(rule.GetRange(1, rule.Count-1)), false);
+                        }
+                        changed |= AddFollow(sym.Operand, _follow[sym], _end[sym]);
+                    }
+                    foreach(List<Symbol> rule in sym.Rules) {
+                        for(int i = 0; i < rule.Count; i++) {
+                            SymbolNonTerm sym2 = rule[i] as SymbolNonTerm;
+                            if(sym2 != null) {
+                                List<Symbol> rest = rule.GetRange(i+1, rule.Count-i-1);
+                                changed |= AddFollow(sym2, First(rest), false);
+                                if(IsNullable(rest)) {
+                                    changed |= AddFollow(sym2, _follow[sym], _end[sym]);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        private bool AddFollow(SymbolNonTerm sym, CharSet follow, bool end)
+        {
+            CharSet union = _follow[sym].Union(follow);
+            if(union.Equals(_follow[sym]) && (_end[sym] || !end)) {
+                return false;
+            }
+            _follow[sym] = union;
+            _end[sym]    = _end[sym] || end;
+            return true;
+        }
+
+        public bool IsNullable(SymbolNonTerm sym)
+        {
+            return _nullable[sym];
+        }
+
+        public CharSet First(SymbolNonTerm sym)
+        {
+            return _first[sym];
+        }
+
+        // Returns the set of input symbols that can follow the NTS.
+        public CharSet Follow(SymbolNonTerm sym)
+        {
+            return _follow[sym];
+        }
+
+        // Returns true if the end of the input can follow the NTS.
+        public bool FollowsEnd(SymbolNonTerm sym)
+        {
+            return _end[sym];
+        }
+
+        // Returns true if the rule can match without consuming any input.
+        public bool IsNullable(List<Symbol> rule)
+        {
+            for(int i = 0; i < rule.Count; i++) {
+                if(!IsNullable(rule, ref i)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Returns the set of input symbols a successful match of the rule can start with.
+        public CharSet First(List<Symbol> rule)
+        {
+            CharSet first = CharSet.Empty;
+            for(int i = 0; i < rule.Count; i++) {
+                first = first.Union(First(rule, i));
+                if(!IsNullable(rule, ref i)) {
+                    break;
+                }
+            }
+            return first;
+        }
+
+        // Returns true if the rule may execute source code fragments before consuming its first input symbol.
+        public bool HasLeadingCode(List<Symbol> rule)
+        {
+            for(int i = 0; i < rule.Count; i++) {
+                if(rule[i] is SymbolCode || (rule[i] is SymbolNonTerm && _code[rule[i] as SymbolNonTerm])) {
+                    return true;
+                }
+                if(!IsNullable(rule, ref i)) {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        // Returns the FIRST set of the TS or NTS at the given index, taking preceding instructions into account.
+        public CharSet First(List<Symbol> rule, int i)
+        {
+            Instruction ins = Instruction.TO;
+            for(; i < rule.Count && rule[i] is SymbolInstr; i++) {
+                ins = (rule[i] as SymbolInstr).Instruction;
+            }
+            if(i >= rule.Count) {
+                return CharSet.Empty;
+            } else if(rule[i] is SymbolNonTerm) {
+                return _first[rule[i] as SymbolNonTerm];
+            } else if(rule[i] is SymbolTerm) {
+                string text = (rule[i] as SymbolTerm).Text;
+                switch(ins) {
+                    case Instruction.SET:    return CharSet.Of(text);
+                    case Instruction.RANGE:  return CharSet.Range(text[0], text[1]);
+                    case Instruction.NOTSET: return CharSet.Of(text).Complement();
+                    default:                 return text.Length > 0 ? CharSet.Single(text[0]) : CharSet.Empty;
+                }
+            }
+            return CharSet.Empty;
+        }
+
+        // Returns true if the symbol at the given index can match without consuming any input.
+        // Instructions are skipped, i is advanced to the TS they apply to.
+        private bool IsNullable(List<Symbol> rule, ref int i)
+        {
+            bool single = false; // <set>, <range> and <notset> always consume exactly one input symbol
+            for(; i < rule.Count && rule[i] is SymbolInstr; i++) {
+                Instruction ins = (rule[i] as SymbolInstr).Instruction;
+                single = single || ins == Instruction.SET || ins == Instruction.RANGE || ins == Instruction.NOTSET;
+            }
+            if(i >= rule.Count) {
+                return true;
+            } else if(rule[i] is SymbolNonTerm) {
+                return _nullable[rule[i] as SymbolNonTerm];
+            } else if(rule[i] is SymbolTerm) {
+                return !single && (rule[i] as SymbolTerm).Text.Length == 0;
+            }
+            return true;
+        }
+    }
+}
\ No newline at end of file
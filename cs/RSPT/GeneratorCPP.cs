@@ -7,182 +7,2785 @@ namespace RSPT
 {
     public class GeneratorRecursiveCPP : Generator
     {
-        public GeneratorRecursiveCPP(Grammar grammar) : base(grammar) { }
+        private bool need_ts;
+        private bool need_tc;
+        private bool need_tset;
+        private bool need_trange;
+        private bool need_tnotset;
+        private bool need_lazy;   // TLazy is used for the outputs of NTS whose type needs construction (see IsLazy())
+        private bool opt_profile; // <option:profile> instruments every nt_ function
+        private int  prof_alts;   // number of alternatives generated so far (with <option:profile>)
+        private bool prof_max;    // the steps being generated record the farthest position in posmax (with <option:profile>)
+        private bool prof_plain;  // the choice being generated would have been left-factored or matched with a trie
+        private bool opt_scanner; // <option:scanner> compiles lexical NTS into DFA scanners
+        private bool opt_append;  // <option:append> compiles the output templates of NTS without type into appends to _out
+        private bool opt_events;  // <option:events> reports rules and tokens to a handler instead of computing outputs
+        private bool opt_tree;    // <option:tree> records the rules and tokens as a flat tree instead (implies opt_events)
+        private bool opt_incremental; // <option:incremental> reuses the subtrees of the last tree after Edit() (implies opt_tree)
+        private bool opt_budget;  // <option:budget> limits the number of nt_ calls and the time of a parse
+        private bool opt_utf8;    // <option:utf8> parses UTF-8 input (char) directly, the TS are UTF-8 byte sequences
+        private bool opt_arena;   // <option:arena> allocates semantic values from an arena that is reset by each Parse_X
+        private bool no_output;   // the nt_ functions have no outputs and source code fragments are ignored
+
+        private readonly string        _prefix = ""; // the prefix of the function names, "v" for the functions of Validate_X
+        private GeneratorRecursiveCPP _validator;   // generates the functions of Validate_X
+
+        private List<string> _terminals = new List<string>(); // the names of the TS reported by GetExpected(), shared with _validator
+
+        private List<SymbolNonTerm> _lexical = new List<SymbolNonTerm>(); // the NTS reported as tokens (with <option:events>)
+
+        private SymbolNonTerm _current; // the NTS being generated
+        private bool          _constructed; // the output of the function being generated is constructed on every path (op_X)
+
+        // The destructions due at the end of the blocks being generated, with the _indent of the block they belong to.
+        // IcbDestruct(&output, 1) marks that the own output has been constructed on the current path.
+        private readonly List<KeyValuePair<string, string>> _cleanups = new List<KeyValuePair<string, string>>();
+
+        private readonly Dictionary<SymbolNonTerm, Scanner> _scanners = new Dictionary<SymbolNonTerm, Scanner>();
+        private readonly List<SymbolNonTerm>                _unused   = new List<SymbolNonTerm>(); // lexical NTS only used by scanners
+
+        public GeneratorRecursiveCPP(Grammar grammar) : base(grammar)
+        {
+            _terminals.Add("end of input");
+        }
+
+        // Creates the generator of the functions of Validate_X for the recognizer of the grammar (see Grammar.Recognizer()).
+        // Without actions, more NTS are lexical and can be compiled into scanners (with <option:scanner>). Their <memo> is
+        // dropped, as a scanner is cheaper than remembering its result.
+        private GeneratorRecursiveCPP(Grammar recognizer, GeneratorRecursiveCPP parser) : base(recognizer)
+        {
+            _prefix     = "v";
+            no_output   = true;
+            opt_scanner = parser.opt_scanner;
+            opt_budget  = parser.opt_budget;
+            opt_utf8    = parser.opt_utf8;
+            _terminals  = parser._terminals;
+            List<SymbolNonTerm> memo = new List<SymbolNonTerm>();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(sym.Memo) {
+                    memo.Add(sym);
+                    sym.Memo = false;
+                }
+            }
+            if(opt_scanner) {
+                FindScanners();
+            }
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                sym.Memo = memo.Contains(sym) && !_scanners.ContainsKey(sym) && !_unused.Contains(sym);
+                sym.Type = "void*";
+            }
+        }
 
         public override void Generate(TextWriter writer)
         {
-            if(_grammar.Class == null) {
-                _grammar.Class = "CParser";
+            if(_grammar.Class == null) {
+                _grammar.Class = "CParser";
+            }
+            opt_utf8 = _grammar.Options.Contains("utf8");
+            if(opt_utf8) {
+                _grammar.EncodeUtf8();
+            }
+            if(_grammar.Type == null) {
+                _grammar.Type = opt_utf8 ? "char" : "TCHAR";
+            }
+            opt_incremental = _grammar.Options.Contains("incremental");
+            opt_tree    = _grammar.Options.Contains("tree") || opt_incremental;
+            opt_events  = _grammar.Options.Contains("events") || opt_tree;
+            string events = opt_incremental ? "incremental" : opt_tree ? "tree" : "events";
+            opt_profile = Option("profile", opt_events, events);
+            if(opt_events) {
+                foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                    sym.Memo = false; // a remembered result would not repeat the events
+                }
+                _lexical = Scanner.FindLexical(_grammar);
+            }
+            opt_scanner = Option("scanner", opt_profile, "profile");
+            if(opt_scanner) {
+                FindScanners();
+            }
+            opt_append = Option("append", opt_events, events);
+            opt_budget = _grammar.Options.Contains("budget");
+            opt_arena  = Option("arena", opt_events, events);
+            no_output  = opt_events;
+            _validator = new GeneratorRecursiveCPP(_grammar.Recognizer(), this);
+            bool sync  = HasSync() || _validator.HasSync();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(sym.Type == null) {
+                    sym.Type = opt_append ? "SOutput" : "void*";
+                }
+                if(IsAppend(sym) && sym.Memo) {
+                    throw new Exception(string.Format("{0}: <memo> cannot be used for NTS without type with <option:append>.", sym.Name));
+                }
+                if(IsAppend(sym) && sym.Operand != null) {
+                    throw new Exception(string.Format("{0}: <operators:...> needs a type with <option:append>.", sym.Name));
+                }
+            }
+            writer.WriteLine("//");
+            writer.WriteLine("// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).");
+            writer.WriteLine("//       Do not modify the contents of this file as it will be overwritten!");
+            writer.WriteLine("//");
+            writer.WriteLine("#pragma once;");
+            foreach(string include in _grammar.Includes) {
+                writer.WriteLine("#include {0}", include);
+            }
+            if(opt_profile) {
+                writer.WriteLine("#ifdef RSPT_PROFILE_CYCLES");
+                writer.WriteLine("#include <intrin.h>");
+                writer.WriteLine("#endif");
+            }
+            if(_grammar.Namespace != null) {
+                writer.WriteLine("");
+                writer.WriteLine("namespace {0} {{", _grammar.Namespace);
+            }
+            writer.WriteLine("");
+            if(opt_events && !opt_tree) {
+                GenerateHandler(writer);
+                writer.WriteLine("template <class THandler = {0}Handler>", _grammar.Class);
+            }
+            writer.WriteLine("class {0}", _grammar.Class);
+            writer.WriteLine("{");
+            if(opt_tree) {
+                GenerateTreeTypes(writer);
+            }
+            writer.WriteLine("private:");
+            writer.WriteLine("    const {0}* _input;", _grammar.Type);
+            writer.WriteLine("    int _size;");
+            if(opt_append) {
+                GenerateAppendInterface(writer);
+            }
+            if(opt_arena) {
+                GenerateArenaInterface(writer);
+            }
+            if(opt_tree) {
+                GenerateTreeInterface(writer);
+            } else if(opt_events) {
+                GenerateEventsInterface(writer);
+            }
+            writer.WriteLine("");
+            writer.WriteLine("    int            _fail_pos; // the farthest position at which a TS failed");
+            writer.WriteLine("    TIcbArray<int> _fail_at;  // the last position at which each TS failed, the TS expected at _fail_pos failed there");
+            if(opt_budget) {
+                GenerateBudgetInterface(writer);
+            }
+            if(sync) {
+                GenerateSyncInterface(writer);
+            }
+            writer.WriteLine("");
+            writer.WriteLine("public:");
+            // the initializers in the order of the declarations above, which compilers warn about otherwise
+            string init1 = (opt_arena ? ", _arena_set(NULL)" : "") + (opt_incremental ? ", _parsed(false), _edited(false)" : "");
+            string init2 = sync ? ", _threads(1)" : "";
+            string body  = (opt_profile ? "ProfileReset(); " : "") + (opt_budget ? "SetBudget(0, 0); " : "");
+            writer.WriteLine("    {0}() : _input(NULL), _size(0){1}, _fail_pos(0){2} {{ {3}}}", _grammar.Class, init1, init2, body);
+            foreach(SymbolNonTerm sym in _grammar.Exports) {
+                writer.WriteLine("");
+                if(opt_tree) {
+                    writer.WriteLine("    bool Parse_{0}(const {1}* input, int size, int& pos) {{", sym.Name, _grammar.Type);
+                } else if(opt_events) {
+                    writer.WriteLine("    bool Parse_{0}(const {1}* input, int size, THandler& handler, int& pos) {{", sym.Name, _grammar.Type);
+                } else {
+                    writer.WriteLine("    bool Parse_{0}(const {1}* input, int size, {2}& output, int& pos) {{", sym.Name, _grammar.Type, IsAppend(sym) ? Output() : sym.Type);
+                }
+                writer.WriteLine("        _input = input;");
+                writer.WriteLine("        _size  = size;");
+                writer.WriteLine("        pos    = 0;");
+                writer.WriteLine("        ResetFailure();");
+                if(opt_budget) {
+                    writer.WriteLine("        ResetBudget();");
+                }
+                if(opt_arena) {
+                    writer.WriteLine("        Arena().Reset();");
+                }
+                foreach(SymbolNonTerm sym2 in _grammar.NonTerms) {
+                    if(sym2.Memo) {
+                        writer.WriteLine("        _memo_{0}_pos = -1;", sym2.Name);
+                    }
+                }
+                if(opt_incremental) {
+                    GenerateIncrementalParse(writer, sym);
+                } else if(opt_events) {
+                    if(HasSync()) {
+                        writer.WriteLine("        Speculate(SYNC_PARSE);");
+                    }
+                    writer.WriteLine("        Rollback(0);");
+                    writer.WriteLine("        bool ok = nt_{0}(pos);", sym.Name);
+                    GenerateUnsync(writer, sym);
+                    writer.WriteLine("        if(!ok || pos != _size{0}) {{", Exceeded(" || _exceeded"));
+                    writer.WriteLine("            return Error(pos, ok);");
+                    writer.WriteLine("        }");
+                    if(_lexical.Contains(sym)) {
+                        writer.WriteLine("        {0};", TokenCall(sym, "0", "pos"));
+                    }
+                    if(HasSync()) {
+                        writer.WriteLine("        Copy();");
+                    }
+                    if(opt_tree) {
+                        writer.WriteLine("        _tree[0].next = -1; // the root has no sibling");
+                    } else {
+                        writer.WriteLine("        Replay(handler);");
+                    }
+                    writer.WriteLine("        return true;");
+                } else if(IsAppend(sym)) {
+                    writer.WriteLine("        _out.SetSize(0);");
+                    writer.WriteLine("        SOutput out;");
+                    writer.WriteLine("        bool ok = nt_{0}(pos, out);", sym.Name);
+                    writer.WriteLine("        if(!ok || pos != _size{0}) {{", Exceeded(" || _exceeded"));
+                    writer.WriteLine("            return Error(pos, ok);");
+                    writer.WriteLine("        }");
+                    writer.WriteLine("        Flatten(out, output);");
+                    writer.WriteLine("        return true;");
+                } else if(IsLazy(sym.Type)) {
+                    writer.WriteLine("        TLazy<{0}> lazy; // nt_{1} constructs its output only if it succeeds", sym.Type, sym.Name);
+                    writer.WriteLine("        {0}& out = *lazy;", sym.Type);
+                    writer.WriteLine("        bool ok = nt_{0}(pos, out);", sym.Name);
+                    writer.WriteLine("        if(ok) {");
+                    writer.WriteLine("            output = out;");
+                    writer.WriteLine("            IcbDestruct(&out, 1);");
+                    writer.WriteLine("        }");
+                    writer.WriteLine("        return (ok && pos == _size{0}) || Error(pos, ok);", Exceeded(" && !_exceeded"));
+                    need_lazy = true;
+                } else {
+                    writer.WriteLine("        /*output = default({0});*/", sym.Type); // TODO: fix init 
+                    writer.WriteLine("        bool ok = nt_{0}(pos, output);", sym.Name);
+                    writer.WriteLine("        return (ok && pos == _size{0}) || Error(pos, ok);", Exceeded(" && !_exceeded"));
+                }
+                writer.WriteLine("    }");
+            }
+            _validator.GenerateValidate(writer);
+            GenerateErrorInterface(writer);
+            if(opt_budget) {
+                GenerateBudgetAccessors(writer);
+            }
+            if(opt_arena) {
+                GenerateArenaAccessors(writer);
+            }
+            if(sync) {
+                GenerateSyncAccessors(writer);
+            }
+            if(opt_tree) {
+                writer.WriteLine("");
+                writer.WriteLine("    // The tree of the last successful parse, its root is node 0. As the nodes refer to each other by");
+                writer.WriteLine("    // index, the tree can be copied or written as one block of GetSize() * sizeof(SNode) bytes.");
+                writer.WriteLine("    const TIcbArray<SNode>& GetTree() const {");
+                writer.WriteLine("        return _tree;");
+                writer.WriteLine("    }");
+            }
+            if(opt_incremental) {
+                GenerateEditInterface(writer);
+            }
+            if(opt_profile) {
+                GenerateProfileInterface(writer);
+            }
+            writer.WriteLine("");
+            writer.WriteLine("private:");
+            GenerateRules(writer);
+            _validator.GenerateRules(writer);
+            need_ts      = need_ts      || _validator.need_ts;
+            need_tc      = need_tc      || _validator.need_tc;
+            need_tset    = need_tset    || _validator.need_tset;
+            need_trange  = need_trange  || _validator.need_trange;
+            need_tnotset = need_tnotset || _validator.need_tnotset;
+            GenerateTerminals(writer);
+            if(need_lazy) {
+                GenerateLazy(writer);
+            }
+            if(opt_append) {
+                GenerateAppendImplementation(writer);
+            }
+            if(opt_arena) {
+                GenerateArenaImplementation(writer);
+            }
+            if(opt_tree) {
+                GenerateTreeImplementation(writer);
+            } else if(opt_events) {
+                GenerateEventsImplementation(writer);
+            }
+            if(opt_budget) {
+                GenerateBudgetImplementation(writer);
+            }
+            if(sync) {
+                GenerateSyncImplementation(writer);
+            }
+            if(opt_profile) {
+                GenerateProfileImplementation(writer);
+            }
+            foreach(string code in _grammar.Codes) {
+                writer.WriteLine("    {0}", code);
+            }
+            writer.WriteLine("};");
+            if(_grammar.Namespace != null) {
+                writer.WriteLine("}");
+            }
+        }
+
+        private void GenerateRules(TextWriter writer)
+        {
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(!_unused.Contains(sym)) {
+                    GenerateRule(writer, sym);
+                }
+            }
+        }
+
+        // Generates Validate_X for the exported NTS, which recognizes the same input as Parse_X, but without
+        // computing outputs or running source code fragments.
+        private void GenerateValidate(TextWriter writer)
+        {
+            foreach(SymbolNonTerm sym in _grammar.Exports) {
+                writer.WriteLine("");
+                writer.WriteLine("    bool Validate_{0}(const {1}* input, int size, int& pos) {{", sym.Name, _grammar.Type);
+                writer.WriteLine("        _input = input;");
+                writer.WriteLine("        _size  = size;");
+                writer.WriteLine("        pos    = 0;");
+                writer.WriteLine("        ResetFailure();");
+                if(opt_budget) {
+                    writer.WriteLine("        ResetBudget();");
+                }
+                foreach(SymbolNonTerm sym2 in _grammar.NonTerms) {
+                    if(sym2.Memo) {
+                        writer.WriteLine("        _{0}memo_{1}_pos = -1;", _prefix, sym2.Name);
+                    }
+                }
+                if(HasSync()) {
+                    writer.WriteLine("        Speculate(SYNC_VALIDATE);");
+                }
+                writer.WriteLine("        bool ok = {0}(pos);", Nt(sym));
+                GenerateUnsync(writer, sym);
+                writer.WriteLine("        return (ok && pos == _size{0}) || Error(pos, ok);", Exceeded(" && !_exceeded"));
+                writer.WriteLine("    }");
+            }
+        }
+
+        private void GenerateRule(TextWriter writer, SymbolNonTerm sym)
+        {
+            _current = sym;
+            if(sym.Memo) {
+                GenerateMemo(writer, sym);
+            }
+            if(sym.Operand != null) {
+                GenerateOperators(writer, sym);
+                return;
+            }
+            if(_scanners.ContainsKey(sym)) {
+                GenerateScanner(writer, sym, _scanners[sym]);
+                return;
+            }
+            writer.WriteLine("    {0}bool {1}{2}(int& pos{3}) {{", sym.Inline ? "__forceinline " : "", Nt(sym), sym.Memo ? "_body" : "", OutputParam(sym, UsesOutput(sym)));
+            GenerateBudgetCheck(writer);
+            if(IsSync(sym)) {
+                writer.WriteLine("        if(_synced.GetSize() > 0 && {0}Synced({1}, pos)) return true;", _prefix, _grammar.NonTerms.IndexOf(sym));
+            }
+            writer.WriteLine("        int pos0 = pos;");
+            if(IsAppend(sym)) {
+                writer.WriteLine("        output.begin = output.end = 0;");
+            }
+            if(IsEvents(sym)) {
+                GenerateReuse(writer, sym);
+                writer.WriteLine("        int mark0 = Mark();");
+                writer.WriteLine("        {0};", EnterCall(sym));
+            }
+            if(opt_profile) {
+                writer.WriteLine("        CProfileScope prof(this, {0}, pos0);", _grammar.NonTerms.IndexOf(sym));
+            }
+            List<int> alts = new List<int>();
+            for(int i = 0; i < sym.Rules.Count; i++) {
+                alts.Add(i);
+            }
+            prof_plain = false;
+            GenerateChoice(writer, sym, alts, 0, 1);
+            if(prof_plain) {
+                Console.WriteLine("WARNING: {0}: Alternatives are not left-factored or matched with a trie, <option:profile> counts each one separately.", sym.Name);
+            }
+            bool emptyclause = false;
+            foreach(List<Symbol> rule in sym.Rules) {
+                if(rule.Count == 0) {
+                    emptyclause = true;
+                }
+            }
+            if(!emptyclause) {
+                if(IsEvents(sym)) {
+                    writer.WriteLine("        {0}(mark0);", opt_incremental ? "Cancel" : "Rollback");
+                }
+                writer.WriteLine("        return false;");
+            }
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Generates the alternatives alts of sym, which all start with the same offset symbols (already
+        // generated, idx is the number of the next posN). Consecutive alternatives that share further
+        // leading symbols are left-factored: the common symbols are parsed once, then the alternatives
+        // branch. As the parse of the common symbols is the same for all of them, ordered choice and the
+        // numbering of posN and outputN are preserved. Profiling needs separate alternatives, so factoring
+        // is disabled with <option:profile>. With <option:append>, the output appended by a failed alternative
+        // is removed again before the next one is tried.
+        private void GenerateChoice(TextWriter writer, SymbolNonTerm sym, List<int> alts, int offset, int idx)
+        {
+            bool rollback = false;
+            foreach(int alt in alts) {
+                rollback = rollback || NeedsRollback(sym, sym.Rules[alt], offset);
+            }
+            if(rollback) {
+                writer.WriteLine("        {0}int mark{1} = {2};", _indent, idx, opt_events ? "Mark()" : "_out.GetSize()");
+            }
+            int i = 0;
+            while(i < alts.Count) {
+                int keywords = 0;
+                while(i+keywords < alts.Count && IsKeyword(sym.Rules[alts[i+keywords]], offset)) {
+                    keywords++;
+                }
+                if(keywords > 1 && opt_profile) {
+                    prof_plain = true;
+                } else if(keywords > 1) {
+                    GenerateKeywords(writer, sym, alts.GetRange(i, keywords), offset, idx);
+                    i += keywords;
+                    continue;
+                }
+                List<Symbol> rule   = sym.Rules[alts[i]];
+                List<int>    group  = new List<int>();
+                int          prefix = rule.Count;
+                group.Add(alts[i++]);
+                while(i < alts.Count) {
+                    int common = CommonPrefix(rule, sym.Rules[alts[i]], offset);
+                    if(common == offset) {
+                        break;
+                    }
+                    if(opt_profile) {
+                        prof_plain = true;
+                        break;
+                    }
+                    prefix = Math.Min(prefix, common);
+                    group.Add(alts[i++]);
+                }
+                string indent = _indent;
+                writer.WriteLine("        {0}if(true) {{", _indent);
+                prof_max = opt_profile && rule.FindIndex(offset, delegate(Symbol s) { return s is SymbolTerm || s is SymbolNonTerm; }) >= 0;
+                if(prof_max) {
+                    writer.WriteLine("            int posmax = pos0;");
+                }
+                if(group.Count == 1) {
+                    int end = GenerateSteps(writer, rule, offset, rule.Count, idx);
+                    GenerateExit(writer, "pos" + (end-1));
+                    writer.WriteLine("        {0}    pos = pos{1};", _indent, end-1);
+                    if(opt_profile) {
+                        writer.WriteLine("        {0}    prof.Success({1}, pos);", _indent, prof_alts);
+                    }
+                    GenerateReturn(writer, "return true");
+                    CloseSteps(writer, indent);
+                    if(prof_max) {
+                        writer.WriteLine("            prof.Failure({0}, posmax);", prof_alts);
+                    }
+                    if(opt_profile) {
+                        prof_alts++;
+                    }
+                } else {
+                    int end = GenerateSteps(writer, rule, offset, prefix, idx);
+                    Indent(4);
+                    GenerateChoice(writer, sym, group, prefix, end);
+                    Indent(-4);
+                    CloseSteps(writer, indent);
+                }
+                CloseBlock(writer);
+                foreach(int alt in group) {
+                    if(NeedsRollback(sym, sym.Rules[alt], offset)) {
+                        writer.WriteLine("        {0}{1}(mark{2});", _indent, opt_events ? "Rollback" : "_out.SetSize", idx);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Returns true if the alternative may append to _out (<option:append>) or _events (<option:events>) after
+        // the offset symbols and still fail: if it calls a NTS or if an output template is followed by further symbols.
+        private bool NeedsRollback(SymbolNonTerm sym, List<Symbol> rule, int offset)
+        {
+            if(!IsAppend(sym) && !IsEvents(sym)) {
+                return false;
+            }
+            bool code = false;
+            for(int i = offset; i < rule.Count; i++) {
+                if(rule[i] is SymbolNonTerm || (code && rule[i] is SymbolTerm)) {
+                    return true;
+                }
+                code = code || (rule[i] is SymbolCode && opt_append);
+            }
+            return false;
+        }
+
+        private class Keyword { // a node of the trie built by GenerateKeywords
+            public readonly SortedDictionary<char, Keyword> Next = new SortedDictionary<char, Keyword>();
+            public int Alt = int.MaxValue; // the first alternative whose keyword ends at this node
+            public int Min = int.MaxValue; // the first alternative whose keyword ends at this node or below
+        }
+
+        // Returns true if the alternative continues with a TS after the offset symbols and the TS is followed
+        // by source code fragments only, so that the alternative succeeds if and only if the TS matches.
+        private static bool IsKeyword(List<Symbol> rule, int offset)
+        {
+            if(offset >= rule.Count || !(rule[offset] is SymbolTerm) || (rule[offset] as SymbolTerm).Text.Length == 0) {
+                return false;
+            }
+            for(int i = offset+1; i < rule.Count; i++) {
+                if(!(rule[i] is SymbolCode)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Generates consecutive alternatives of the form 'keyword' {code} as a trie of nested switch and if
+        // statements, so every input symbol is read once instead of once per keyword. Ordered choice takes the
+        // first alternative whose keyword is a prefix of the input. All such keywords lie on the path through
+        // the trie, so the trie records the first of them seen so far and only descends into subtrees that
+        // contain an earlier alternative.
+        private void GenerateKeywords(TextWriter writer, SymbolNonTerm sym, List<int> alts, int offset, int idx)
+        {
+            Keyword root = new Keyword();
+            bool    code = false;
+            for(int k = 0; k < alts.Count; k++) {
+                List<Symbol> rule = sym.Rules[alts[k]];
+                string       text = (rule[offset] as SymbolTerm).Text;
+                Keyword      node = root;
+                int          hide = int.MaxValue;
+                node.Min = Math.Min(node.Min, k);
+                foreach(char c in text) {
+                    Keyword next;
+                    if(!node.Next.TryGetValue(c, out next)) {
+                        next = new Keyword();
+                        node.Next.Add(c, next);
+                    }
+                    node     = next;
+                    node.Min = Math.Min(node.Min, k);
+                    hide     = Math.Min(hide, node.Alt);
+                }
+                node.Alt = Math.Min(node.Alt, k);
+                code     = code || (rule.Count > offset+1 && !no_output);
+                if(hide < k && _prefix.Length == 0) { // the functions of Validate_X have the same alternatives
+                    Console.WriteLine("WARNING: {0}: Alternative {1} can never match, alternative {2} matches first.", sym.Name, alts[k]+1, alts[hide]+1);
+                }
+            }
+
+            string indent = _indent;
+            writer.WriteLine("        {0}if(true) {{ // {1} keywords", _indent, alts.Count);
+            writer.WriteLine("        {0}    int kw = 0; // the alternative that matched", _indent);
+            writer.WriteLine("        {0}    int pos{1} = pos{2};", _indent, idx, idx-1);
+            GenerateTrie(writer, root, 0, int.MaxValue, idx);
+            List<string> keywords = new List<string>();
+            foreach(int alt in alts) {
+                keywords.Add(Display((sym.Rules[alt][offset] as SymbolTerm).Text));
+            }
+            writer.WriteLine("        {0}    if(kw == 0) {{", _indent);
+            writer.WriteLine("        {0}        Fail(pos{1}, {2});", _indent, idx-1, Terminal(string.Join(", ", keywords.ToArray())));
+            writer.WriteLine("        {0}    }}", _indent);
+            if(!code) {
+                writer.WriteLine("        {0}    if(kw != 0) {{", _indent);
+                Indent(4);
+                GenerateExit(writer, "pos" + idx);
+                writer.WriteLine("        {0}    pos = pos{1};", _indent, idx);
+                GenerateReturn(writer, "return true");
+                Indent(-4);
+                writer.WriteLine("        {0}    }}", _indent);
+            } else {
+                writer.WriteLine("        {0}    switch(kw) {{", _indent);
+                for(int k = 0; k < alts.Count; k++) {
+                    List<Symbol> rule = sym.Rules[alts[k]];
+                    writer.WriteLine("        {0}        case {1}: {{", _indent, k+1);
+                    Indent(8);
+                    GenerateSteps(writer, rule, offset+1, rule.Count, idx+1);
+                    writer.WriteLine("        {0}    pos = pos{1};", _indent, idx);
+                    GenerateReturn(writer, "return true");
+                    Indent(-8);
+                    writer.WriteLine("        {0}        }}", _indent);
+                }
+                writer.WriteLine("        {0}    }}", _indent);
+            }
+            writer.WriteLine("        {0}}}", indent);
+        }
+
+        // Generates the tests of the input symbols following the node at the given depth. best is the first
+        // alternative matched on the path to the node, kw and pos{idx} are set when an earlier one matches.
+        private void GenerateTrie(TextWriter writer, Keyword node, int depth, int best, int idx)
+        {
+            List<char> chars = new List<char>();
+            foreach(KeyValuePair<char, Keyword> next in node.Next) {
+                if(next.Value.Min < best) {
+                    chars.Add(next.Key);
+                }
+            }
+            if(chars.Count == 1) { // test a chain of nodes with a single subtree at once
+                List<char> chain = new List<char>();
+                Keyword    last  = node;
+                do {
+                    char c = chars[0];
+                    chain.Add(c);
+                    last = last.Next[c];
+                    chars.Clear();
+                    foreach(KeyValuePair<char, Keyword> next in last.Next) {
+                        if(next.Value.Min < best) {
+                            chars.Add(next.Key);
+                        }
+                    }
+                } while(last.Alt >= best && chars.Count == 1);
+                string cond = string.Format("{0} <= _size", Offset(idx-1, depth+chain.Count));
+                for(int i = 0; i < chain.Count; i++) {
+                    cond += string.Format(" && _input[{0}] == {1}", Offset(idx-1, depth+i), Char(chain[i]));
+                }
+                writer.WriteLine("        {0}    if({1}) {{", _indent, cond);
+                Indent(4);
+                GenerateAccept(writer, last, depth+chain.Count, ref best, idx);
+                GenerateTrie(writer, last, depth+chain.Count, best, idx);
+                Indent(-4);
+                writer.WriteLine("        {0}    }}", _indent);
+            } else if(chars.Count > 1) {
+                writer.WriteLine("        {0}    if({1} < _size) {{", _indent, Offset(idx-1, depth));
+                writer.WriteLine("        {0}        switch(_input[{1}]) {{", _indent, Offset(idx-1, depth));
+                foreach(char c in chars) {
+                    Keyword next  = node.Next[c];
+                    int     best2 = best;
+                    writer.WriteLine("        {0}            case {1}:", _indent, Char(c));
+                    Indent(12);
+                    GenerateAccept(writer, next, depth+1, ref best2, idx);
+                    GenerateTrie(writer, next, depth+1, best2, idx);
+                    writer.WriteLine("        {0}    break;", _indent);
+                    Indent(-12);
+                }
+                writer.WriteLine("        {0}        }}", _indent);
+                writer.WriteLine("        {0}    }}", _indent);
+            }
+        }
+
+        private void GenerateAccept(TextWriter writer, Keyword node, int depth, ref int best, int idx)
+        {
+            if(node.Alt < best) {
+                best = node.Alt;
+                writer.WriteLine("        {0}    kw = {1};", _indent, best+1);
+                writer.WriteLine("        {0}    pos{1} = {2};", _indent, idx, Offset(idx-1, depth));
+            }
+        }
+
+        private static string Offset(int idx, int depth)
+        {
+            return depth > 0 ? string.Format("pos{0}+{1}", idx, depth) : "pos" + idx;
+        }
+
+        // Generates a NTS with <operators:xxx> as a precedence climbing loop. op_X parses an operand, followed by as many
+        // operators with a precedence of at least prec as possible. The right operand of an operator is parsed by op_X
+        // with the precedence of the operator (right associative) or one more (left associative), so the depth of calls
+        // per operand does not grow with the number of precedence levels. Each alternative has the form
+        // <left:n> or <right:n>, followed by the operator, X (for the right operand) and source code fragments.
+        // Within them, output is the left operand, pos0 is the position of the operator.
+        private void GenerateOperators(TextWriter writer, SymbolNonTerm sym)
+        {
+            if(sym.Operand.Type != sym.Type) {
+                throw new Exception(string.Format("{0}: The operand {1} must be of the same type.", sym.Name, sym.Operand.Name));
+            }
+            writer.WriteLine("    {0}bool {1}{2}(int& pos{3}) {{", sym.Inline ? "__forceinline " : "", Nt(sym), sym.Memo ? "_body" : "", OutputParam(sym));
+            if(IsEvents(sym)) {
+                writer.WriteLine("        int pos0  = pos;");
+                GenerateReuse(writer, sym);
+                writer.WriteLine("        int mark0 = Mark();");
+                writer.WriteLine("        {0};", EnterCall(sym));
+                writer.WriteLine("        if({0}(pos, 0)) {{", Op(sym));
+                writer.WriteLine("            {0};", ExitCall(sym, "pos"));
+                writer.WriteLine("            return true;");
+                writer.WriteLine("        }");
+                writer.WriteLine("        {0}(mark0);", opt_incremental ? "Cancel" : "Rollback");
+                writer.WriteLine("        return false;");
+            } else if(opt_profile) {
+                writer.WriteLine("        CProfileScope prof(this, {0}, pos);", _grammar.NonTerms.IndexOf(sym));
+                writer.WriteLine("        if({0}(pos{1}, 0)) {{", Op(sym), OutputArg("output"));
+                writer.WriteLine("            prof.Success(pos);");
+                writer.WriteLine("            return true;");
+                writer.WriteLine("        }");
+                writer.WriteLine("        return false;");
+                prof_alts += sym.Rules.Count; // the alternatives of operators are not counted
+            } else {
+                writer.WriteLine("        return {0}(pos{1}, 0);", Op(sym), OutputArg("output"));
+            }
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    bool {0}(int& pos{1}, int prec) {{", Op(sym), OutputParam(sym));
+            GenerateBudgetCheck(writer);
+            writer.WriteLine("        if(!{0}(pos{1})) {{", Nt(sym.Operand), OutputArg("output"));
+            writer.WriteLine("            return false;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        while(true) {");
+            writer.WriteLine("            int pos0 = pos;");
+            if(IsEvents(sym)) {
+                writer.WriteLine("            int mark0 = Mark();");
+            }
+            prof_max = false; // the alternatives of operators are not counted
+            Indent(4);
+            _constructed = true; // by the operand
+            foreach(List<Symbol> rule in sym.Rules) {
+                int self = rule.LastIndexOf(sym);
+                SymbolInstr assoc = rule.Count > 0 ? rule[0] as SymbolInstr : null;
+                if(assoc == null || (assoc.Instruction != Instruction.LEFT && assoc.Instruction != Instruction.RIGHT) || self < 1 || rule[self-1] is SymbolInstr ||
+                   rule.FindIndex(self+1, delegate(Symbol s) { return !(s is SymbolCode); }) >= 0) {
+                    throw new Exception(string.Format("{0}: Invalid operator, expected: <left:n> or <right:n>, the operator, {0} and source code.", sym.Name));
+                }
+                int prec = assoc.Precedence;
+                writer.WriteLine("        {0}if(prec <= {1}) {{", _indent, prec);
+                string indent = _indent;
+                int idx = GenerateSteps(writer, rule, 1, self, 1);
+                if(IsLazy(sym.Type)) {
+                    GenerateLazyOutput(writer, sym.Type, "output" + idx, idx);
+                } else if(!no_output) {
+                    writer.WriteLine("        {0}    {1} output{2} /*= default({1})*/;", _indent, sym.Type, idx); // TODO: fix init 
+                }
+                writer.WriteLine("        {0}    int pos{1} = pos{2};", _indent, idx, idx-1);
+                writer.WriteLine("        {0}    if({1}(pos{2}{3}, {4})) {{", _indent, Op(sym), idx, OutputArg("output" + idx), assoc.Instruction == Instruction.LEFT ? prec+1 : prec);
+                Indent(4);
+                if(IsLazy(sym.Type)) {
+                    _cleanups.Add(new KeyValuePair<string, string>(_indent, string.Format("IcbDestruct(&output{0}, 1);", idx)));
+                }
+                idx = GenerateSteps(writer, rule, self+1, rule.Count, idx+1);
+                writer.WriteLine("        {0}    pos = pos{1};", _indent, idx-1);
+                GenerateReturn(writer, "continue");
+                CloseSteps(writer, indent);
+                CloseBlock(writer);
+                if(IsEvents(sym)) {
+                    writer.WriteLine("        {0}Rollback(mark0);", _indent);
+                }
+            }
+            Indent(-4);
+            _constructed = false;
+            writer.WriteLine("            return true;");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Returns the end of the leading symbols that rule1 and rule2 have in common, starting at offset. Only TS and NTS
+        // (together with their instructions) are common symbols, but not source code fragments and not NTS with <to:xxx>
+        // because their result may depend on the output of the preceding alternative.
+        private static int CommonPrefix(List<Symbol> rule1, List<Symbol> rule2, int offset)
+        {
+            int i = offset;
+            while(true) {
+                int j = i;
+                while(j < rule1.Count && rule1[j] is SymbolInstr && (rule1[j] as SymbolInstr).Instruction != Instruction.TO) {
+                    j++;
+                }
+                if(j >= rule1.Count || j >= rule2.Count || !(rule1[j] is SymbolTerm || rule1[j] is SymbolNonTerm)) {
+                    return i;
+                }
+                for(int k = i; k <= j; k++) {
+                    if(rule1[k].GetType() != rule2[k].GetType() || rule1[k].Token != rule2[k].Token) {
+                        return i;
+                    }
+                }
+                i = j + 1;
+            }
+        }
+
+        // Generates the nested if statements for the symbols [start, end) of the rule.
+        // idx is the number of the first posN, returns the number of the next posN.
+        private int GenerateSteps(TextWriter writer, List<Symbol> rule, int start, int end, int idx)
+        {
+            string ins_to     = null;
+            bool   ins_set    = false;
+            bool   ins_range  = false;
+            bool   ins_notset = false;
+            for(int i = start; i < end; i++) {
+                Symbol sym2 = rule[i];
+                if(sym2 is SymbolNonTerm) {
+                    SymbolNonTerm sym2nt = sym2 as SymbolNonTerm;
+                    bool          lazy   = IsLazy(sym2nt.Type);
+                    string        to     = null; // the target of <to:xxx>, which is assigned from a lazy output
+                    if(no_output) {
+                        ins_to = null; // there are no outputs
+                    } else if(ins_to == null || lazy) {
+                        if(ins_to != null && sym2nt.Memo) {
+                            throw new Exception(string.Format("{0}: <memo> cannot be used for NTS with <to:xxx>.", sym2nt.Name));
+                        }
+                        to     = ins_to;
+                        ins_to = "output"+idx;
+                        if(lazy) {
+                            GenerateLazyOutput(writer, sym2nt.Type, ins_to, idx);
+                        } else {
+                            writer.WriteLine("        {0}    {1} {2} /*= default({1})*/;", _indent, sym2nt.Type, ins_to); // TODO: fix init 
+                        }
+                    } else if(sym2nt.Memo) {
+                        throw new Exception(string.Format("{0}: <memo> cannot be used for NTS with <to:xxx>.", sym2nt.Name));
+                    }
+                    writer.WriteLine("        {0}    int pos{1} = pos{2};", _indent, idx, idx-1);
+                    writer.WriteLine("        {0}    if({1}(pos{2}{3})) {{", _indent, Nt(sym2nt), idx, OutputArg(ins_to));
+                    if(IsEvents(_current) && _lexical.Contains(sym2nt)) {
+                        writer.WriteLine("        {0}        {1};", _indent, TokenCall(sym2nt, "pos" + (idx-1), "pos" + idx));
+                    }
+                    if(prof_max) {
+                        writer.WriteLine("        {0}        posmax = pos{1};", _indent, idx);
+                    }
+                    idx++;
+                    Indent(4);
+                    if(lazy) {
+                        _cleanups.Add(new KeyValuePair<string, string>(_indent, string.Format("IcbDestruct(&{0}, 1);", ins_to)));
+                    }
+                    if(to != null) {
+                        if(to == "output") {
+                            GenerateConstruct(writer);
+                        }
+                        writer.WriteLine("        {0}    {1} = {2};", _indent, to, ins_to);
+                    }
+                    ins_to = null;
+                } else if(sym2 is SymbolTerm) {
+                    SymbolTerm sym2t = sym2 as SymbolTerm;
+                    string func;
+                    string text;
+                    if(ins_set) { 
+                        func = "tset"; need_tset = true; 
+                        text = string.Format("{0}, {1}", Text(sym2t.Text), sym2t.Text.Length);
+                    } else if(ins_range) { 
+                        func = "trange"; need_trange = true; 
+                        text = string.Format("{0}, {1}", Char(sym2t.Text[0]), Char(sym2t.Text[1]));
+                    } else if(ins_notset) { 
+                        func = "tnotset"; need_tnotset = true; 
+                        text = string.Format("{0}, {1}", Text(sym2t.Text), sym2t.Text.Length);
+                    } else if(sym2t.Text.Length == 1) {
+                        func = "tc"; need_tc = true;
+                        text = opt_utf8 ? Char(sym2t.Text[0]) : string.Format("\'{0}\'", Quote(sym2t.Text));
+                    } else {
+                        func = "ts"; need_ts = true;
+                        text = string.Format("{0}, {1}", Text(sym2t.Text), sym2t.Text.Length);
+                    }
+                    writer.WriteLine("        {0}    int pos{1} = pos{2};", _indent, idx, idx-1);
+                    writer.WriteLine("        {0}    if({1}(pos{2}, {3}, {4})) {{", _indent, func, idx, text, Terminal(sym2t, ins_set, ins_range, ins_notset));
+                    if(prof_max) {
+                        writer.WriteLine("        {0}        posmax = pos{1};", _indent, idx);
+                    }
+                    idx++;
+                    Indent(4);
+                    ins_set    = false;
+                    ins_range  = false;
+                    ins_notset = false;
+                } else if(sym2 is SymbolCode && no_output) {
+                    continue; // there are no outputs to compute
+                } else if(sym2 is SymbolCode && IsAppend(_current)) {
+                    GenerateTemplate(writer, rule, i, idx);
+                } else if(sym2 is SymbolCode) {
+                    GenerateConstruct(writer);
+                    writer.WriteLine("        {0}    {1};", _indent, (sym2 as SymbolCode).Code);
+                } else if(sym2 is SymbolInstr) {
+                    SymbolInstr sym2i = sym2 as SymbolInstr;
+                    switch(sym2i.Instruction) {
+                        case Instruction.TO:     ins_to     = sym2i.ToResult; break;
+                        case Instruction.SET:    ins_set    = true;           break;
+                        case Instruction.RANGE:  ins_range  = true;           break;
+                        case Instruction.NOTSET: ins_notset = true;           break;
+                        default: throw new Exception(string.Format("Invalid instruction {0}.", sym2i.Token));
+                    }
+                }
+            }
+            return idx;
+        }
+
+        private void CloseSteps(TextWriter writer, string indent)
+        {
+            while(_indent.Length > indent.Length) {
+                CloseBlock(writer);
+                Indent(-4);
+            }
+        }
+
+        // Closes the block whose statements are generated at _indent, after the destructions due at its end.
+        private void CloseBlock(TextWriter writer)
+        {
+            while(_cleanups.Count > 0 && _cleanups[_cleanups.Count-1].Key == _indent) {
+                if(_cleanups[_cleanups.Count-1].Value != OwnOutput) {
+                    writer.WriteLine("        {0}    {1}", _indent, _cleanups[_cleanups.Count-1].Value);
+                } else {
+                    writer.WriteLine("        {0}    {1} // the alternative failed after constructing the output", _indent, OwnOutput);
+                }
+                _cleanups.RemoveAt(_cleanups.Count-1);
+            }
+            writer.WriteLine("        {0}}}", _indent);
+        }
+
+        private const string OwnOutput = "IcbDestruct(&output, 1);";
+
+        // Returns true if the outputs of the type are constructed lazily: nt_X gets uninitialized storage for its output
+        // and constructs it only when it succeeds (before the first source code fragment of the alternative that matches),
+        // so a failed call constructs and destroys nothing. The caller provides the storage by TLazy and destroys the output
+        // after a successful call. Pointers (also LPxxx by the Windows naming convention), numbers and SOutput are not
+        // constructed at all and are used as before.
+        private bool IsLazy(string type)
+        {
+            if(no_output || type.EndsWith("*") || type.StartsWith("LP") || type == "SOutput") {
+                return false;
+            }
+            return Array.IndexOf(new string[] { "bool", "BOOL", "char", "wchar_t", "TCHAR", "BYTE", "WORD", "DWORD", "UINT",
+                "short", "int", "long", "unsigned", "float", "double", "size_t", "INT_PTR", "__int64" }, type) < 0;
+        }
+
+        // Generates the storage for the output of a lazy NTS (see IsLazy()), which is destroyed by the success block of the call.
+        private void GenerateLazyOutput(TextWriter writer, string type, string output, int idx)
+        {
+            writer.WriteLine("        {0}    TLazy<{1}> lazy{2};", _indent, type, idx);
+            writer.WriteLine("        {0}    {1}& {2} = *lazy{3};", _indent, type, output, idx);
+            need_lazy = true;
+        }
+
+        // Constructs the own output of a lazy NTS (see IsLazy()) unless this path has already constructed it.
+        private void GenerateConstruct(TextWriter writer)
+        {
+            if(!IsLazy(_current.Type) || _constructed || _cleanups.Exists(delegate(KeyValuePair<string, string> c) { return c.Value == OwnOutput; })) {
+                return;
+            }
+            writer.WriteLine("        {0}    IcbConstruct(&output, 1);", _indent);
+            _cleanups.Add(new KeyValuePair<string, string>(_indent, OwnOutput));
+        }
+
+        // Generates a successful exit (return true or continue) from the current block: the own output must be
+        // constructed, the outputs of the calls on the path are destroyed.
+        private void GenerateReturn(TextWriter writer, string statement)
+        {
+            GenerateConstruct(writer);
+            for(int i = _cleanups.Count-1; i >= 0; i--) {
+                if(_cleanups[i].Value != OwnOutput) {
+                    writer.WriteLine("        {0}    {1}", _indent, _cleanups[i].Value);
+                }
+                if(_cleanups[i].Key == _indent) {
+                    _cleanups.RemoveAt(i); // the rest of the block is not reached
+                }
+            }
+            writer.WriteLine("        {0}    {1};", _indent, statement);
+        }
+
+        // Returns true if the output of the NTS is a range of _out (<option:append>).
+        private bool IsAppend(SymbolNonTerm sym)
+        {
+            return opt_append && sym.Type == "SOutput";
+        }
+
+        // Returns true if the NTS reports when it is entered and left (<option:events>). Lexical NTS are
+        // reported as tokens by their callers instead.
+        private bool IsEvents(SymbolNonTerm sym)
+        {
+            return opt_events && !_lexical.Contains(sym);
+        }
+
+        // Returns the output parameter of nt_X, which is omitted with <option:events>.
+        private string OutputParam(SymbolNonTerm sym)
+        {
+            return OutputParam(sym, true);
+        }
+
+        // Returns the output parameter of nt_X, whose name is commented out if nt_X does not use it.
+        private string OutputParam(SymbolNonTerm sym, bool used)
+        {
+            return no_output ? "" : string.Format(used ? ", {0}& output" : ", {0}& /*output*/", sym.Type);
+        }
+
+        // Returns true if nt_X uses its output: it appends to it or constructs it, or a rule assigns it in a source
+        // code fragment or with <to:xxx>.
+        private bool UsesOutput(SymbolNonTerm sym)
+        {
+            if(IsAppend(sym) || IsLazy(sym.Type)) {
+                return true;
+            }
+            foreach(List<Symbol> rule in sym.Rules) {
+                foreach(Symbol sym2 in rule) {
+                    if(sym2 is SymbolCode || (sym2 is SymbolInstr && (sym2 as SymbolInstr).Instruction == Instruction.TO)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        private string OutputArg(string output)
+        {
+            return no_output ? "" : ", " + output;
+        }
+
+        // Returns the name of the function that parses the NTS.
+        private string Nt(SymbolNonTerm sym)
+        {
+            return _prefix + "nt_" + sym.Name;
+        }
+
+        private string Op(SymbolNonTerm sym)
+        {
+            return _prefix + "op_" + sym.Name;
+        }
+
+        private string Label()
+        {
+            return _prefix.Length > 0 ? "Validate_X: " : "";
+        }
+
+        // Returns true if the grammar enables the option. An option that cannot be combined with the other option
+        // is ignored, which is reported.
+        private bool Option(string name, bool ignored, string other)
+        {
+            if(!_grammar.Options.Contains(name)) {
+                return false;
+            }
+            if(ignored) {
+                Console.WriteLine("WARNING: <option:{0}> is ignored with <option:{1}>.", name, other);
+                return false;
+            }
+            return true;
+        }
+
+        // Returns the number of the TS in the table of GetExpected(), which is added if needed. The TS are
+        // numbered by their name, so the same TS is reported once, wherever it fails. The keywords of a trie
+        // are a single entry, so their failure is recorded at once.
+        private int Terminal(string name)
+        {
+            int t = _terminals.IndexOf(name);
+            if(t < 0) {
+                t = _terminals.Count;
+                _terminals.Add(name);
+            }
+            return t;
+        }
+
+        private int Terminal(SymbolTerm sym, bool set, bool range, bool notset)
+        {
+            if(set) {
+                return Terminal("one of " + Display(sym.Text));
+            } else if(range) {
+                return Terminal(Display(sym.Text.Substring(0, 1)) + "-" + Display(sym.Text.Substring(1, 1)));
+            } else if(notset) {
+                return Terminal("none of " + Display(sym.Text));
+            }
+            return Terminal(Display(sym.Text));
+        }
+
+        // Returns the number of the entry of the input symbols that a state of a scanner expects. They are listed by
+        // their ranges, like the TS with <range>, and not by the name of the scanned NTS, which is often a helper.
+        private int Terminal(List<CharSet> labels)
+        {
+            CharSet set = CharSet.Empty;
+            foreach(CharSet label in labels) {
+                set = set.Union(label);
+            }
+            List<string> names = new List<string>();
+            for(int i = 0; i < set.RangeCount; i++) {
+                string lo = Display(((char) set.RangeLo(i)).ToString());
+                names.Add(set.RangeLo(i) == set.RangeHi(i) ? lo : lo + "-" + Display(((char) set.RangeHi(i)).ToString()));
+            }
+            return Terminal(string.Join(", ", names.ToArray()));
+        }
+
+        // Returns the text as shown in error messages, in quotes, with special characters escaped. With <option:utf8>,
+        // the bytes are decoded, the bytes of a text that is no valid UTF-8 (a part of a sequence) are shown as \xNN.
+        private string Display(string text)
+        {
+            bool bytes = false;
+            if(opt_utf8) {
+                byte[] data = new byte[text.Length];
+                for(int i = 0; i < text.Length; i++) {
+                    data[i] = (byte) text[i];
+                }
+                try {
+                    text = new UTF8Encoding(false, true).GetString(data);
+                } catch(DecoderFallbackException) {
+                    bytes = true;
+                }
+            }
+            StringBuilder sb = new StringBuilder("'");
+            for(int i = 0; i < text.Length; i++) {
+                char c = text[i];
+                switch(c) {
+                    case '\r': sb.Append("\\r"); break;
+                    case '\n': sb.Append("\\n"); break;
+                    case '\t': sb.Append("\\t"); break;
+                    default:
+                        if(bytes && c > 126) {
+                            sb.AppendFormat("\\x{0:X2}", (int) c);
+                        } else if(char.IsSurrogatePair(text, i)) {
+                            sb.AppendFormat("U+{0:X4}", char.ConvertToUtf32(text, i++));
+                        } else if(c < 32 || c > 126) {
+                            sb.AppendFormat("U+{0:X4}", (int) c);
+                        } else {
+                            sb.Append(c);
+                        }
+                        break;
+                }
+            }
+            return sb.Append('\'').ToString();
+        }
+
+        private string Rule(SymbolNonTerm sym)
+        {
+            return opt_tree ? "RULE_" + sym.Name : string.Format("{0}Handler::RULE_{1}", _grammar.Class, sym.Name);
+        }
+
+        // Returns the statements that report a NTS (<option:events>) or add it to the tree (<option:tree>).
+        // The node of a NTS is the first one added after mark0, so Close() does not need to search it.
+        private string EnterCall(SymbolNonTerm sym)
+        {
+            return opt_tree ? string.Format("Open({0}, pos0)", Rule(sym)) : string.Format("Event(EVENT_ENTER, {0}, pos0, pos0)", Rule(sym));
+        }
+
+        private string ExitCall(SymbolNonTerm sym, string end)
+        {
+            return opt_tree ? string.Format("Close(mark0, {0})", end) : string.Format("Event(EVENT_EXIT, {0}, pos0, {1})", Rule(sym), end);
+        }
+
+        private string TokenCall(SymbolNonTerm sym, string begin, string end)
+        {
+            return opt_tree ? string.Format("Leaf({0}, {1}, {2})", Rule(sym), begin, end) : string.Format("Event(EVENT_TOKEN, {0}, {1}, {2})", Rule(sym), begin, end);
+        }
+
+        private void GenerateExit(TextWriter writer, string end)
+        {
+            if(IsEvents(_current)) {
+                writer.WriteLine("        {0}    {1};", _indent, ExitCall(_current, end));
+            }
+        }
+
+        // Generates the output template at index i of the rule of a NTS without type (<option:append>). As for the
+        // interpreter, $iN is the input matched by the Nth symbol, $N the output of the Nth NTS, $$ a single $ and
+        // everything else is copied. The template appends records to _out, which refer to the text, the input or the
+        // output of a NTS instead of copying it, so nested templates cost time linear in their size and the output
+        // is only copied once by Flatten(). If the rule has several templates, every one continues the output of the
+        // preceding one. idx is the number of the next posN.
+        private void GenerateTemplate(TextWriter writer, List<Symbol> rule, int i, int idx)
+        {
+            string        code    = (rule[i] as SymbolCode).Code;
+            List<string>  outputs = new List<string>(); // the outputN of the NTS before the template, null for NTS with <to:xxx>
+            bool          first   = true;
+            int           n       = 1;
+            for(int j = 0; j < i; j++) {
+                if(rule[j] is SymbolNonTerm) {
+                    outputs.Add(j > 0 && rule[j-1] is SymbolInstr ? null : "output" + n);
+                }
+                if(rule[j] is SymbolNonTerm || rule[j] is SymbolTerm) {
+                    n++;
+                }
+                first = first && !(rule[j] is SymbolCode);
+            }
+
+            List<string> records = new List<string>();
+            string       text    = "";
+            string       pass    = null; // the outputN if the template is just $N
+            for(int k = 0; k < code.Length; k++) {
+                string record = null;
+                if(code[k] == '$' && k+2 < code.Length && code[k+1] == 'i' && code[k+2] >= '1' && code[k+2] <= '9') {
+                    int sym = code[k+2]-'0';
+                    if(sym >= idx) {
+                        throw new Exception(string.Format("{0}: Invalid template '{1}', there is no symbol {2}.", _current.Name, code, sym));
+                    }
+                    record = string.Format("_input, pos{0}, pos{1}", sym-1, sym);
+                    k += 2;
+                } else if(code[k] == '$' && k+1 < code.Length && code[k+1] >= '1' && code[k+1] <= '9') {
+                    int nt = code[k+1]-'0';
+                    if(nt > outputs.Count || outputs[nt-1] == null) {
+                        throw new Exception(string.Format("{0}: Invalid template '{1}', there is no output of NTS {2}.", _current.Name, code, nt));
+                    }
+                    record = string.Format("NULL, {0}.begin, {0}.end", outputs[nt-1]);
+                    pass   = records.Count == 0 && text.Length == 0 && k+2 == code.Length ? outputs[nt-1] : null;
+                    k += 1;
+                } else if(code[k] == '$' && k+1 < code.Length && code[k+1] == '$') {
+                    text += '$';
+                    k += 1;
+                } else if(code[k] == '$') {
+                    throw new Exception(string.Format("{0}: Invalid template '{1}'.", _current.Name, code));
+                } else {
+                    text += code[k];
+                }
+                if(record != null || (k+1 == code.Length && text.Length > 0)) {
+                    if(text.Length > 0) {
+                        string output = opt_utf8 ? Grammar.Utf8(text) : text;
+                        records.Add(string.Format("{0}, 0, {1}", Text(output), output.Length));
+                        text = "";
+                    }
+                    if(record != null) {
+                        records.Add(record);
+                    }
+                }
+            }
+
+            if(first && pass != null) {
+                writer.WriteLine("        {0}    output = {1};", _indent, pass);
+                return;
+            }
+            if(first) {
+                writer.WriteLine("        {0}    output.begin = _out.GetSize();", _indent);
+            } else {
+                writer.WriteLine("        {0}    Out(NULL, output.begin, output.end);", _indent);
+                writer.WriteLine("        {0}    output.begin = _out.GetSize()-1;", _indent);
+            }
+            foreach(string record in records) {
+                writer.WriteLine("        {0}    Out({1});", _indent, record);
+            }
+            writer.WriteLine("        {0}    output.end = _out.GetSize();", _indent);
+        }
+
+        // Generates nt_X for a rule with <memo>, which remembers the result of the last call of nt_X_body, so that
+        // the rule is parsed only once if several alternatives of the caller start with it at the same position.
+        private void GenerateMemo(TextWriter writer, SymbolNonTerm sym)
+        {
+            string memo = string.Format("_{0}memo_{1}", _prefix, sym.Name);
+            writer.WriteLine("    int {0}_pos; // the position, end position (-1 if failed) and output of the last call of {1}_body", memo, Nt(sym));
+            writer.WriteLine("    int {0}_end;", memo);
+            if(!no_output) {
+                writer.WriteLine("    {0} {1}_output;", sym.Type, memo);
+            }
+            writer.WriteLine("");
+            if(IsLazy(sym.Type)) {
+                GenerateLazyMemo(writer, sym, memo);
+                return;
+            }
+            writer.WriteLine("    bool {0}(int& pos{1}) {{", Nt(sym), OutputParam(sym));
+            writer.WriteLine("        if(pos != {0}_pos) {{", memo);
+            writer.WriteLine("            {0}_pos = pos;", memo);
+            writer.WriteLine("            {0}_end = pos;", memo);
+            writer.WriteLine("            if(!{0}_body({1}_end{2})) {{", Nt(sym), memo, OutputArg(memo + "_output"));
+            writer.WriteLine("                {0}_end = -1;", memo);
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("        if({0}_end < 0) {{", memo);
+            writer.WriteLine("            return false;");
+            writer.WriteLine("        }");
+            if(!no_output) {
+                writer.WriteLine("        output = {0}_output;", memo);
+            }
+            writer.WriteLine("        pos    = {0}_end;", memo);
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Generates nt_X for a rule with <memo> and a lazy type (see IsLazy()): nt_X_body constructs the output of the
+        // caller directly, which is then copied to the remembered output. A remembered result is copy constructed.
+        private void GenerateLazyMemo(TextWriter writer, SymbolNonTerm sym, string memo)
+        {
+            writer.WriteLine("    bool {0}(int& pos{1}) {{", Nt(sym), OutputParam(sym));
+            writer.WriteLine("        if(pos != {0}_pos) {{", memo);
+            writer.WriteLine("            {0}_pos = pos;", memo);
+            writer.WriteLine("            {0}_end = pos;", memo);
+            writer.WriteLine("            if(!{0}_body({1}_end, output)) {{", Nt(sym), memo);
+            writer.WriteLine("                {0}_end = -1;", memo);
+            writer.WriteLine("                return false;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            {0}_output = output;", memo);
+            writer.WriteLine("            pos = {0}_end;", memo);
+            writer.WriteLine("            return true;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        if({0}_end < 0) {{", memo);
+            writer.WriteLine("            return false;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        IcbConstructCopy(&output, 1, &{0}_output);", memo);
+            writer.WriteLine("        pos    = {0}_end;", memo);
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Compiles the lexical NTS that are used by other NTS into scanners (<option:scanner>).
+        // The lexical NTS that are then only used by scanners are not generated at all. A NTS that cannot be compiled
+        // is not an error: its nt_ function is generated as usual and uses the scanners of its NTS, which is reported.
+        private void FindScanners()
+        {
+            List<SymbolNonTerm> lexical  = Scanner.FindLexical(_grammar);
+            Analysis            analysis = new Analysis(_grammar);
+            List<SymbolNonTerm> roots    = new List<SymbolNonTerm>();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(lexical.Contains(sym)) {
+                    if(_grammar.Exports.Contains(sym) && !roots.Contains(sym)) {
+                        roots.Add(sym);
+                    }
+                    continue;
+                }
+                if(sym.Operand != null && lexical.Contains(sym.Operand) && !roots.Contains(sym.Operand)) {
+                    roots.Add(sym.Operand);
+                }
+                foreach(List<Symbol> rule in sym.Rules) {
+                    foreach(Symbol sym2 in rule) {
+                        if(sym2 is SymbolNonTerm && lexical.Contains(sym2 as SymbolNonTerm) && !roots.Contains(sym2 as SymbolNonTerm)) {
+                            roots.Add(sym2 as SymbolNonTerm);
+                        }
+                    }
+                }
+            }
+            for(int i = 0; i < roots.Count; i++) { // if a NTS cannot be compiled, the NTS it uses can
+                SymbolNonTerm sym = roots[i];
+                try {
+                    _scanners.Add(sym, new Scanner(sym, analysis));
+                    Console.WriteLine("{0}{1}: Compiled into a scanner with {2} state{3}.", Label(), sym.Name, _scanners[sym].States.Count, _scanners[sym].States.Count > 1 ? "s" : "");
+                } catch(Exception ex) {
+                    Console.WriteLine("{0}{1}: Not compiled into a scanner, {2}.", Label(), sym.Name, ex.Message);
+                    foreach(List<Symbol> rule in sym.Rules) {
+                        foreach(Symbol sym2 in rule) {
+                            if(sym2 is SymbolNonTerm && !roots.Contains(sym2 as SymbolNonTerm)) {
+                                roots.Add(sym2 as SymbolNonTerm);
+                            }
+                        }
+                    }
+                }
+            }
+
+            List<SymbolNonTerm> used = new List<SymbolNonTerm>(roots);
+            for(int i = 0; i < used.Count; i++) {
+                if(_scanners.ContainsKey(used[i])) {
+                    continue;
+                }
+                foreach(List<Symbol> rule in used[i].Rules) {
+                    foreach(Symbol sym2 in rule) {
+                        if(sym2 is SymbolNonTerm && !used.Contains(sym2 as SymbolNonTerm)) {
+                            used.Add(sym2 as SymbolNonTerm);
+                        }
+                    }
+                }
+            }
+            foreach(SymbolNonTerm sym in lexical) {
+                if(!used.Contains(sym)) {
+                    _unused.Add(sym);
+                }
+            }
+        }
+
+        // Generates a lexical NTS as a DFA in direct code: every state is a label, every transition
+        // a test of the next input symbol and a goto. The last position at which the DFA was in an
+        // accepting state is the end of the match.
+        private void GenerateScanner(TextWriter writer, SymbolNonTerm sym, Scanner scanner)
+        {
+            bool[] targets = new bool[scanner.States.Count];
+            bool   any     = false;
+            foreach(Scanner.State state in scanner.States) {
+                foreach(int t in state.Targets) {
+                    targets[t] = true;
+                    any        = true;
+                }
+            }
+            writer.WriteLine("    {0}bool {1}(int& pos{2}) {{ // scanner, {3} state{4}", sym.Inline ? "__forceinline " : "", Nt(sym), OutputParam(sym, IsAppend(sym) || IsLazy(sym.Type)), scanner.States.Count, scanner.States.Count > 1 ? "s" : "");
+            writer.WriteLine("        int p   = pos;");
+            writer.WriteLine("        int end = -1;");
+            if(IsAppend(sym)) {
+                writer.WriteLine("        output.begin = output.end = 0;");
+            }
+            if(any) {
+                writer.WriteLine("        {0} c;", opt_utf8 ? "unsigned char" : _grammar.Type); // the ranges of bytes are unsigned
+            }
+            for(int i = 0; i < scanner.States.Count; i++) {
+                Scanner.State state = scanner.States[i];
+                if(targets[i]) {
+                    writer.WriteLine("    s{0}:", i);
+                }
+                if(state.Accept) {
+                    writer.WriteLine("        end = p;");
+                }
+                if(state.Targets.Count > 0) {
+                    writer.WriteLine("        if(p >= _size) goto {0};", state.Accept ? "done" : "f" + i);
+                    writer.WriteLine("        c = _input[p];");
+                    for(int j = 0; j < state.Targets.Count; j++) {
+                        writer.WriteLine("        if({0}) {{ p++; goto s{1}; }}", Condition(state.Labels[j]), state.Targets[j]);
+                    }
+                }
+                if(!state.Accept && state.Targets.Count > 0) { // the scanner stopped within a token, the input symbols of the state were expected
+                    writer.WriteLine("    f{0}:", i);
+                    writer.WriteLine("        Fail(p, {0});", Terminal(state.Labels));
+                }
+                writer.WriteLine("        goto done;");
+            }
+            writer.WriteLine("    done:");
+            writer.WriteLine("        if(end < 0) return false;");
+            if(IsLazy(sym.Type)) {
+                writer.WriteLine("        IcbConstruct(&output, 1);");
+            }
+            writer.WriteLine("        pos = end;");
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private static string Condition(CharSet set)
+        {
+            List<string> terms = new List<string>();
+            for(int i = 0; i < set.RangeCount; i++) {
+                int lo = set.RangeLo(i);
+                int hi = set.RangeHi(i);
+                if(lo == hi) {
+                    terms.Add(string.Format("c == {0}", Literal(lo)));
+                } else if(lo == 0 && hi == CharSet.MaxChar) {
+                    terms.Add("true");
+                } else if(lo == 0) {
+                    terms.Add(string.Format("c <= {0}", Literal(hi)));
+                } else if(hi == CharSet.MaxChar) {
+                    terms.Add(string.Format("c >= {0}", Literal(lo)));
+                } else {
+                    terms.Add(string.Format("(c >= {0} && c <= {1})", Literal(lo), Literal(hi)));
+                }
+            }
+            if(terms.Count == 1 && terms[0].StartsWith("(")) {
+                return terms[0].Substring(1, terms[0].Length-2);
+            }
+            return string.Join(" || ", terms.ToArray());
+        }
+
+        private static string Literal(int c)
+        {
+            switch(c) {
+                case '\\':  return "'\\\\'";
+                case '\'':  return "'\\''";
+                case '\t':  return "'\\t'";
+                case '\r':  return "'\\r'";
+                case '\n':  return "'\\n'";
+            }
+            if(c >= ' ' && c < 127) {
+                return string.Format("'{0}'", (char) c);
+            }
+            return string.Format("0x{0:X2}", c);
+        }
+
+        // Returns the input symbol as literal of the input type. With <option:utf8>, the bytes above ASCII are char
+        // literals, so they compare equal to the (signed) chars of the input.
+        private string Char(int c)
+        {
+            if(opt_utf8 && c >= 0x80 && c <= 0xFF) {
+                return string.Format("'\\x{0:X2}'", c);
+            }
+            return Literal(c);
+        }
+
+        // Returns the text as string literal of the input type. With <option:utf8>, the text is a byte sequence and
+        // the bytes above ASCII are octal escapes (a hex escape would include the following hex digits).
+        private string Text(string text)
+        {
+            if(!opt_utf8) {
+                return string.Format("_T(\"{0}\")", Quote(text)); // TODO: support arrays of other types
+            }
+            StringBuilder sb = new StringBuilder("\"");
+            foreach(char c in Quote(text)) {
+                if(c >= 0x80) {
+                    sb.Append("\\").Append(Convert.ToString(c, 8));
+                } else {
+                    sb.Append(c);
+                }
+            }
+            return sb.Append('\"').ToString();
+        }
+
+        // Returns the type of the output of the NTS without type with <option:append>: the text of the
+        // output templates and of the input, which is UTF-8 with <option:utf8>.
+        private string Output()
+        {
+            return opt_utf8 ? "CStringA" : "CString";
+        }
+
+        private void GenerateProfileInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    // Profiling counters, maintained per parser instance (and thus per thread) because of <option:profile>.");
+            writer.WriteLine("    // Define RSPT_PROFILE_CYCLES to additionally count CPU cycles using rdtsc.");
+            writer.WriteLine("    struct SProfileCounters {");
+            writer.WriteLine("        sint64 calls;       // number of invocations of the rule or alternative");
+            writer.WriteLine("        sint64 successes;   // number of successful invocations");
+            writer.WriteLine("        sint64 failures;    // number of failed invocations");
+            writer.WriteLine("        sint64 consumed;    // number of characters consumed by successful invocations");
+            writer.WriteLine("        sint64 backtracked; // number of characters matched by failed alternatives and given back");
+            writer.WriteLine("        sint64 cycles;      // number of CPU cycles, including nested rules");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    void ProfileReset() {");
+            writer.WriteLine("        memset(_prof_rules, 0, sizeof(_prof_rules));");
+            writer.WriteLine("        memset(_prof_alts,  0, sizeof(_prof_alts));");
+            writer.WriteLine("        SProfileNode root = { -1, -1, -1, -1, 0, 0 };");
+            writer.WriteLine("        _prof_tree.SetSize(0);");
+            writer.WriteLine("        _prof_tree.Add(root);");
+            writer.WriteLine("        _prof_node = 0;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    const SProfileCounters& ProfileRule(int rule) const { return _prof_rules[rule]; }");
+            writer.WriteLine("    const SProfileCounters& ProfileAlt(int alt) const { return _prof_alts[alt]; }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Writes one line per rule and per alternative, sorted by cycles (or calls) in descending order.");
+            writer.WriteLine("    void ProfileReport(FILE* file) const {");
+            writer.WriteLine("        int order[{0}];", _grammar.NonTerms.Count);
+            writer.WriteLine("        for(int i = 0; i < {0}; i++) {{", _grammar.NonTerms.Count);
+            writer.WriteLine("            int j = i;");
+            writer.WriteLine("            while(j > 0 && ProfileWeight(_prof_rules[order[j-1]]) < ProfileWeight(_prof_rules[i])) {");
+            writer.WriteLine("                order[j] = order[j-1];");
+            writer.WriteLine("                j--;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            order[j] = i;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        fprintf(file, \"# %-30s %4s %14s %14s %14s %14s %14s %14s\\n\", \"rule\", \"alt\", \"calls\", \"successes\", \"failures\", \"consumed\", \"backtracked\", \"cycles\");");
+            writer.WriteLine("        for(int i = 0; i < {0}; i++) {{", _grammar.NonTerms.Count);
+            writer.WriteLine("            int rule = order[i];");
+            writer.WriteLine("            ProfilePrint(file, ProfileRuleName(rule), 0, _prof_rules[rule]);");
+            writer.WriteLine("            for(int alt = ProfileFirstAlt(rule); alt < ProfileFirstAlt(rule+1); alt++) {");
+            writer.WriteLine("                ProfilePrint(file, ProfileRuleName(rule), alt - ProfileFirstAlt(rule) + 1, _prof_alts[alt]);");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Writes the call tree as folded stacks (one line per call path) for flamegraph.pl.");
+            writer.WriteLine("    // The weight is the number of self cycles with RSPT_PROFILE_CYCLES or the number of calls otherwise.");
+            writer.WriteLine("    void ProfileFlamegraph(FILE* file) const {");
+            writer.WriteLine("        TIcbArray<sint64> self;");
+            writer.WriteLine("        self.SetSize(_prof_tree.GetSize());");
+            writer.WriteLine("        for(int node = 1; node < _prof_tree.GetSize(); node++) {");
+            writer.WriteLine("#ifdef RSPT_PROFILE_CYCLES");
+            writer.WriteLine("            self[node] += _prof_tree[node].cycles;");
+            writer.WriteLine("            self[_prof_tree[node].parent] -= _prof_tree[node].cycles;");
+            writer.WriteLine("#else");
+            writer.WriteLine("            self[node] = _prof_tree[node].calls;");
+            writer.WriteLine("#endif");
+            writer.WriteLine("        }");
+            writer.WriteLine("        TIcbArray<int> path;");
+            writer.WriteLine("        for(int node = 1; node < _prof_tree.GetSize(); node++) {");
+            writer.WriteLine("            if(self[node] <= 0) {");
+            writer.WriteLine("                continue;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            path.SetSize(0);");
+            writer.WriteLine("            for(int n = node; n > 0; n = _prof_tree[n].parent) {");
+            writer.WriteLine("                path.Add(_prof_tree[n].rule);");
+            writer.WriteLine("            }");
+            writer.WriteLine("            for(int i = path.GetSize()-1; i >= 0; i--) {");
+            writer.WriteLine("                fprintf(file, i > 0 ? \"%s;\" : \"%s\", ProfileRuleName(path[i]));");
+            writer.WriteLine("            }");
+            writer.WriteLine("            fprintf(file, \" %.0f\\n\", (double) self[node]);");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static const char* ProfileRuleName(int rule) {");
+            writer.Write    ("        static const char* names[] = {");
+            for(int i = 0; i < _grammar.NonTerms.Count; i++) {
+                writer.Write("{0}\"{1}\"", i > 0 ? ", " : " ", _grammar.NonTerms[i].Name);
+            }
+            writer.WriteLine(" };");
+            writer.WriteLine("        return names[rule];");
+            writer.WriteLine("    }");
+        }
+
+        private void GenerateProfileImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    struct SProfileNode { // a node of the calling context tree");
+            writer.WriteLine("        int    rule;   // the index of the rule, -1 for the root node");
+            writer.WriteLine("        int    parent; // the index of the parent node");
+            writer.WriteLine("        int    child;  // the index of the first child node, -1 if none");
+            writer.WriteLine("        int    next;   // the index of the next sibling node, -1 if none");
+            writer.WriteLine("        sint64 calls;");
+            writer.WriteLine("        sint64 cycles;");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    class CProfileScope { // records a single invocation of a nt_ function");
+            writer.WriteLine("    private:");
+            writer.WriteLine("        {0}* _parser;", _grammar.Class);
+            writer.WriteLine("        int    _rule;");
+            writer.WriteLine("        int    _pos0;");
+            writer.WriteLine("        int    _parent;");
+            writer.WriteLine("        bool   _success;");
+            writer.WriteLine("        sint64 _cycles;");
+            writer.WriteLine("");
+            writer.WriteLine("    public:");
+            writer.WriteLine("        CProfileScope({0}* parser, int rule, int pos0) : _parser(parser), _rule(rule), _pos0(pos0), _success(false) {{", _grammar.Class);
+            writer.WriteLine("            _parent = parser->ProfileEnter(rule);");
+            writer.WriteLine("#ifdef RSPT_PROFILE_CYCLES");
+            writer.WriteLine("            _cycles = __rdtsc();");
+            writer.WriteLine("#endif");
+            writer.WriteLine("        }");
+            writer.WriteLine("");
+            writer.WriteLine("        ~CProfileScope() {");
+            writer.WriteLine("#ifdef RSPT_PROFILE_CYCLES");
+            writer.WriteLine("            sint64 cycles = __rdtsc() - _cycles;");
+            writer.WriteLine("            _parser->_prof_rules[_rule].cycles += cycles;");
+            writer.WriteLine("            _parser->_prof_tree[_parser->_prof_node].cycles += cycles;");
+            writer.WriteLine("#endif");
+            writer.WriteLine("            if(!_success) {");
+            writer.WriteLine("                _parser->_prof_rules[_rule].failures++;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            _parser->_prof_node = _parent;");
+            writer.WriteLine("        }");
+            writer.WriteLine("");
+            writer.WriteLine("        void Success(int pos) {");
+            writer.WriteLine("            SProfileCounters& r = _parser->_prof_rules[_rule];");
+            writer.WriteLine("            r.successes++;");
+            writer.WriteLine("            r.consumed += pos - _pos0;");
+            writer.WriteLine("            _success = true;");
+            writer.WriteLine("        }");
+            writer.WriteLine("");
+            writer.WriteLine("        void Success(int alt, int pos) {");
+            writer.WriteLine("            SProfileCounters& a = _parser->_prof_alts[alt];");
+            writer.WriteLine("            a.calls++;");
+            writer.WriteLine("            a.successes++;");
+            writer.WriteLine("            a.consumed += pos - _pos0;");
+            writer.WriteLine("            Success(pos);");
+            writer.WriteLine("        }");
+            writer.WriteLine("");
+            writer.WriteLine("        void Failure(int alt, int posmax) {");
+            writer.WriteLine("            SProfileCounters& r = _parser->_prof_rules[_rule];");
+            writer.WriteLine("            SProfileCounters& a = _parser->_prof_alts[alt];");
+            writer.WriteLine("            r.backtracked += posmax - _pos0;");
+            writer.WriteLine("            a.calls++;");
+            writer.WriteLine("            a.failures++;");
+            writer.WriteLine("            a.backtracked += posmax - _pos0;");
+            writer.WriteLine("        }");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    friend class CProfileScope;");
+            writer.WriteLine("");
+            writer.WriteLine("    SProfileCounters        _prof_rules[{0}];", _grammar.NonTerms.Count);
+            writer.WriteLine("    SProfileCounters        _prof_alts[{0}];", prof_alts);
+            writer.WriteLine("    TIcbArray<SProfileNode> _prof_tree;");
+            writer.WriteLine("    int                     _prof_node;");
+            writer.WriteLine("");
+            writer.WriteLine("    int ProfileEnter(int rule) {");
+            writer.WriteLine("        int parent = _prof_node;");
+            writer.WriteLine("        int node   = _prof_tree[parent].child;");
+            writer.WriteLine("        while(node >= 0 && _prof_tree[node].rule != rule) {");
+            writer.WriteLine("            node = _prof_tree[node].next;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        if(node < 0) {");
+            writer.WriteLine("            SProfileNode child = { rule, parent, -1, _prof_tree[parent].child, 0, 0 };");
+            writer.WriteLine("            node = _prof_tree.GetSize();");
+            writer.WriteLine("            _prof_tree.Add(child);");
+            writer.WriteLine("            _prof_tree[parent].child = node;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _prof_node = node;");
+            writer.WriteLine("        _prof_tree[node].calls++;");
+            writer.WriteLine("        _prof_rules[rule].calls++;");
+            writer.WriteLine("        return parent;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static sint64 ProfileWeight(const SProfileCounters& c) {");
+            writer.WriteLine("        return c.cycles > 0 ? c.cycles : c.calls;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static int ProfileFirstAlt(int rule) {");
+            writer.Write    ("        static const int first[] = {");
+            int alt = 0;
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                writer.Write(" {0},", alt);
+                alt += sym.Rules.Count;
+            }
+            writer.WriteLine(" {0} }};", alt);
+            writer.WriteLine("        return first[rule];");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static void ProfilePrint(FILE* file, const char* rule, int alt, const SProfileCounters& c) {");
+            writer.WriteLine("        char altstr[16] = \"*\";");
+            writer.WriteLine("        if(alt > 0) {");
+            writer.WriteLine("            sprintf(altstr, \"%d\", alt);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        fprintf(file, \"  %-30s %4s %14.0f %14.0f %14.0f %14.0f %14.0f %14.0f\\n\", rule, altstr,");
+            writer.WriteLine("            (double) c.calls, (double) c.successes, (double) c.failures, (double) c.consumed, (double) c.backtracked, (double) c.cycles);");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Generates the step budget and deadline of a parse (<option:budget>). Every nt_ and op_ function counts down
+        // _steps and fails if Budget() finds the budget exceeded. Then all functions fail on entry, so the parse
+        // ends after the alternatives still open have been given up, instead of backtracking through the rest
+        // of the input. Budget() is called every BUDGET_CHECK steps only, which is also when the deadline is checked.
+        private void GenerateBudgetCheck(TextWriter writer)
+        {
+            if(opt_budget) {
+                writer.WriteLine("        if(--_steps < 0 && !Budget()) return false;");
             }
-            if(_grammar.Type == null) {
-                _grammar.Type = "TCHAR";
+        }
+
+        // Generates the arena of the semantic values (<option:arena>): the actions allocate strings and other simple
+        // values with Str() and New() instead of types like CString, which take each value from the heap. The arena
+        // is reset at the start of each Parse_X, so the parse does not free anything, and after the first parses its
+        // block is big enough and nothing is allocated from the heap either.
+        private void GenerateArenaInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    CIcbArena  _arena;     // the arena of the values allocated by Str() and New(), reset by each Parse_X");
+            writer.WriteLine("    CIcbArena* _arena_set; // the arena used instead, if set by SetArena()");
+        }
+
+        private void GenerateArenaAccessors(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    // Sets the arena used by the following parses (NULL for the arena of the parser), e.g. to keep the values");
+            writer.WriteLine("    // of a parse while parsing with another parser. The arena is reset at the start of each Parse_X.");
+            writer.WriteLine("    void SetArena(CIcbArena* arena) {");
+            writer.WriteLine("        _arena_set = arena;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // The arena of the values of the last parse, which are valid until the next Parse_X.");
+            writer.WriteLine("    CIcbArena& Arena() {");
+            writer.WriteLine("        return _arena_set != NULL ? *_arena_set : _arena;");
+            writer.WriteLine("    }");
+        }
+
+        private void GenerateArenaImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    // Returns a copy of _input[begin, end) in the arena, terminated by a 0.");
+            writer.WriteLine("    const {0}* Str(int begin, int end) {{", _grammar.Type);
+            writer.WriteLine("        return Arena().AllocString(_input+begin, end-begin);");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Returns a default constructed value in the arena, its destructor is never called.");
+            writer.WriteLine("    template <class T> T* New() {");
+            writer.WriteLine("        return Arena().AllocArray<T>(1);");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private void GenerateBudgetInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    enum { BUDGET_CHECK = 1024 }; // the number of steps between two calls of Budget()");
+            writer.WriteLine("");
+            writer.WriteLine("    int   _budget_steps; // the number of nt_ calls allowed per parse (0 for no limit)");
+            writer.WriteLine("    DWORD _budget_ms;    // the time allowed per parse in milliseconds (0 for no limit)");
+            writer.WriteLine("    int   _steps;        // the steps until Budget() is called again");
+            writer.WriteLine("    int   _steps_left;   // the steps left after those (-1 for no limit)");
+            writer.WriteLine("    DWORD _deadline;     // GetTickCount() at which the parse is abandoned");
+            writer.WriteLine("    bool  _exceeded;     // the budget of the last parse was exceeded");
+        }
+
+        private void GenerateBudgetAccessors(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    // Limits the following parses to the given number of nt_ calls and milliseconds (0 for no limit).");
+            writer.WriteLine("    // The time is checked every BUDGET_CHECK calls. If a limit is exceeded, Parse_X() and Validate_X()");
+            writer.WriteLine("    // return false and IsBudgetExceeded() returns true.");
+            writer.WriteLine("    void SetBudget(int steps, DWORD ms) {");
+            writer.WriteLine("        _budget_steps = steps;");
+            writer.WriteLine("        _budget_ms    = ms;");
+            writer.WriteLine("        _exceeded     = false;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    bool IsBudgetExceeded() const {");
+            writer.WriteLine("        return _exceeded;");
+            writer.WriteLine("    }");
+        }
+
+        private void GenerateBudgetImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    void ResetBudget() {");
+            writer.WriteLine("        _steps      = 0;");
+            writer.WriteLine("        _steps_left = _budget_steps > 0 ? _budget_steps : -1;");
+            writer.WriteLine("        _deadline   = GetTickCount() + _budget_ms;");
+            writer.WriteLine("        _exceeded   = false;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Called when _steps is used up: returns false if the budget is exceeded, otherwise grants the next steps.");
+            writer.WriteLine("    bool Budget() {");
+            writer.WriteLine("        if(_exceeded || _steps_left == 0 || (_budget_ms > 0 && (int) (GetTickCount() - _deadline) >= 0)) {");
+            writer.WriteLine("            _exceeded = true;");
+            writer.WriteLine("            _steps    = 0;");
+            writer.WriteLine("            return false;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _steps = BUDGET_CHECK;");
+            writer.WriteLine("        if(_steps_left >= 0) {");
+            writer.WriteLine("            _steps       = _steps_left < BUDGET_CHECK ? _steps_left : BUDGET_CHECK;");
+            writer.WriteLine("            _steps_left -= _steps;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _steps--; // the step of the caller");
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Returns the given test of _exceeded with <option:budget>, otherwise "". A rule that is stopped by the budget fails,
+        // which may let another alternative or an empty repetition succeed instead, so a parse that exceeded the budget
+        // fails even if it reached the end of the input.
+        private string Exceeded(string test)
+        {
+            return opt_budget ? test : "";
+        }
+
+        // Returns true if the matches of the NTS are searched in parallel before the parse (<sync:'xxx'>). They are
+        // copied into the parse, so nt_X must not have outputs: in Validate_X or with <option:events>, but not with
+        // <option:incremental>, which copies subtrees itself. Operator tables and scanners are not searched.
+        private bool IsSync(SymbolNonTerm sym)
+        {
+            return sym.Sync != null && sym.Operand == null && !_scanners.ContainsKey(sym) && !_unused.Contains(sym) &&
+                   (_prefix.Length > 0 || (IsEvents(sym) && !opt_incremental));
+        }
+
+        private bool HasSync()
+        {
+            return _grammar.NonTerms.Exists(IsSync);
+        }
+
+        // Generates the parse without the matches of Speculate() after a failed parse, which finds the TS that
+        // failed within the copied matches.
+        private void GenerateUnsync(TextWriter writer, SymbolNonTerm sym)
+        {
+            if(HasSync()) {
+                writer.WriteLine("        if((!ok || pos != _size) && Unsync()) {");
+                writer.WriteLine("            pos = 0;");
+                if(opt_events) {
+                    writer.WriteLine("            Rollback(0);");
+                }
+                writer.WriteLine("            ok  = {0}(pos);", Nt(sym));
+                writer.WriteLine("        }");
+            }
+        }
+
+        private void GenerateSyncInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    enum { SYNC_CHUNK = 65536 }; // the minimum size of a chunk of the input searched by one thread");
+            writer.WriteLine("    enum { SYNC_VALIDATE, SYNC_PARSE, SYNC_COPY }; // the tasks of the threads");
+            writer.WriteLine("");
+            writer.WriteLine("    struct SSync { // a match of a NTS with <sync:'xxx'> found in a chunk");
+            writer.WriteLine("        int rule;");
+            writer.WriteLine("        int begin;");
+            writer.WriteLine("        int end;");
+            writer.WriteLine("        int first; // the events or nodes of the match recorded by the parser of the chunk");
+            writer.WriteLine("        int count;");
+            writer.WriteLine("        int chunk;");
+            writer.WriteLine("        int at;    // where they are copied to");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    int              _threads;    // the number of threads (see SetThreads())");
+            writer.WriteLine("    TIcbArray<{0}> _chunks; // the parsers of the chunks", _grammar.Class);
+            writer.WriteLine("    int              _sync_task;  // the task of the threads and the number of its parts");
+            writer.WriteLine("    int              _sync_parts;");
+            writer.WriteLine("    int volatile     _sync_next;  // the next part taken by a thread");
+            writer.WriteLine("    TIcbArray<SSync> _found;      // the matches found in the chunk of this parser");
+            writer.WriteLine("    TIcbArray<SSync> _synced;     // the matches of all chunks in input order");
+            writer.WriteLine("    int              _sync_at;    // the match behind the last copied one");
+            writer.WriteLine("    TIcbArray<SSync> _copies;     // the matches to be copied after the parse");
+        }
+
+        private void GenerateSyncAccessors(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    // Searches the matches of the NTS with <sync:'xxx'> on up to the given number of threads before the");
+            writer.WriteLine("    // following parses (1 for none). The input is split into chunks, which are parsed at every position");
+            writer.WriteLine("    // behind xxx. Where the parse then calls the NTS at the position of a match, the match is copied instead.");
+            writer.WriteLine("    // As a NTS does not depend on its caller, the copy is the same as the parse of the NTS. Matches the");
+            writer.WriteLine("    // parse does not call are not used (e.g. behind a xxx in a comment), it parses the NTS there itself.");
+            writer.WriteLine("    void SetThreads(int threads) {");
+            writer.WriteLine("        _threads = threads;");
+            writer.WriteLine("    }");
+        }
+
+        private void GenerateSyncImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    // Searches the chunks of the input for matches (see SetThreads()) and collects them in _synced.");
+            writer.WriteLine("    void Speculate(int task) {");
+            writer.WriteLine("        _synced.SetSize(0);");
+            writer.WriteLine("        _sync_at = 0;");
+            writer.WriteLine("        int chunks = _size / SYNC_CHUNK < _threads * 4 ? _size / SYNC_CHUNK : _threads * 4;");
+            writer.WriteLine("        if(_threads < 2 || chunks < 2) {");
+            writer.WriteLine("            return;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _chunks.SetSize(chunks);");
+            writer.WriteLine("        for(int i = 0; i < chunks; i++) {");
+            writer.WriteLine("            _chunks[i]._input = _input;");
+            writer.WriteLine("            _chunks[i]._size  = _size;");
+            if(opt_budget) {
+                writer.WriteLine("            _chunks[i].SetBudget(_budget_steps, _budget_ms);");
+            }
+            writer.WriteLine("        }");
+            writer.WriteLine("        RunThreads(task, chunks);");
+            writer.WriteLine("        for(int i = 0; i < chunks; i++) {");
+            writer.WriteLine("            TIcbArray<SSync>& found = _chunks[i]._found;");
+            writer.WriteLine("            for(int j = 0; j < found.GetSize(); j++) {");
+            writer.WriteLine("                found[j].chunk = i;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            _synced.Add(found);");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Runs the parts of the task on the calling thread and up to _threads-1 threads started here, which");
+            writer.WriteLine("    // take one part after the other.");
+            writer.WriteLine("    void RunThreads(int task, int parts) {");
+            writer.WriteLine("        _sync_task  = task;");
+            writer.WriteLine("        _sync_parts = parts;");
+            writer.WriteLine("        _sync_next  = 0;");
+            writer.WriteLine("        HANDLE threads[MAXIMUM_WAIT_OBJECTS];");
+            writer.WriteLine("        int    count = 0;");
+            writer.WriteLine("        while(count < _threads-1 && count < parts-1 && count < MAXIMUM_WAIT_OBJECTS) {");
+            writer.WriteLine("            HANDLE thread = CreateThread(NULL, 0, SyncThread, this, 0, NULL);");
+            writer.WriteLine("            if(thread == NULL) {");
+            writer.WriteLine("                break; // the threads started so far do the rest");
+            writer.WriteLine("            }");
+            writer.WriteLine("            threads[count++] = thread;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        SyncThread(this);");
+            writer.WriteLine("        if(count > 0) {");
+            writer.WriteLine("            WaitForMultipleObjects(count, threads, TRUE, INFINITE);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        for(int i = 0; i < count; i++) {");
+            writer.WriteLine("            CloseHandle(threads[i]);");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static DWORD WINAPI SyncThread(LPVOID param) {");
+            writer.WriteLine("        {0}* parser = ({0}*) param;", _grammar.Class);
+            writer.WriteLine("        int part;");
+            writer.WriteLine("        while((part = IcbAtomicInc(&parser->_sync_next) - 1) < parser->_sync_parts) {");
+            writer.WriteLine("            parser->SyncPart(part);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return 0;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    void SyncPart(int part) {");
+            writer.WriteLine("        int size  = _sync_task == SYNC_COPY ? _copies.GetSize() : _size;");
+            writer.WriteLine("        int begin = (int) ((__int64) size * part / _sync_parts);");
+            writer.WriteLine("        int end   = (int) ((__int64) size * (part+1) / _sync_parts);");
+            writer.WriteLine("        switch(_sync_task) {");
+            if(_validator.HasSync()) {
+                writer.WriteLine("            case SYNC_VALIDATE: _chunks[part].vSyncChunk(begin, end); break;");
+            }
+            if(HasSync()) {
+                writer.WriteLine("            case SYNC_PARSE:    _chunks[part].SyncChunk(begin, end);  break;");
+                writer.WriteLine("            case SYNC_COPY:     CopySynced(begin, end);               break;");
+            }
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            if(HasSync()) {
+                GenerateSyncChunk(writer);
+            }
+            if(_validator.HasSync()) {
+                _validator.GenerateSyncChunk(writer);
+            }
+            writer.WriteLine("    // Returns true if a NTS with <sync:'s'> may start at pos: at the start of the input or behind s.");
+            writer.WriteLine("    bool SyncPoint(int pos, const {0}* s, int slen) const {{", _grammar.Type);
+            writer.WriteLine("        if(pos < slen) {");
+            writer.WriteLine("            return pos == 0;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        for(int i = 0; i < slen; i++) {");
+            writer.WriteLine("            if(_input[pos-slen+i] != s[i]) return false;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Returns the match of the rule at pos found by Speculate(), or -1 if there is none. Usually, it is the");
+            writer.WriteLine("    // one behind the last match taken, otherwise it is searched.");
+            writer.WriteLine("    int FindSynced(int rule, int pos) const {");
+            writer.WriteLine("        int i = _sync_at;");
+            writer.WriteLine("        if(i >= _synced.GetSize() || _synced[i].begin != pos) {");
+            writer.WriteLine("            int hi = _synced.GetSize();");
+            writer.WriteLine("            i = 0;");
+            writer.WriteLine("            while(i < hi) {");
+            writer.WriteLine("                int mid = (i + hi) / 2;");
+            writer.WriteLine("                if(_synced[mid].begin < pos) i = mid+1; else hi = mid;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            if(i == _synced.GetSize() || _synced[i].begin != pos) {");
+            writer.WriteLine("                return -1;");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return _synced[i].rule == rule ? i : -1;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            if(_validator.HasSync()) {
+                writer.WriteLine("    // Takes the match of the rule at pos for Validate_X(), which skips it: its chunk was only validated.");
+                writer.WriteLine("    bool vSynced(int rule, int& pos) {");
+                writer.WriteLine("        int i = FindSynced(rule, pos);");
+                writer.WriteLine("        if(i < 0) {");
+                writer.WriteLine("            return false;");
+                writer.WriteLine("        }");
+                writer.WriteLine("        _sync_at = i+1;");
+                writer.WriteLine("        pos = _synced[i].end;");
+                writer.WriteLine("        return true;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+            }
+            if(HasSync()) {
+                writer.WriteLine("    // Takes the match of the rule at pos for Parse_X(), its events or nodes are copied after the parse.");
+                writer.WriteLine("    bool Synced(int rule, int& pos) {");
+                writer.WriteLine("        int i = FindSynced(rule, pos);");
+                writer.WriteLine("        if(i < 0) {");
+                writer.WriteLine("            return false;");
+                writer.WriteLine("        }");
+                writer.WriteLine("        _sync_at = i+1;");
+                if(opt_tree) {
+                    writer.WriteLine("        SSync s = _synced[i];");
+                    writer.WriteLine("        s.at = _tree.GetSize();");
+                    writer.WriteLine("        if(s.at + s.count > _tree.GetCapacity()) {");
+                    writer.WriteLine("            _tree.SetCapacity(2 * (s.at + s.count));");
+                    writer.WriteLine("        }");
+                    writer.WriteLine("        _tree.SetSize(s.at + s.count);");
+                    writer.WriteLine("        _copies.Add(s);");
+                    writer.WriteLine("        CopyNode(s, 0); // the root links the subtree to its siblings, the rest is copied after the parse");
+                } else {
+                    writer.WriteLine("        if(THandler::Events) {");
+                    writer.WriteLine("            SSync s = _synced[i];");
+                    writer.WriteLine("            s.at = _events.GetSize();");
+                    writer.WriteLine("            if(s.at + s.count > _events.GetCapacity()) {");
+                    writer.WriteLine("                _events.SetCapacity(2 * (s.at + s.count));");
+                    writer.WriteLine("            }");
+                    writer.WriteLine("            _events.SetSize(s.at + s.count); // copied after the parse");
+                    writer.WriteLine("            _copies.Add(s);");
+                    writer.WriteLine("        }");
+                }
+                writer.WriteLine("        pos = _synced[i].end;");
+                writer.WriteLine("        return true;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                writer.WriteLine("    // Drops the copies of the matches that are removed on backtracking.");
+                writer.WriteLine("    void Uncopy(int mark) {");
+                writer.WriteLine("        int n = _copies.GetSize();");
+                writer.WriteLine("        while(n > 0 && _copies[n-1].at >= mark) {");
+                writer.WriteLine("            n--;");
+                writer.WriteLine("        }");
+                writer.WriteLine("        _copies.SetSize(n);");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                writer.WriteLine("    // Copies the matches taken by a successful parse in parallel.");
+                writer.WriteLine("    void Copy() {");
+                writer.WriteLine("        if(_copies.GetSize() > 0) {");
+                writer.WriteLine("            RunThreads(SYNC_COPY, _copies.GetSize() < _threads * 4 ? _copies.GetSize() : _threads * 4);");
+                writer.WriteLine("        }");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                writer.WriteLine("    void CopySynced(int begin, int end) {");
+                writer.WriteLine("        for(int i = begin; i < end; i++) {");
+                writer.WriteLine("            const SSync& s = _copies[i];");
+                if(opt_tree) {
+                    writer.WriteLine("            for(int j = 1; j < s.count; j++) {");
+                    writer.WriteLine("                CopyNode(s, j);");
+                    writer.WriteLine("            }");
+                } else {
+                    writer.WriteLine("            memcpy(_events.GetData() + s.at, _chunks[s.chunk]._events.GetData() + s.first, s.count * sizeof(SEvent));");
+                }
+                writer.WriteLine("        }");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                if(opt_tree) {
+                    writer.WriteLine("    // Copies a node of a match, the nodes refer to each other by index.");
+                    writer.WriteLine("    void CopyNode(const SSync& s, int j) {");
+                    writer.WriteLine("        SNode& n = _tree[s.at + j];");
+                    writer.WriteLine("        n = _chunks[s.chunk]._tree[s.first + j];");
+                    writer.WriteLine("        if(n.child >= 0) n.child += s.at - s.first;");
+                    writer.WriteLine("        if(n.next  >= 0) n.next  += s.at - s.first;");
+                    writer.WriteLine("    }");
+                    writer.WriteLine("");
+                }
+            }
+            writer.WriteLine("    // Forgets the matches of Speculate() after a failed parse, which is then repeated to find the TS that");
+            writer.WriteLine("    // failed within the copied matches. Returns false if there were none.");
+            writer.WriteLine("    bool Unsync() {");
+            writer.WriteLine("        if(_synced.GetSize() == 0{0}) {{", opt_budget ? " || _exceeded" : "");
+            writer.WriteLine("            return false;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _synced.SetSize(0);");
+            writer.WriteLine("        ResetFailure();");
+            if(opt_budget) {
+                writer.WriteLine("        ResetBudget();");
+            }
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private void GenerateSyncChunk(TextWriter writer)
+        {
+            writer.WriteLine("    // Searches [begin, end) of the input for matches for {0}: the NTS with <sync:'xxx'> are tried in", _prefix.Length > 0 ? "Validate_X()" : "Parse_X()");
+            writer.WriteLine("    // their order at every position behind their text. The search goes on at the end of a match.");
+            writer.WriteLine("    void {0}SyncChunk(int begin, int end) {{", _prefix);
+            writer.WriteLine("        ResetFailure();");
+            if(opt_budget) {
+                writer.WriteLine("        ResetBudget();");
             }
             foreach(SymbolNonTerm sym in _grammar.NonTerms) {
-                if(sym.Type == null) {
-                    sym.Type = "void*";
+                if(sym.Memo) {
+                    writer.WriteLine("        _{0}memo_{1}_pos = -1;", _prefix, sym.Name);
                 }
             }
-            writer.WriteLine("//");
-            writer.WriteLine("// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).");
-            writer.WriteLine("//       Do not modify the contents of this file as it will be overwritten!");
-            writer.WriteLine("//");
-            writer.WriteLine("#pragma once;");
-            foreach(string include in _grammar.Includes) {
-                writer.WriteLine("#include {0}", include);
+            if(opt_events) {
+                writer.WriteLine("        Rollback(0);");
             }
-            if(_grammar.Namespace != null) {
-                writer.WriteLine("");
-                writer.WriteLine("namespace {0} {{", _grammar.Namespace);
+            writer.WriteLine("        _found.SetSize(0);");
+            writer.WriteLine("        int pos = begin;");
+            writer.WriteLine("        while(pos < end) {");
+            writer.WriteLine("            int pos1 = pos;");
+            writer.WriteLine("            int mark = {0};", opt_events ? "Mark()" : "0");
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(IsSync(sym)) {
+                    writer.WriteLine("            if(SyncPoint(pos, {0}, {1})) {{", Text(sym.Sync), sym.Sync.Length);
+                    writer.WriteLine("                if({0}(pos1) && pos1 > pos) {{", Nt(sym));
+                    writer.WriteLine("                    SSync s = {{ {0}, pos, pos1, mark, {1}, 0, 0 }}; // chunk is set by Speculate(), at by Synced()", _grammar.NonTerms.IndexOf(sym), opt_events ? "Mark() - mark" : "0");
+                    writer.WriteLine("                    _found.Add(s);");
+                    writer.WriteLine("                    pos = pos1;");
+                    writer.WriteLine("                    continue;");
+                    writer.WriteLine("                }");
+                    if(opt_events) {
+                        writer.WriteLine("                Rollback(mark);");
+                    }
+                    writer.WriteLine("                pos1 = pos;");
+                    writer.WriteLine("            }");
+                }
             }
+            writer.WriteLine("            pos++;");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
             writer.WriteLine("");
-            writer.WriteLine("class {0}", _grammar.Class);
-            writer.WriteLine("{");
-            writer.WriteLine("private:");
-            writer.WriteLine("    const {0}* _input;", _grammar.Type);
-            writer.WriteLine("    int _size;");
+        }
+
+        private void GenerateHandler(TextWriter writer)
+        {
+            writer.WriteLine("// The default handler of {0}, which ignores all events (<option:events>). Handlers derive from it,", _grammar.Class);
+            writer.WriteLine("// set Events to true and hide the functions they need. After a successful parse, Enter() and Exit() are");
+            writer.WriteLine("// called for every rule of the result, Token() for every lexical rule (terminals only), in input order.");
+            writer.WriteLine("struct {0}Handler {{", _grammar.Class);
+            writer.WriteLine("    enum { Events = false }; // if false, no events are recorded and the parser is a plain recognizer");
+            writer.WriteLine("");
+            GenerateRuleNames(writer);
+            writer.WriteLine("");
+            writer.WriteLine("    void Enter(int /*rule*/, int /*pos*/) { }");
+            writer.WriteLine("    void Exit(int /*rule*/, int /*begin*/, int /*end*/) { }");
+            writer.WriteLine("    void Token(int /*rule*/, int /*begin*/, int /*end*/) { }");
+            writer.WriteLine("};");
+            writer.WriteLine("");
+        }
+
+        private void GenerateRuleNames(TextWriter writer)
+        {
+            writer.WriteLine("    enum ERule {");
+            for(int i = 0; i < _grammar.NonTerms.Count; i++) {
+                writer.WriteLine("        RULE_{0}{1}", _grammar.NonTerms[i].Name, i+1 < _grammar.NonTerms.Count ? "," : "");
+            }
+            writer.WriteLine("    };");
             writer.WriteLine("");
+            writer.WriteLine("    static const TCHAR* RuleName(int rule) {");
+            writer.WriteLine("        static const TCHAR* names[] = {");
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                writer.WriteLine("            _T(\"{0}\"),", sym.Name);
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        return names[rule];");
+            writer.WriteLine("    }");
+        }
+
+        private void GenerateTreeTypes(TextWriter writer)
+        {
             writer.WriteLine("public:");
-            writer.WriteLine("    {0}() : _input(NULL), _size(0) {{ }}", _grammar.Class);
-            foreach(SymbolNonTerm sym in _grammar.Exports) {
+            GenerateRuleNames(writer);
+            writer.WriteLine("");
+            writer.WriteLine("    // A node of the concrete syntax tree (<option:tree>): a rule that matched _input[begin, end) or, for a");
+            writer.WriteLine("    // lexical rule (terminals only), a leaf. The nodes are stored in preorder, child is the first child and");
+            writer.WriteLine("    // next the next sibling (or -1).");
+            if(opt_incremental) {
+                writer.WriteLine("    // With <option:incremental>, after is the index behind the subtree, look the farthest position at which");
+                writer.WriteLine("    // the rule ended or a TS failed while parsing it (it examined no input from look + LOOKAHEAD on) and");
+                writer.WriteLine("    // prior the farthest one of its ancestors before they went on with it.");
+            }
+            writer.WriteLine("    struct SNode {");
+            writer.WriteLine("        int rule;");
+            writer.WriteLine("        int begin;");
+            writer.WriteLine("        int end;");
+            writer.WriteLine("        int child;");
+            writer.WriteLine("        int next;");
+            if(opt_incremental) {
+                writer.WriteLine("        int after;");
+                writer.WriteLine("        int look;");
+                writer.WriteLine("        int prior;");
+            }
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+        }
+
+        private void GenerateTreeInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    TIcbArray<SNode> _tree; // appended while parsing, truncated on backtracking");
+            if(opt_incremental) {
                 writer.WriteLine("");
-                writer.WriteLine("    bool Parse_{0}(const {1}* input, int size, {2}& output, int& pos) {{", sym.Name, _grammar.Type, sym.Type);
-                writer.WriteLine("        _input = input;");
-                writer.WriteLine("        _size  = size;");
-                writer.WriteLine("        pos    = 0;");
-                writer.WriteLine("        /*output = default({0});*/", sym.Type); // TODO: fix init 
-                writer.WriteLine("        return nt_{0}(pos, output) && pos == _size;", sym.Name);
+                writer.WriteLine("    enum {{ LOOKAHEAD = {0} }}; // the longest TS, a TS that failed at pos may have examined the input up to here", LongestTerminal());
+                writer.WriteLine("");
+                writer.WriteLine("    bool             _parsed;     // _tree is the tree of the last successful parse");
+                writer.WriteLine("    bool             _edited;     // Edit() has been called since");
+                writer.WriteLine("    int              _edit_begin; // the input [_edit_begin, _edit_end) of that parse has been edited");
+                writer.WriteLine("    int              _edit_end;");
+                writer.WriteLine("    int              _edit_delta; // the size of the input has changed by _edit_delta");
+                writer.WriteLine("    int              _old_size;   // while parsing again, _tree[0, _old_size) is the last tree");
+                writer.WriteLine("    TIcbArray<SNode> _sub;        // the new subtree while it replaces the old one");
+                writer.WriteLine("    int              _look;       // the farthest end or failure within the innermost open node");
+                writer.WriteLine("    int              _prior;      // the prior of the innermost open node");
+            }
+        }
+
+        private void GenerateTreeImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    int Mark() {");
+            writer.WriteLine("        return _tree.GetSize();");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    void Rollback(int mark) {");
+            writer.WriteLine("        _tree.SetSize(mark);");
+            if(HasSync()) {
+                writer.WriteLine("        Uncopy(mark);");
+            }
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            if(opt_incremental) {
+                GenerateReuseImplementation(writer);
+                writer.WriteLine("    // Until the node is closed, after and look hold the _prior and _look of its parent.");
+                writer.WriteLine("    void Open(int rule, int begin) {");
+                writer.WriteLine("        int prior = _prior > _look ? _prior : _look;");
+                writer.WriteLine("        SNode n = { rule, begin, begin, -1, -1, _prior, _look, prior };");
+                writer.WriteLine("        _tree.Add(n);");
+                writer.WriteLine("        _prior = prior;");
+                writer.WriteLine("        _look  = begin;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                writer.WriteLine("    void Leaf(int rule, int begin, int end) {");
+                writer.WriteLine("        SNode n = { rule, begin, end, -1, _tree.GetSize()+1, _tree.GetSize()+1, end, _prior };");
+                writer.WriteLine("        _tree.Add(n);");
+                writer.WriteLine("        if(end > _look) _look = end;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                writer.WriteLine("    // Removes the node added by Open() after the rule failed. The input it examined counts for the parent.");
+                writer.WriteLine("    void Cancel(int node) {");
+                writer.WriteLine("        _prior = _tree[node].after;");
+                writer.WriteLine("        if(_tree[node].look > _look) _look = _tree[node].look;");
+                writer.WriteLine("        Rollback(node);");
+                writer.WriteLine("    }");
+            } else {
+                writer.WriteLine("    void Open(int rule, int begin) {");
+                writer.WriteLine("        SNode n = { rule, begin, begin, -1, -1 };");
+                writer.WriteLine("        _tree.Add(n);");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+                writer.WriteLine("    void Leaf(int rule, int begin, int end) {");
+                writer.WriteLine("        SNode n = { rule, begin, end, -1, _tree.GetSize()+1 };");
+                writer.WriteLine("        _tree.Add(n);");
                 writer.WriteLine("    }");
             }
             writer.WriteLine("");
-            writer.WriteLine("private:");
-            bool need_ts      = false;
-            bool need_tc      = false;
-            bool need_tset    = false;
-            bool need_trange  = false;
-            bool need_tnotset = false;
+            writer.WriteLine("    // Closes the node added by Open(). Until its parent is closed, next is the end of the subtree, so the");
+            writer.WriteLine("    // children of the node can be linked by skipping from one to the next.");
+            writer.WriteLine("    void Close(int node, int end) {");
+            writer.WriteLine("        int size = _tree.GetSize();");
+            writer.WriteLine("        _tree[node].end  = end;");
+            writer.WriteLine("        _tree[node].next = size;");
+            if(opt_incremental) {
+                writer.WriteLine("        _prior = _tree[node].after;");
+                writer.WriteLine("        _tree[node].after = size;");
+                writer.WriteLine("        int look = _look > end ? _look : end;");
+                writer.WriteLine("        _look = _tree[node].look > look ? _tree[node].look : look;");
+                writer.WriteLine("        _tree[node].look = look;");
+            }
+            writer.WriteLine("        if(node+1 < size) {");
+            writer.WriteLine("            _tree[node].child = node+1;");
+            writer.WriteLine("            for(int i = node+1; i < size; ) {");
+            writer.WriteLine("                SNode& child = _tree[i];");
+            writer.WriteLine("                i = child.next;");
+            writer.WriteLine("                child.next = i < size ? i : -1;");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Generates the check at the start of nt_X whether the subtree of X at pos can be copied from the last tree.
+        private void GenerateReuse(TextWriter writer, SymbolNonTerm sym)
+        {
+            if(opt_incremental) {
+                writer.WriteLine("        if(_edited && Reuse({0}, pos)) return true;", Rule(sym));
+            }
+        }
+
+        // Returns the length of the longest TS (at least 1), the number of characters a TS can examine.
+        // The text of <set>, <range> and <notset> is not a sequence, they examine one character.
+        private int LongestTerminal()
+        {
+            int longest = 1;
             foreach(SymbolNonTerm sym in _grammar.NonTerms) {
-                bool emptyclause = false;
-                writer.WriteLine("    bool nt_{0}(int& pos, {1}& output) {{", sym.Name, sym.Type);
-                writer.WriteLine("        int pos0 = pos;");
                 foreach(List<Symbol> rule in sym.Rules) {
-                    writer.WriteLine("        if(true) {");
-                    int    idx = 1;
-                    string ins_to     = null;
-                    bool   ins_set    = false;
-                    bool   ins_range  = false;
-                    bool   ins_notset = false;
-                    foreach(Symbol sym2 in rule) {
-                        if(sym2 is SymbolNonTerm) {
-                            SymbolNonTerm sym2nt = sym2 as SymbolNonTerm;
-                            if(ins_to == null) {
-                                ins_to = "output"+idx;
-                                writer.WriteLine("        {0}    {1} {2} /*= default({1})*/;", _indent, sym2nt.Type, ins_to); // TODO: fix init 
-                            }
-                            writer.WriteLine("        {0}    int pos{1} = pos{2};", _indent, idx, idx-1);
-                            writer.WriteLine("        {0}    if(nt_{1}(pos{2}, {3})) {{", _indent, sym2nt.Name, idx, ins_to);
-                            idx++;
-                            Indent(4);
-                            ins_to = null;
-                        } else if(sym2 is SymbolTerm) {
-                            SymbolTerm sym2t = sym2 as SymbolTerm;
-                            string func;
-                            string text;
-                            if(ins_set) { 
-                                func = "tset"; need_tset = true; 
-                                text = string.Format("_T(\"{0}\"), {1}", Quote(sym2t.Text), sym2t.Text.Length); // TODO: support arrays of other types
-                            } else if(ins_range) { 
-                                func = "trange"; need_trange = true; 
-                                text = string.Format("\'{0}\', \'{1}\'", Quote(sym2t.Text.Substring(0, 1)), Quote(sym2t.Text.Substring(1, 1)));
-                            } else if(ins_notset) { 
-                                func = "tnotset"; need_tnotset = true; 
-                                text = string.Format("_T(\"{0}\"), {1}", Quote(sym2t.Text), sym2t.Text.Length); // TODO: support arrays of other types
-                            } else if(sym2t.Text.Length == 1) {
-                                func = "tc"; need_tc = true;
-                                text = string.Format("\'{0}\'", Quote(sym2t.Text));
-                            } else {
-                                func = "ts"; need_ts = true;
-                                text = string.Format("_T(\"{0}\"), {1}", Quote(sym2t.Text), sym2t.Text.Length); // TODO: support arrays of other types
-                            }
-                            writer.WriteLine("        {0}    int pos{1} = pos{2};", _indent, idx, idx-1);
-                            writer.WriteLine("        {0}    if({1}(pos{2}, {3})) {{", _indent, func, idx, text);
-                            idx++;
-                            Indent(4);
-                            ins_set    = false;
-                            ins_range  = false;
-                            ins_notset = false;
-                        } else if(sym2 is SymbolCode) {
-                            writer.WriteLine("        {0}    {1};", _indent, (sym2 as SymbolCode).Code);
-                        } else if(sym2 is SymbolInstr) {
-                            SymbolInstr sym2i = sym2 as SymbolInstr;
-                            switch(sym2i.Instruction) {
-                                case Instruction.TO:     ins_to     = sym2i.ToResult; break;
-                                case Instruction.SET:    ins_set    = true;           break;
-                                case Instruction.RANGE:  ins_range  = true;           break;
-                                case Instruction.NOTSET: ins_notset = true;           break;
-                                default: throw new Exception(string.Format("Invalid instruction {0}.", sym2i.Token));
-                            }
+                    for(int i = 0; i < rule.Count; i++) {
+                        if(rule[i] is SymbolTerm && !(i > 0 && rule[i-1] is SymbolInstr && (rule[i-1] as SymbolInstr).Instruction != Instruction.TO)) {
+                            longest = Math.Max(longest, (rule[i] as SymbolTerm).Text.Length);
                         }
                     }
-                    if(rule.Count == 0) {
-                        emptyclause = true;
-                    }
-                    writer.WriteLine("        {0}    pos = pos{1};", _indent, idx-1);
-                    writer.WriteLine("        {0}    return true;", _indent);
-                    while(_indent.Length >= 4) {
-                        writer.WriteLine("        {0}}}", _indent);
-                        Indent(-4);
-                    }
-                    writer.WriteLine("        }");
                 }
-                if(!emptyclause) {
-                    writer.WriteLine("        return false;");
+            }
+            return longest;
+        }
+
+        private void GenerateEditInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    // Reports that removed characters at offset of the input have been replaced by inserted characters. The");
+            writer.WriteLine("    // next Parse_X() only parses the rules again that examined edited input or contain it and copies the");
+            writer.WriteLine("    // other subtrees of the last successful parse (see Reparse()). All edits since that parse must be");
+            writer.WriteLine("    // reported, at the positions of the input at the time of the edit. If the next parse fails, GetTree()");
+            writer.WriteLine("    // still returns the last tree, so the parse after the following edits can reuse it.");
+            writer.WriteLine("    void Edit(int offset, int removed, int inserted) {");
+            writer.WriteLine("        if(!_edited) {");
+            writer.WriteLine("            _edited     = true;");
+            writer.WriteLine("            _edit_begin = offset;");
+            writer.WriteLine("            _edit_end   = offset + removed;");
+            writer.WriteLine("            _edit_delta = 0;");
+            writer.WriteLine("        } else {");
+            writer.WriteLine("            if(offset < _edit_begin) _edit_begin = offset;");
+            writer.WriteLine("            if(offset + removed - _edit_delta > _edit_end) _edit_end = offset + removed - _edit_delta;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _edit_delta += inserted - removed;");
+            writer.WriteLine("    }");
+        }
+
+        // Generates Parse_X with <option:incremental>: after Edit(), the last tree is parsed again by Reparse().
+        private void GenerateIncrementalParse(TextWriter writer, SymbolNonTerm sym)
+        {
+            writer.WriteLine("        bool ok;");
+            if(_lexical.Contains(sym)) {
+                writer.WriteLine("        if(true) { // a token is always parsed again");
+            } else {
+                writer.WriteLine("        if(_edited && _parsed && _tree[0].rule == {0}) {{", Rule(sym));
+                writer.WriteLine("            ok = Reparse(pos);");
+                writer.WriteLine("        } else {");
+            }
+            writer.WriteLine("            _parsed = false;");
+            writer.WriteLine("            _edited = false;");
+            writer.WriteLine("            _prior  = 0;");
+            writer.WriteLine("            _look   = 0;");
+            writer.WriteLine("            Rollback(0);");
+            writer.WriteLine("            ok = nt_{0}(pos);", sym.Name);
+            writer.WriteLine("        }");
+            writer.WriteLine("        if(!ok || pos != _size{0}) {{", Exceeded(" || _exceeded"));
+            writer.WriteLine("            return Error(pos, ok);");
+            writer.WriteLine("        }");
+            if(_lexical.Contains(sym)) {
+                writer.WriteLine("        {0};", TokenCall(sym, "0", "pos"));
+            }
+            writer.WriteLine("        _tree[0].next = -1; // the root has no sibling");
+            writer.WriteLine("        _parsed = true;     // the tree can be parsed again after Edit()");
+            writer.WriteLine("        _edited = false;");
+            writer.WriteLine("        return true;");
+        }
+
+        private void GenerateReuseImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    // Parses the input again after Edit(). The smallest node of the last tree that contains the edited input");
+            writer.WriteLine("    // is parsed again, if its ancestors examined no edited input before they went on with it. If it ends at");
+            writer.WriteLine("    // the same place again, the new subtree replaces the old one, otherwise its parent is tried, at last the");
+            writer.WriteLine("    // root. Meanwhile, Reuse() copies the subtrees of the last tree that did not examine edited input.");
+            writer.WriteLine("    // If the parse fails, the last tree is kept for the next parse.");
+            writer.WriteLine("    bool Reparse(int& pos) {");
+            writer.WriteLine("        int size = _tree.GetSize();");
+            writer.WriteLine("        int lo   = 0;");
+            writer.WriteLine("        int hi   = size;");
+            writer.WriteLine("        while(lo < hi) {");
+            writer.WriteLine("            int mid = (lo + hi) / 2;");
+            writer.WriteLine("            if(_tree[mid].begin <= _edit_begin) lo = mid+1; else hi = mid;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        int node = lo-1;");
+            writer.WriteLine("        while(node > 0 && _tree[node].end < _edit_end) {");
+            writer.WriteLine("            node--; // the nodes behind the smallest one that contains the edit end before it");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _old_size = size;");
+            writer.WriteLine("        for(; node > 0; node = Parent(node)) {");
+            writer.WriteLine("            SNode n = _tree[node];");
+            writer.WriteLine("            if(n.prior + LOOKAHEAD > _edit_begin) {");
+            writer.WriteLine("                continue; // an ancestor examined edited input before it went on with the node");
+            writer.WriteLine("            }");
+            writer.WriteLine("            ResetFailure();");
+            writer.WriteLine("            _prior  = n.prior;");
+            writer.WriteLine("            _look   = n.prior;");
+            writer.WriteLine("            int end = n.begin;");
+            writer.WriteLine("            if(ParseRule(n.rule, end) && end == n.end + _edit_delta{0}) {{", Exceeded(" && !_exceeded"));
+            writer.WriteLine("                Splice(node, size);");
+            writer.WriteLine("                _old_size = 0;");
+            writer.WriteLine("                pos = _tree[0].end;");
+            writer.WriteLine("                return true;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            Rollback(size);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        ResetFailure();");
+            writer.WriteLine("        _prior = 0;");
+            writer.WriteLine("        _look  = 0;");
+            writer.WriteLine("        pos    = 0;");
+            writer.WriteLine("        bool ok = ParseRule(_tree[0].rule, pos);");
+            writer.WriteLine("        if(ok && pos == _size{0}) {{", Exceeded(" && !_exceeded"));
+            writer.WriteLine("            Splice(0, size);");
+            writer.WriteLine("        } else {");
+            writer.WriteLine("            Rollback(size);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _old_size = 0;");
+            writer.WriteLine("        return ok;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Returns the parent of node, the nearest node before it whose subtree contains it.");
+            writer.WriteLine("    int Parent(int node) {");
+            writer.WriteLine("        int parent = node-1;");
+            writer.WriteLine("        while(_tree[parent].after <= node) {");
+            writer.WriteLine("            parent--;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return parent;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    bool ParseRule(int rule, int& pos) {");
+            writer.WriteLine("        switch(rule) {");
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(IsEvents(sym)) {
+                    writer.WriteLine("            case {0}: return {1}(pos);", Rule(sym), Nt(sym));
                 }
+            }
+            writer.WriteLine("        }");
+            writer.WriteLine("        return false; // a token is parsed again by the rule that contains it");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Replaces the subtree of node by the new one at _tree[size, ...). The nodes behind it are moved by the");
+            writer.WriteLine("    // change of their index and position, the ancestors of node are extended by the change of its end.");
+            writer.WriteLine("    void Splice(int node, int size) {");
+            writer.WriteLine("        SNode* nodes = _tree.GetData();");
+            writer.WriteLine("        int count = _tree.GetSize() - size;");
+            writer.WriteLine("        int after = nodes[node].after;");
+            writer.WriteLine("        int next  = nodes[node].next;");
+            writer.WriteLine("        int shift = count - (after - node);");
+            writer.WriteLine("        int look  = nodes[size].look;");
+            writer.WriteLine("        for(int i = 0; i < node; i++) {");
+            writer.WriteLine("            SNode& n = nodes[i];");
+            writer.WriteLine("            if(n.after > node) {");
+            writer.WriteLine("                n.end   += _edit_delta;");
+            writer.WriteLine("                n.look   = n.look + _edit_delta > look ? n.look + _edit_delta : look;");
+            writer.WriteLine("                n.after += shift;");
+            writer.WriteLine("                if(n.next >= 0) n.next += shift;");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("        for(int i = after; i < size; i++) {");
+            writer.WriteLine("            SNode& n = nodes[i];");
+            writer.WriteLine("            n.begin += _edit_delta;");
+            writer.WriteLine("            n.end   += _edit_delta;");
+            writer.WriteLine("            n.look  += _edit_delta;");
+            writer.WriteLine("            n.prior  = n.prior + _edit_delta > look ? n.prior + _edit_delta : look;");
+            writer.WriteLine("            n.after += shift;");
+            writer.WriteLine("            if(n.child >= 0) n.child += shift;");
+            writer.WriteLine("            if(n.next  >= 0) n.next  += shift;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        for(int i = size; i < size + count; i++) {");
+            writer.WriteLine("            SNode& n = nodes[i];");
+            writer.WriteLine("            n.after += node - size;");
+            writer.WriteLine("            if(n.child >= 0) n.child += node - size;");
+            writer.WriteLine("            if(n.next  >= 0) n.next  += node - size;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        nodes[size].next = next >= 0 ? next + shift : -1;");
+            writer.WriteLine("        if(after == size) {");
+            writer.WriteLine("            IcbRelocate(nodes + node, nodes + size, count); // the new subtree follows the old one");
+            writer.WriteLine("        } else {");
+            writer.WriteLine("            _sub.SetSize(0);");
+            writer.WriteLine("            _sub.Add(nodes + size, count);");
+            writer.WriteLine("            IcbRelocate(nodes + node + count, nodes + after, size - after);");
+            writer.WriteLine("            IcbRelocate(nodes + node, _sub.GetData(), count);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        _tree.SetSize(node + count + size - after); // keeps the capacity for the next parse");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Looks for the node of rule at pos in the last tree. If it lies before the edit and examined no edited");
+            writer.WriteLine("    // input, or if it lies behind the edit, the rule would match the same again: its subtree is copied,");
+            writer.WriteLine("    // moved to pos and the end of _tree. As the nodes are in preorder, their begin is ascending.");
+            writer.WriteLine("    bool Reuse(int rule, int& pos) {");
+            writer.WriteLine("        int old;");
+            writer.WriteLine("        if(pos < _edit_begin) {");
+            writer.WriteLine("            old = pos;");
+            writer.WriteLine("        } else if(pos >= _edit_end + _edit_delta) {");
+            writer.WriteLine("            old = pos - _edit_delta;");
+            writer.WriteLine("        } else {");
+            writer.WriteLine("            return false;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        int lo = 0;");
+            writer.WriteLine("        int hi = _old_size;");
+            writer.WriteLine("        while(lo < hi) {");
+            writer.WriteLine("            int mid = (lo + hi) / 2;");
+            writer.WriteLine("            if(_tree[mid].begin < old) lo = mid+1; else hi = mid;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        for(int i = lo; i < _old_size && _tree[i].begin == old; i++) {");
+            writer.WriteLine("            if(_tree[i].rule != rule) {");
+            writer.WriteLine("                continue;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            if(old < _edit_begin && _tree[i].look + LOOKAHEAD > _edit_begin) {");
+            writer.WriteLine("                return false; // the rule examined edited input");
+            writer.WriteLine("            }");
+            writer.WriteLine("            int size  = _tree.GetSize();");
+            writer.WriteLine("            int count = _tree[i].after - i;");
+            writer.WriteLine("            int delta = pos - old;");
+            writer.WriteLine("            int shift = size - i;");
+            writer.WriteLine("            int prior = _prior > _look ? _prior : _look;");
+            writer.WriteLine("            if(size + count > _tree.GetCapacity()) {");
+            writer.WriteLine("                _tree.SetCapacity(2 * (size + count));");
+            writer.WriteLine("            }");
+            writer.WriteLine("            _tree.SetSize(size + count);");
+            writer.WriteLine("            SNode* nodes = _tree.GetData();");
+            writer.WriteLine("            for(int j = 0; j < count; j++) {");
+            writer.WriteLine("                SNode& n = nodes[size + j];");
+            writer.WriteLine("                n = nodes[i + j];");
+            writer.WriteLine("                n.begin += delta;");
+            writer.WriteLine("                n.end   += delta;");
+            writer.WriteLine("                n.look  += delta;");
+            writer.WriteLine("                n.prior  = n.prior + delta > prior ? n.prior + delta : prior;");
+            writer.WriteLine("                n.after += shift;");
+            writer.WriteLine("                if(n.child >= 0) n.child += shift;");
+            writer.WriteLine("                if(n.next  >= 0) n.next  += shift;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            nodes[size].next = size + count; // the end of the subtree until the parent is closed");
+            writer.WriteLine("            if(nodes[size].look > _look) _look = nodes[size].look;");
+            writer.WriteLine("            pos = nodes[size].end;");
+            writer.WriteLine("            return true;");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return false;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private void GenerateEventsInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    enum { EVENT_ENTER, EVENT_EXIT, EVENT_TOKEN };");
+            writer.WriteLine("");
+            writer.WriteLine("    struct SEvent { // an event recorded while parsing, removed again on backtracking");
+            writer.WriteLine("        int event;");
+            writer.WriteLine("        int rule;");
+            writer.WriteLine("        int begin;");
+            writer.WriteLine("        int end;");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    TIcbArray<SEvent> _events; // only used if THandler::Events");
+        }
+
+        private void GenerateEventsImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    void Event(int event, int rule, int begin, int end) {");
+            writer.WriteLine("        if(THandler::Events) {");
+            writer.WriteLine("            SEvent e = { event, rule, begin, end };");
+            writer.WriteLine("            _events.Add(e);");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    int Mark() {");
+            writer.WriteLine("        return THandler::Events ? _events.GetSize() : 0;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    void Rollback(int mark) {");
+            writer.WriteLine("        if(THandler::Events) {");
+            writer.WriteLine("            _events.SetSize(mark);");
+            if(HasSync()) {
+                writer.WriteLine("            Uncopy(mark);");
+            }
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    void Replay(THandler& handler) {");
+            writer.WriteLine("        for(int i = 0; i < _events.GetSize(); i++) {");
+            writer.WriteLine("            const SEvent& e = _events[i];");
+            writer.WriteLine("            switch(e.event) {");
+            writer.WriteLine("                case EVENT_ENTER: handler.Enter(e.rule, e.begin);        break;");
+            writer.WriteLine("                case EVENT_EXIT:  handler.Exit(e.rule, e.begin, e.end);  break;");
+            writer.WriteLine("                case EVENT_TOKEN: handler.Token(e.rule, e.begin, e.end); break;");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private void GenerateAppendInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    struct SOutput { // the output of a NTS without type: the records _out[begin, end)");
+            writer.WriteLine("        int begin;");
+            writer.WriteLine("        int end;");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    struct SRecord { // a part of the output: text[begin, end) or, if text is NULL, the records _out[begin, end)");
+            writer.WriteLine("        const {0}* text;", _grammar.Type);
+            writer.WriteLine("        int begin;");
+            writer.WriteLine("        int end;");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+            writer.WriteLine("    TIcbArray<SRecord> _out;   // appended by the output templates, truncated on backtracking");
+            writer.WriteLine("    TIcbArray<SOutput> _stack; // the records still to be copied by Flatten()");
+        }
+
+        private void GenerateAppendImplementation(TextWriter writer)
+        {
+            writer.WriteLine("    void Out(const {0}* text, int begin, int end) {{", _grammar.Type);
+            writer.WriteLine("        SRecord record = { text, begin, end };");
+            writer.WriteLine("        _out.Add(record);");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    void Flatten(const SOutput& out, {0}& output) {{", Output());
+            writer.WriteLine("        int size = Flatten(out, NULL);");
+            writer.WriteLine("        Flatten(out, output.GetBufferSetLength(size));");
+            writer.WriteLine("        output.ReleaseBuffer(size);");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Copies the text of the output into the buffer (if not NULL) and returns its length. The nested");
+            writer.WriteLine("    // records are expanded with an explicit stack, a range is removed before its last record is");
+            writer.WriteLine("    // expanded, so right recursive rules do not make the stack grow.");
+            writer.WriteLine("    int Flatten(const SOutput& out, {0}* buffer) {{", _grammar.Type);
+            writer.WriteLine("        int size = 0;");
+            writer.WriteLine("        _stack.SetSize(0);");
+            writer.WriteLine("        if(out.begin < out.end) {");
+            writer.WriteLine("            _stack.Add(out);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        while(!_stack.IsEmpty()) {");
+            writer.WriteLine("            SOutput& top    = _stack[_stack.GetSize()-1];");
+            writer.WriteLine("            SRecord  record = _out[top.begin++];");
+            writer.WriteLine("            if(top.begin == top.end) {");
+            writer.WriteLine("                _stack.SetSize(_stack.GetSize()-1);");
+            writer.WriteLine("            }");
+            writer.WriteLine("            if(record.text == NULL) {");
+            writer.WriteLine("                if(record.begin < record.end) {");
+            writer.WriteLine("                    SOutput next = { record.begin, record.end };");
+            writer.WriteLine("                    _stack.Add(next);");
+            writer.WriteLine("                }");
+            writer.WriteLine("            } else {");
+            writer.WriteLine("                if(buffer != NULL) {");
+            writer.WriteLine("                    memcpy(buffer+size, record.text+record.begin, (record.end-record.begin)*sizeof({0}));", _grammar.Type);
+            writer.WriteLine("                }");
+            writer.WriteLine("                size += record.end-record.begin;");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return size;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Generates GetFailurePos() and GetExpected(), which report where and why the last call of Parse_X or
+        // Validate_X failed. As ordered choice tries alternatives until one matches, the failure of a single TS is
+        // no error, but the input cannot be parsed beyond the farthest position at which a TS failed.
+        private void GenerateErrorInterface(TextWriter writer)
+        {
+            writer.WriteLine("");
+            writer.WriteLine("    // Returns the position at which the last parse failed, the same as pos after Parse_X() or Validate_X().");
+            writer.WriteLine("    int GetFailurePos() const {");
+            writer.WriteLine("        return _fail_pos;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Returns the TS that were expected at GetFailurePos(), e.g. \"'+', '-' or end of input\".");
+            writer.WriteLine("    CString GetExpected() const {");
+            writer.WriteLine("        TIcbArray<const TCHAR*> names;");
+            writer.WriteLine("        for(int t = 0; t < _fail_at.GetSize(); t++) {");
+            writer.WriteLine("            if(_fail_at[t] == _fail_pos) {");
+            writer.WriteLine("                names.Add(TerminalName(t));");
+            writer.WriteLine("            }");
+            writer.WriteLine("        }");
+            writer.WriteLine("        CString expected;");
+            writer.WriteLine("        for(int i = 0; i < names.GetSize(); i++) {");
+            writer.WriteLine("            expected += i == 0 ? _T(\"\") : (i+1 < names.GetSize() ? _T(\", \") : _T(\" or \"));");
+            writer.WriteLine("            expected += names[i];");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return expected;");
+            writer.WriteLine("    }");
+        }
+
+        // Generates TLazy, the uninitialized storage for the output of a call of a lazy NTS (see IsLazy() of the generator).
+        private void GenerateLazy(TextWriter writer)
+        {
+            writer.WriteLine("    // The storage for the output of a NTS that is constructed by nt_X only if it succeeds, so a failed call");
+            writer.WriteLine("    // costs no construction and destruction. The caller destroys the output after a successful call.");
+            writer.WriteLine("    template <class T> union TLazy {");
+            writer.WriteLine("        char    data[sizeof(T)];");
+            writer.WriteLine("        double  align1; // aligns the storage like T");
+            writer.WriteLine("        void*   align2;");
+            writer.WriteLine("        __int64 align3;");
+            writer.WriteLine("");
+            writer.WriteLine("        T& operator*() {");
+            writer.WriteLine("            return *(T*) data;");
+            writer.WriteLine("        }");
+            writer.WriteLine("    };");
+            writer.WriteLine("");
+        }
+
+        private void GenerateTerminals(TextWriter writer)
+        {
+            writer.WriteLine("    void ResetFailure() {");
+            writer.WriteLine("        _fail_pos = 0;");
+            writer.WriteLine("        _fail_at.SetSize({0});", _terminals.Count);
+            writer.WriteLine("        for(int t = 0; t < _fail_at.GetSize(); t++) {");
+            writer.WriteLine("            _fail_at[t] = -1;");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Records that the TS t failed at pos. Failures before the farthest position are ignored, the others");
+            writer.WriteLine("    // cost a comparison and two stores, as nothing has to be cleared when the farthest position moves on.");
+            writer.WriteLine("    bool Fail(int pos, int t) {");
+            writer.WriteLine("        if(pos >= _fail_pos) {");
+            if(opt_utf8) {
+                writer.WriteLine("            _fail_pos = Utf8Start(pos);");
+                writer.WriteLine("            _fail_at[t] = _fail_pos;");
+            } else {
+                writer.WriteLine("            _fail_pos = pos;");
+                writer.WriteLine("            _fail_at[t] = pos;");
+            }
+            writer.WriteLine("        }");
+            if(opt_incremental) {
+                writer.WriteLine("        if(pos > _look) _look = pos;");
+            }
+            writer.WriteLine("        return false;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            if(opt_utf8) {
+                writer.WriteLine("    // Returns the start of the UTF-8 sequence that pos is within, pos itself if it is not within one. The bytes of");
+                writer.WriteLine("    // <set>, <range> and <notset> beyond ASCII are matched one by one, but fail at the start of the character,");
+                writer.WriteLine("    // like those of a parser for TCHAR. A failure within a sequence is at or beyond the farthest failure, which");
+                writer.WriteLine("    // is always at the start of a character, so the start is as well.");
+                writer.WriteLine("    int Utf8Start(int pos) const {");
+                writer.WriteLine("        for(int k = 1; k <= 3 && pos < _size && pos-k >= 0 && ((unsigned char) _input[pos-k+1] & 0xC0) == 0x80; k++) {");
+                writer.WriteLine("            unsigned char c = (unsigned char) _input[pos-k];");
+                writer.WriteLine("            if((c & 0xC0) != 0x80) {");
+                writer.WriteLine("                return k < (c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1) ? pos-k : pos; // pos is a stray byte otherwise");
+                writer.WriteLine("            }");
+                writer.WriteLine("        }");
+                writer.WriteLine("        return pos;");
                 writer.WriteLine("    }");
                 writer.WriteLine("");
             }
+            writer.WriteLine("    // Ends a failed parse: if the exported NTS matched, but not the whole input, the end of the input");
+            writer.WriteLine("    // was expected. pos is set to the farthest failure.");
+            writer.WriteLine("    bool Error(int& pos, bool matched) {");
+            writer.WriteLine("        if(matched{0}) {{", Exceeded(" && !_exceeded")); // a parse that ran out of budget expected nothing
+            writer.WriteLine("            Fail(pos, 0);");
+            writer.WriteLine("        }");
+            writer.WriteLine("        pos = _fail_pos;");
+            writer.WriteLine("        return false;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static const TCHAR* TerminalName(int t) {");
+            writer.WriteLine("        static const TCHAR* names[] = {");
+            foreach(string name in _terminals) {
+                writer.WriteLine("            _T(\"{0}\"),", Quote(name));
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        return names[t];");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
             if(need_ts) {
-                writer.WriteLine("    bool ts(int& pos, const {0}* s, int slen) {{", _grammar.Type);
+                writer.WriteLine("    bool ts(int& pos, const {0}* s, int slen, int t) {{", _grammar.Type);
                 writer.WriteLine("        for(int i = 0; i < slen; i++) {");
-                writer.WriteLine("            if(pos >= _size || _input[pos] != s[i]) return false;");
-                writer.WriteLine("            pos++;");
+                writer.WriteLine("            if(pos+i >= _size || _input[pos+i] != s[i]) return Fail(pos, t);");
                 writer.WriteLine("        }");
+                writer.WriteLine("        pos += slen;");
                 writer.WriteLine("        return true;");
                 writer.WriteLine("    }");
                 writer.WriteLine("");
             }
             if(need_tc) {
-                writer.WriteLine("    bool tc(int& pos, {0} c) {{", _grammar.Type);
-                writer.WriteLine("        if(pos >= _size || _input[pos] != c) return false;");
+                writer.WriteLine("    bool tc(int& pos, {0} c, int t) {{", _grammar.Type);
+                writer.WriteLine("        if(pos >= _size || _input[pos] != c) return Fail(pos, t);");
                 writer.WriteLine("        pos++;");
                 writer.WriteLine("        return true;");
                 writer.WriteLine("    }");
                 writer.WriteLine("");
             }
             if(need_tset) {
-                writer.WriteLine("    bool tset(int& pos, const {0}* s, int slen) {{", _grammar.Type);
+                writer.WriteLine("    bool tset(int& pos, const {0}* s, int slen, int t) {{", _grammar.Type);
                 writer.WriteLine("        for(int i = 0; i < slen; i++) {");
                 writer.WriteLine("            if(pos < _size && s[i] == _input[pos]) {");
                 writer.WriteLine("                pos++;");
                 writer.WriteLine("                return true;");
                 writer.WriteLine("            }");
                 writer.WriteLine("        }");
-                writer.WriteLine("        return false;");
+                writer.WriteLine("        return Fail(pos, t);");
                 writer.WriteLine("    }");
                 writer.WriteLine("");
             }
             if(need_trange) {
-                writer.WriteLine("    bool trange(int& pos, {0} c1, {0} c2) {{", _grammar.Type);
-                writer.WriteLine("        if(pos >= _size || _input[pos] < c1 || _input[pos] > c2) return false;");
+                writer.WriteLine("    bool trange(int& pos, {0} c1, {0} c2, int t) {{", _grammar.Type);
+                if(opt_utf8) {
+                    writer.WriteLine("        if(pos >= _size || (unsigned char) _input[pos] < (unsigned char) c1 || (unsigned char) _input[pos] > (unsigned char) c2) return Fail(pos, t);");
+                } else {
+                    writer.WriteLine("        if(pos >= _size || _input[pos] < c1 || _input[pos] > c2) return Fail(pos, t);");
+                }
                 writer.WriteLine("        pos++;");
                 writer.WriteLine("        return true;");
                 writer.WriteLine("    }");
                 writer.WriteLine("");
             }
             if(need_tnotset) {
-                writer.WriteLine("    bool tnotset(int& pos, const {0}* s, int slen) {{", _grammar.Type);
+                writer.WriteLine("    bool tnotset(int& pos, const {0}* s, int slen, int t) {{", _grammar.Type);
                 writer.WriteLine("        for(int i = 0; i < slen; i++) {");
                 writer.WriteLine("            if(pos >= _size || s[i] == _input[pos]) {");
-                writer.WriteLine("                return false;");
+                writer.WriteLine("                return Fail(pos, t);");
                 writer.WriteLine("            }");
                 writer.WriteLine("        }");
                 writer.WriteLine("        pos++;");
@@ -190,13 +2793,6 @@ namespace RSPT
                 writer.WriteLine("    }");
                 writer.WriteLine("");
             }
-            foreach(string code in _grammar.Codes) {
-                writer.WriteLine("    {0}", code);
-            }
-            writer.WriteLine("};");
-            if(_grammar.Namespace != null) {
-                writer.WriteLine("}");
-            }
         }
     }
 }
\ No newline at end of file
@@ -21,6 +21,9 @@ namespace RSPT
                 if(sym.Type == null) {
                     sym.Type = "object";
                 }
+                if(sym.Operand != null) {
+                    throw new Exception(string.Format("{0}: <operators:...> is not supported by the C# generator.", sym.Name));
+                }
             }
             writer.WriteLine("//");
             writer.WriteLine("// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).");
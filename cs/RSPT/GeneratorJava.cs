@@ -21,6 +21,9 @@ namespace RSPT
                 if(sym.Type == null) {
                     sym.Type = "Object";
                 }
+                if(sym.Operand != null) {
+                    throw new Exception(string.Format("{0}: <operators:...> is not supported by the Java generator.", sym.Name));
+                }
             }
             writer.WriteLine("//");
             writer.WriteLine("// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).");
@@ -0,0 +1,637 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+using System.Text.RegularExpressions;
+using System.IO;
+
+namespace RSPT
+{
+    // Generates a non-recursive LL(1) parser in C++: the rules are compiled into a flat array of
+    // operations and a prediction table indexed by the NTS and the class of the next input symbol.
+    // A single loop executes the operations with an explicit stack of frames, positions and values,
+    // so the nesting depth of the input is only limited by the available memory. Grammars that are
+    // not LL(1) are rejected with a list of the conflicting alternatives.
+    public class GeneratorTableCPP : Generator
+    {
+        private class Op
+        {
+            public string Code;    // OP_xxx
+            public int    Step;    // the number of the posN set by the operation
+            public string A;
+            public string B;
+            public string Comment;
+        }
+
+        private class Action
+        {
+            public SymbolNonTerm Sym;
+            public string        Code;
+            public int           Steps;   // posN with N < Steps are available
+            public Dictionary<int, int[]> Outputs; // outputN -> type and slot
+        }
+
+        private readonly List<string>   _types   = new List<string>();
+        private readonly List<Op>       _ops     = new List<Op>();
+        private readonly List<int>      _prods   = new List<int>();      // the first operation of every alternative
+        private readonly List<int>      _steps   = new List<int>();      // the number of posN of every alternative
+        private readonly List<int[]>    _slots   = new List<int[]>();    // the number of outputN of every type of every alternative
+        private readonly List<string>   _strings = new List<string>();
+        private readonly List<Action>   _actions = new List<Action>();
+
+        private bool need_ts      = false;
+        private bool need_tset    = false;
+        private bool need_trange  = false;
+        private bool need_tnotset = false;
+
+        public GeneratorTableCPP(Grammar grammar) : base(grammar) { }
+
+        public override void Generate(TextWriter writer)
+        {
+            if(_grammar.Class == null) {
+                _grammar.Class = "CParser";
+            }
+            if(_grammar.Type == null) {
+                _grammar.Type = "TCHAR";
+            }
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(sym.Type == null) {
+                    sym.Type = "void*";
+                }
+                if(sym.Operand != null) {
+                    throw new Exception(string.Format("{0}: <operators:...> is not supported by the table driven generator.", sym.Name));
+                }
+                if(!_types.Contains(sym.Type)) {
+                    _types.Add(sym.Type);
+                }
+            }
+
+            Analysis analysis = new Analysis(_grammar);
+            List<SymbolNonTerm> rows   = new List<SymbolNonTerm>();   // NTS with more than one alternative
+            List<CharSet>       sets   = new List<CharSet>();         // the lookahead of every alternative
+            List<bool>          ends   = new List<bool>();
+            List<string>        errors = new List<string>();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                int first = sets.Count;
+                foreach(List<Symbol> rule in sym.Rules) {
+                    CharSet set = analysis.First(rule);
+                    bool    end = false;
+                    if(analysis.IsNullable(rule)) {
+                        set = set.Union(analysis.Follow(sym));
+                        end = analysis.FollowsEnd(sym);
+                    }
+                    sets.Add(set);
+                    ends.Add(end);
+                }
+                for(int i = 0; i < sym.Rules.Count; i++) {
+                    if(analysis.IsNullable(sym.Rules[i]) && i+1 < sym.Rules.Count) {
+                        errors.Add(string.Format("{0}: alternative {1} can match the empty input, alternatives {2} to {3} are never tried", sym.Name, i+1, i+2, sym.Rules.Count));
+                    }
+                    for(int j = i+1; j < sym.Rules.Count; j++) {
+                        CharSet common = sets[first+i].Intersect(sets[first+j]);
+                        if(!common.IsEmpty) {
+                            errors.Add(string.Format("{0}: alternatives {1} and {2} can both start with {3}", sym.Name, i+1, j+1, common));
+                        }
+                        if(ends[first+i] && ends[first+j]) {
+                            errors.Add(string.Format("{0}: alternatives {1} and {2} can both be followed by the end of the input", sym.Name, i+1, j+1));
+                        }
+                    }
+                }
+                if(sym.Rules.Count > 1) {
+                    rows.Add(sym);
+                }
+            }
+            if(errors.Count > 0) {
+                foreach(string error in errors) {
+                    Console.WriteLine("CONFLICT: {0}.", error);
+                }
+                throw new Exception(string.Format("The grammar is not LL(1), found {0} conflict(s).", errors.Count));
+            }
+
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                for(int i = 0; i < sym.Rules.Count; i++) {
+                    CompileRule(sym, i);
+                }
+            }
+
+            // Split the input symbols into classes that select the same alternatives in all rows.
+            List<int> cuts = new List<int>();
+            cuts.Add(0);
+            cuts.Add(CharSet.MaxChar+1);
+            foreach(CharSet set in sets) {
+                for(int i = 0; i < set.RangeCount; i++) {
+                    cuts.Add(set.RangeLo(i));
+                    cuts.Add(set.RangeHi(i)+1);
+                }
+            }
+            cuts.Sort();
+            List<int>    lows    = new List<int>();    // the first input symbol of every interval
+            List<int>    classes = new List<int>();    // the class of every interval
+            List<int[]>  table   = new List<int[]>();  // the alternatives of every class, class 0 is the end of the input
+            Dictionary<string, int> signatures = new Dictionary<string, int>();
+            table.Add(Predict(rows, sets, ends, -1));
+            for(int i = 0; i+1 < cuts.Count; i++) {
+                if(cuts[i] == cuts[i+1]) {
+                    continue;
+                }
+                int[]  prods     = Predict(rows, sets, ends, cuts[i]);
+                string signature = string.Join(",", Array.ConvertAll<int, string>(prods, delegate(int p) { return p.ToString(); }));
+                int    cls;
+                if(!signatures.TryGetValue(signature, out cls)) {
+                    cls = table.Count;
+                    signatures.Add(signature, cls);
+                    table.Add(prods);
+                }
+                if(classes.Count == 0 || classes[classes.Count-1] != cls) {
+                    lows.Add(cuts[i]);
+                    classes.Add(cls);
+                }
+            }
+
+            writer.WriteLine("//");
+            writer.WriteLine("// NOTE: This file has been generated by RSPT (the Really Simple Parser Tool).");
+            writer.WriteLine("//       Do not modify the contents of this file as it will be overwritten!");
+            writer.WriteLine("//");
+            writer.WriteLine("#pragma once;");
+            foreach(string include in _grammar.Includes) {
+                writer.WriteLine("#include {0}", include);
+            }
+            if(_grammar.Namespace != null) {
+                writer.WriteLine("");
+                writer.WriteLine("namespace {0} {{", _grammar.Namespace);
+            }
+            writer.WriteLine("");
+            writer.WriteLine("class {0}", _grammar.Class);
+            writer.WriteLine("{");
+            writer.WriteLine("private:");
+            writer.WriteLine("    enum { OP_TC, OP_TS, OP_TSET, OP_TNOTSET, OP_TRANGE, OP_CALL, OP_CODE, OP_RETURN };");
+            writer.WriteLine("");
+            writer.Write("    enum {");
+            for(int i = 0; i < _grammar.NonTerms.Count; i++) {
+                writer.Write("{0} NT_{1}", i > 0 ? "," : "", _grammar.NonTerms[i].Name);
+            }
+            writer.WriteLine(" };");
+            writer.WriteLine("");
+            writer.WriteLine("    struct SOp     { short code; short step; int a; int b; };");
+            writer.WriteLine("    struct SProd   {{ int pc; int steps; int values[{0}]; }};", _types.Count);
+            writer.WriteLine("    struct SRule   { int type; int prod; int count; int row; };");
+            writer.WriteLine("    struct SFrame  {{ int pc; int out; int pos; int values[{0}]; }};", _types.Count);
+            writer.WriteLine("");
+            writer.WriteLine("    const {0}* _input;", _grammar.Type);
+            writer.WriteLine("    int _size;");
+            writer.WriteLine("    TIcbArray<SFrame> _frames;");
+            writer.WriteLine("    TIcbArray<int> _positions;");
+            foreach(string type in _types) {
+                writer.WriteLine("    TIcbArray<{0}> {1};", type, Values(type));
+            }
+            writer.WriteLine("");
+            writer.WriteLine("public:");
+            writer.WriteLine("    {0}() : _input(NULL), _size(0) {{ }}", _grammar.Class);
+            foreach(SymbolNonTerm sym in _grammar.Exports) {
+                writer.WriteLine("");
+                writer.WriteLine("    bool Parse_{0}(const {1}* input, int size, {2}& output, int& pos) {{", sym.Name, _grammar.Type, sym.Type);
+                writer.WriteLine("        _input = input;");
+                writer.WriteLine("        _size  = size;");
+                writer.WriteLine("        pos    = 0;");
+                foreach(string type in _types) {
+                    writer.WriteLine("        {0}.SetSize(0);", Values(type));
+                }
+                writer.WriteLine("        {0}.Add(output);", Values(sym.Type));
+                writer.WriteLine("        bool ok = Run(NT_{0}, 0, pos) && pos == _size;", sym.Name);
+                writer.WriteLine("        output = {0}[0];", Values(sym.Type));
+                writer.WriteLine("        return ok;");
+                writer.WriteLine("    }");
+            }
+            writer.WriteLine("");
+            writer.WriteLine("private:");
+            GenerateTables(writer, rows, table, lows, classes);
+            GenerateDriver(writer);
+            GenerateActions(writer);
+            GenerateTerminals(writer);
+            foreach(string code in _grammar.Codes) {
+                writer.WriteLine("    {0}", code);
+            }
+            writer.WriteLine("};");
+            if(_grammar.Namespace != null) {
+                writer.WriteLine("}");
+            }
+        }
+
+        // Returns the alternative (index into _prods) every row selects for the input symbol c (-1 is the end of the input).
+        private int[] Predict(List<SymbolNonTerm> rows, List<CharSet> sets, List<bool> ends, int c)
+        {
+            int[] prods = new int[rows.Count];
+            for(int r = 0; r < rows.Count; r++) {
+                prods[r] = -1;
+                int first = FirstProd(rows[r]);
+                for(int i = 0; i < rows[r].Rules.Count; i++) {
+                    if(c < 0 ? ends[first+i] : sets[first+i].Contains(c)) {
+                        prods[r] = first+i;
+                    }
+                }
+            }
+            return prods;
+        }
+
+        private int FirstProd(SymbolNonTerm sym)
+        {
+            int first = 0;
+            foreach(SymbolNonTerm sym2 in _grammar.NonTerms) {
+                if(sym2 == sym) {
+                    break;
+                }
+                first += sym2.Rules.Count;
+            }
+            return first;
+        }
+
+        // Compiles an alternative into operations: TS are matched, NTS push a new frame and source
+        // code fragments become cases of Action(). Every NTS gets a slot in the value stack of its type,
+        // unless <to:xxx> directs it to the output of the caller or an earlier outputN.
+        private void CompileRule(SymbolNonTerm sym, int alt)
+        {
+            List<Symbol> rule  = sym.Rules[alt];
+            string       name  = string.Format("{0}/{1}", sym.Name, alt+1);
+            int[]        slots = new int[_types.Count];
+            Dictionary<int, int[]> outputs = new Dictionary<int, int[]>();
+            _prods.Add(_ops.Count);
+            int    idx        = 1;
+            string ins_to     = null;
+            bool   ins_set    = false;
+            bool   ins_range  = false;
+            bool   ins_notset = false;
+            foreach(Symbol sym2 in rule) {
+                if(sym2 is SymbolInstr) {
+                    SymbolInstr sym2i = sym2 as SymbolInstr;
+                    switch(sym2i.Instruction) {
+                        case Instruction.TO:     ins_to     = sym2i.ToResult; break;
+                        case Instruction.SET:    ins_set    = true;           break;
+                        case Instruction.RANGE:  ins_range  = true;           break;
+                        case Instruction.NOTSET: ins_notset = true;           break;
+                        default: throw new Exception(string.Format("Invalid instruction {0}.", sym2i.Token));
+                    }
+                    continue;
+                }
+                Op op = new Op();
+                op.Step    = idx;
+                op.Comment = name;
+                name       = "";
+                if(sym2 is SymbolNonTerm) {
+                    SymbolNonTerm sym2nt = sym2 as SymbolNonTerm;
+                    int type = _types.IndexOf(sym2nt.Type);
+                    int slot;
+                    if(ins_to == null) {
+                        slot = slots[type]++;
+                        outputs.Add(idx, new int[] { type, slot });
+                    } else if(ins_to == "output") {
+                        if(sym2nt.Type != sym.Type) {
+                            throw new Exception(string.Format("{0}: <to:output> requires {1} to be of type {2}.", sym.Name, sym2nt.Name, sym.Type));
+                        }
+                        slot = -1;
+                    } else {
+                        int   n;
+                        int[] target;
+                        if(!ins_to.StartsWith("output") || !int.TryParse(ins_to.Substring(6), out n) || !outputs.TryGetValue(n, out target) || target[0] != type) {
+                            throw new Exception(string.Format("{0}: <to:{1}> is not supported by the table driven generator.", sym.Name, ins_to));
+                        }
+                        slot = target[1];
+                    }
+                    op.Code     = "OP_CALL";
+                    op.A        = "NT_" + sym2nt.Name;
+                    op.B        = slot.ToString();
+                    op.Comment += " " + sym2nt.Name;
+                    idx++;
+                    ins_to = null;
+                } else if(sym2 is SymbolTerm) {
+                    SymbolTerm sym2t = sym2 as SymbolTerm;
+                    if(ins_range) {
+                        op.Code = "OP_TRANGE"; need_trange = true;
+                        op.A    = string.Format("\'{0}\'", Quote(sym2t.Text.Substring(0, 1)));
+                        op.B    = string.Format("\'{0}\'", Quote(sym2t.Text.Substring(1, 1)));
+                    } else if(!ins_set && !ins_notset && sym2t.Text.Length == 1) {
+                        op.Code = "OP_TC";
+                        op.A    = string.Format("\'{0}\'", Quote(sym2t.Text));
+                        op.B    = "0";
+                    } else {
+                        if(ins_set) {
+                            op.Code = "OP_TSET"; need_tset = true;
+                        } else if(ins_notset) {
+                            op.Code = "OP_TNOTSET"; need_tnotset = true;
+                        } else {
+                            op.Code = "OP_TS"; need_ts = true;
+                        }
+                        if(!_strings.Contains(sym2t.Text)) {
+                            _strings.Add(sym2t.Text);
+                        }
+                        op.A = _strings.IndexOf(sym2t.Text).ToString();
+                        op.B = sym2t.Text.Length.ToString();
+                    }
+                    op.Comment += " " + QuoteComment(sym2t.Text);
+                    idx++;
+                    ins_set    = false;
+                    ins_range  = false;
+                    ins_notset = false;
+                } else if(sym2 is SymbolCode) {
+                    Action action  = new Action();
+                    action.Sym     = sym;
+                    action.Code    = (sym2 as SymbolCode).Code;
+                    action.Steps   = idx;
+                    action.Outputs = new Dictionary<int, int[]>(outputs);
+                    op.Code     = "OP_CODE";
+                    op.Step     = 0;
+                    op.A        = _actions.Count.ToString();
+                    op.B        = "0";
+                    op.Comment += " {...}";
+                    _actions.Add(action);
+                }
+                _ops.Add(op);
+            }
+            Op ret = new Op();
+            ret.Code    = "OP_RETURN";
+            ret.Step    = 0;
+            ret.A       = "0";
+            ret.B       = "0";
+            ret.Comment = name;
+            _ops.Add(ret);
+            _steps.Add(idx);
+            _slots.Add(slots);
+        }
+
+        private void GenerateTables(TextWriter writer, List<SymbolNonTerm> rows, List<int[]> table, List<int> lows, List<int> classes)
+        {
+            writer.WriteLine("    static const SOp* Ops() {");
+            writer.WriteLine("        static const SOp ops[] = {");
+            for(int i = 0; i < _ops.Count; i++) {
+                Op op = _ops[i];
+                string line = string.Format("{{ {0}, {1}, {2}, {3} }}{4}", op.Code, op.Step, op.A, op.B, i+1 < _ops.Count ? "," : "");
+                writer.WriteLine("            {0,-40} // {1,4}{2}", line, i, op.Comment.Length > 0 ? " " + op.Comment : "");
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        return ops;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static const SProd* Prods() {");
+            writer.WriteLine("        static const SProd prods[] = {");
+            for(int i = 0; i < _prods.Count; i++) {
+                string[] values = Array.ConvertAll<int, string>(_slots[i], delegate(int n) { return n.ToString(); });
+                writer.WriteLine("            {{ {0}, {1}, {{ {2} }} }}{3}", _prods[i], _steps[i], string.Join(", ", values), i+1 < _prods.Count ? "," : "");
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        return prods;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static const SRule* Rules() {");
+            writer.WriteLine("        static const SRule rules[] = {");
+            for(int i = 0; i < _grammar.NonTerms.Count; i++) {
+                SymbolNonTerm sym = _grammar.NonTerms[i];
+                string line = string.Format("{{ {0}, {1}, {2}, {3} }}{4}", _types.IndexOf(sym.Type), FirstProd(sym), sym.Rules.Count, rows.IndexOf(sym), i+1 < _grammar.NonTerms.Count ? "," : "");
+                writer.WriteLine("            {0,-24} // {1}", line, sym.Name);
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        return rules;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            if(_strings.Count > 0) {
+                writer.WriteLine("    static const {0}* const* Strings() {{", _grammar.Type);
+                writer.WriteLine("        static const {0}* const strings[] = {{", _grammar.Type);
+                for(int i = 0; i < _strings.Count; i++) {
+                    writer.WriteLine("            _T(\"{0}\"){1}", Quote(_strings[i]), i+1 < _strings.Count ? "," : ""); // TODO: support arrays of other types
+                }
+                writer.WriteLine("        };");
+                writer.WriteLine("        return strings;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+            }
+            if(rows.Count == 0) {
+                return;
+            }
+            writer.WriteLine("    static int Class(unsigned c) { // the class of an input symbol, class 0 is the end of the input");
+            writer.WriteLine("        static const unsigned {0} classes[128] = {{", table.Count <= 256 ? "char" : "short");
+            for(int c = 0; c < 128; c += 16) {
+                StringBuilder sb = new StringBuilder();
+                for(int k = c; k < c+16; k++) {
+                    sb.AppendFormat("{0,3}{1}", ClassOf(lows, classes, k), k < 127 ? "," : "");
+                }
+                writer.WriteLine("            {0}", sb.ToString());
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        if(c < 128) return classes[c];");
+            int start = lows.Count-1;
+            while(start > 0 && lows[start] > 128) {
+                start--;
+            }
+            for(int i = start; i+1 < lows.Count; i++) {
+                writer.WriteLine("        if(c < 0x{0:X}) return {1};", lows[i+1], classes[i]);
+            }
+            writer.WriteLine("        return {0};", classes[lows.Count-1]);
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    static int Predict(int row, int cls) { // the alternative of a rule selected by the next input symbol, or -1");
+            writer.WriteLine("        static const short table[{0}][{1}] = {{", rows.Count, table.Count);
+            for(int r = 0; r < rows.Count; r++) {
+                StringBuilder sb = new StringBuilder();
+                for(int k = 0; k < table.Count; k++) {
+                    sb.AppendFormat("{0}{1,3}", k > 0 ? "," : "", table[k][r]);
+                }
+                writer.WriteLine("            {{{0} }}{1} // {2}", sb.ToString(), r+1 < rows.Count ? "," : " ", rows[r].Name);
+            }
+            writer.WriteLine("        };");
+            writer.WriteLine("        return table[row][cls];");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private static int ClassOf(List<int> lows, List<int> classes, int c)
+        {
+            int i = lows.Count-1;
+            while(lows[i] > c) {
+                i--;
+            }
+            return classes[i];
+        }
+
+        private void GenerateDriver(TextWriter writer)
+        {
+            bool predict = false;
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                predict = predict || sym.Rules.Count > 1;
+            }
+            writer.WriteLine("    template<class T> static int Alloc(TIcbArray<T>& values, int count) {");
+            writer.WriteLine("        int base = values.GetSize();");
+            writer.WriteLine("        for(int i = 0; i < count; i++) {");
+            writer.WriteLine("            values.Add(T());");
+            writer.WriteLine("        }");
+            writer.WriteLine("        return base;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    bool Enter(int nt, int out, int pos) {");
+            writer.WriteLine("        const SRule& rule = Rules()[nt];");
+            writer.WriteLine("        int prod = rule.prod;");
+            if(predict) {
+                writer.WriteLine("        if(rule.count > 1) {");
+                writer.WriteLine("            prod = Predict(rule.row, pos < _size ? Class((unsigned) _input[pos]) : 0);");
+                writer.WriteLine("            if(prod < 0) return false;");
+                writer.WriteLine("        }");
+            }
+            writer.WriteLine("        const SProd& p = Prods()[prod];");
+            writer.WriteLine("        SFrame f;");
+            writer.WriteLine("        f.pc  = p.pc;");
+            writer.WriteLine("        f.out = out;");
+            writer.WriteLine("        f.pos = _positions.GetSize();");
+            writer.WriteLine("        for(int i = 0; i < p.steps; i++) {");
+            writer.WriteLine("            _positions.Add(pos);");
+            writer.WriteLine("        }");
+            for(int t = 0; t < _types.Count; t++) {
+                writer.WriteLine("        f.values[{0}] = Alloc({1}, p.values[{0}]);", t, Values(_types[t]));
+            }
+            writer.WriteLine("        _frames.Add(f);");
+            writer.WriteLine("        return true;");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    void Leave() {");
+            writer.WriteLine("        const SFrame& f = _frames[_frames.GetSize()-1];");
+            writer.WriteLine("        _positions.SetSize(f.pos);");
+            for(int t = 0; t < _types.Count; t++) {
+                writer.WriteLine("        {0}.SetSize(f.values[{1}]);", Values(_types[t]), t);
+            }
+            writer.WriteLine("        _frames.SetSize(_frames.GetSize()-1);");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+            writer.WriteLine("    // Parses the NTS into the given slot of the value stack. On failure, pos is the position of the error.");
+            writer.WriteLine("    bool Run(int nt, int out, int& pos) {");
+            writer.WriteLine("        const SOp* ops = Ops();");
+            writer.WriteLine("        _frames.SetSize(0);");
+            writer.WriteLine("        _positions.SetSize(0);");
+            writer.WriteLine("        if(!Enter(nt, out, pos)) return false;");
+            writer.WriteLine("        while(true) {");
+            writer.WriteLine("            SFrame& f = _frames[_frames.GetSize()-1];");
+            writer.WriteLine("            const SOp& op = ops[f.pc++];");
+            writer.WriteLine("            switch(op.code) {");
+            writer.WriteLine("                case OP_TC:");
+            writer.WriteLine("                    if(pos >= _size || _input[pos] != ({0}) op.a) return false;", _grammar.Type);
+            writer.WriteLine("                    pos++;");
+            writer.WriteLine("                    break;");
+            if(need_ts) {
+                writer.WriteLine("                case OP_TS:");
+                writer.WriteLine("                    if(!ts(pos, Strings()[op.a], op.b)) return false;");
+                writer.WriteLine("                    break;");
+            }
+            if(need_tset) {
+                writer.WriteLine("                case OP_TSET:");
+                writer.WriteLine("                    if(!tset(pos, Strings()[op.a], op.b)) return false;");
+                writer.WriteLine("                    break;");
+            }
+            if(need_tnotset) {
+                writer.WriteLine("                case OP_TNOTSET:");
+                writer.WriteLine("                    if(!tnotset(pos, Strings()[op.a], op.b)) return false;");
+                writer.WriteLine("                    break;");
+            }
+            if(need_trange) {
+                writer.WriteLine("                case OP_TRANGE:");
+                writer.WriteLine("                    if(pos >= _size || _input[pos] < ({0}) op.a || _input[pos] > ({0}) op.b) return false;", _grammar.Type);
+                writer.WriteLine("                    pos++;");
+                writer.WriteLine("                    break;");
+            }
+            writer.WriteLine("                case OP_CALL:");
+            writer.WriteLine("                    if(!Enter(op.a, op.b < 0 ? f.out : f.values[Rules()[op.a].type] + op.b, pos)) return false;");
+            writer.WriteLine("                    continue; // posN is set on return");
+            if(_actions.Count > 0) {
+                writer.WriteLine("                case OP_CODE:");
+                writer.WriteLine("                    Action(op.a, f);");
+                writer.WriteLine("                    continue;");
+            }
+            writer.WriteLine("                case OP_RETURN:");
+            writer.WriteLine("                    Leave();");
+            writer.WriteLine("                    if(_frames.GetSize() == 0) return true;");
+            writer.WriteLine("                    _positions[_frames[_frames.GetSize()-1].pos + ops[_frames[_frames.GetSize()-1].pc-1].step] = pos;");
+            writer.WriteLine("                    continue;");
+            writer.WriteLine("            }");
+            writer.WriteLine("            _positions[f.pos + op.step] = pos;");
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        // Generates the source code fragments as cases of a switch. Only the variables a fragment
+        // uses are bound to the frame, outputN as references into the value stacks.
+        private void GenerateActions(TextWriter writer)
+        {
+            if(_actions.Count == 0) {
+                return;
+            }
+            writer.WriteLine("    void Action(int action, const SFrame& f) {");
+            writer.WriteLine("        switch(action) {");
+            for(int i = 0; i < _actions.Count; i++) {
+                Action action = _actions[i];
+                writer.WriteLine("            case {0}: {{ // {1}", i, action.Sym.Name);
+                if(Uses(action.Code, "output")) {
+                    writer.WriteLine("                {0}& output = {1}[f.out];", action.Sym.Type, Values(action.Sym.Type));
+                }
+                foreach(KeyValuePair<int, int[]> output in action.Outputs) {
+                    string type = _types[output.Value[0]];
+                    if(Uses(action.Code, "output" + output.Key)) {
+                        writer.WriteLine("                {0}& output{1} = {2}[f.values[{3}] + {4}];", type, output.Key, Values(type), output.Value[0], output.Value[1]);
+                    }
+                }
+                for(int n = 0; n < action.Steps; n++) {
+                    if(Uses(action.Code, "pos" + n)) {
+                        writer.WriteLine("                int pos{0} = _positions[f.pos + {0}];", n);
+                    }
+                }
+                writer.WriteLine("                {0};", action.Code);
+                writer.WriteLine("                break;");
+                writer.WriteLine("            }");
+            }
+            writer.WriteLine("        }");
+            writer.WriteLine("    }");
+            writer.WriteLine("");
+        }
+
+        private void GenerateTerminals(TextWriter writer)
+        {
+            if(need_ts) {
+                writer.WriteLine("    bool ts(int& pos, const {0}* s, int slen) {{", _grammar.Type);
+                writer.WriteLine("        for(int i = 0; i < slen; i++) {");
+                writer.WriteLine("            if(pos >= _size || _input[pos] != s[i]) return false;");
+                writer.WriteLine("            pos++;");
+                writer.WriteLine("        }");
+                writer.WriteLine("        return true;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+            }
+            if(need_tset) {
+                writer.WriteLine("    bool tset(int& pos, const {0}* s, int slen) {{", _grammar.Type);
+                writer.WriteLine("        for(int i = 0; i < slen; i++) {");
+                writer.WriteLine("            if(pos < _size && s[i] == _input[pos]) {");
+                writer.WriteLine("                pos++;");
+                writer.WriteLine("                return true;");
+                writer.WriteLine("            }");
+                writer.WriteLine("        }");
+                writer.WriteLine("        return false;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+            }
+            if(need_tnotset) {
+                writer.WriteLine("    bool tnotset(int& pos, const {0}* s, int slen) {{", _grammar.Type);
+                writer.WriteLine("        for(int i = 0; i < slen; i++) {");
+                writer.WriteLine("            if(pos >= _size || s[i] == _input[pos]) {");
+                writer.WriteLine("                return false;");
+                writer.WriteLine("            }");
+                writer.WriteLine("        }");
+                writer.WriteLine("        pos++;");
+                writer.WriteLine("        return true;");
+                writer.WriteLine("    }");
+                writer.WriteLine("");
+            }
+        }
+
+        private static bool Uses(string code, string name)
+        {
+            return Regex.IsMatch(code, "\\b" + name + "\\b");
+        }
+
+        private static string Values(string type)
+        {
+            return "_values_" + Regex.Replace(type.Replace("*", "_ptr"), "[^A-Za-z0-9_]", "_");
+        }
+    }
+}
\ No newline at end of file
@@ -15,12 +15,247 @@ namespace RSPT
         public string                Class;                         // the C++ or C# class 
         public string                Type;                          // C++ or C# type for input symbols
         public readonly List<string> Codes = new List<string>();    // a list of C++ or C# source code fragments 
+        public readonly List<string> Options = new List<string>();  // a list of code generator options
 
         public Grammar(TextReader reader) {
             List<string> tokens = Tokenize(reader);
             Parse(tokens);
         }
 
+        private Grammar() { }
+
+        // Returns a copy of the grammar that only recognizes the input: source code fragments and <to:xxx>
+        // are removed and the NTS have no type. The TS and the other instructions are shared with this grammar.
+        public Grammar Recognizer()
+        {
+            Grammar copy = new Grammar();
+            copy.Namespace = Namespace;
+            copy.Class     = Class;
+            copy.Type      = Type;
+            copy.Options.AddRange(Options);
+            foreach(SymbolNonTerm sym in NonTerms) {
+                SymbolNonTerm sym2 = copy.GetNonTerm(sym.Name);
+                copy.NonTerms.Add(sym2);
+                sym2.Inline = sym.Inline;
+                sym2.Memo   = sym.Memo;
+                sym2.Sync   = sym.Sync;
+                if(sym.Operand != null) {
+                    sym2.Operand = copy.GetNonTerm(sym.Operand.Name);
+                }
+                foreach(List<Symbol> rule in sym.Rules) {
+                    List<Symbol> rule2 = new List<Symbol>();
+                    foreach(Symbol sym3 in rule) {
+                        if(sym3 is SymbolNonTerm) {
+                            rule2.Add(copy.GetNonTerm(sym3.Token));
+                        } else if(!(sym3 is SymbolCode) && !(sym3 is SymbolInstr && (sym3 as SymbolInstr).Instruction == Instruction.TO)) {
+                            rule2.Add(sym3);
+                        }
+                    }
+                    sym2.Rules.Add(rule2);
+                }
+            }
+            foreach(SymbolNonTerm sym in Exports) {
+                copy.Exports.Add(copy.GetNonTerm(sym.Name));
+            }
+            return copy;
+        }
+
+        // Rewrites the grammar for UTF-8 input (<option:utf8>): the text of every TS becomes its UTF-8 byte sequence
+        // (one char per byte). A <set>, <range> or <notset> that matches code points above ASCII is replaced by a call
+        // of a new NTS, whose alternatives match the UTF-8 byte sequences of the code points, with a TS or <range> per
+        // byte (see AddUtf8()). Equal instructions share the same NTS.
+        public void EncodeUtf8()
+        {
+            Dictionary<string, SymbolNonTerm> classes = new Dictionary<string, SymbolNonTerm>();
+            foreach(SymbolNonTerm sym in NonTerms.ToArray()) {
+                if(sym.Sync != null) {
+                    sym.Sync = Utf8(sym.Sync);
+                }
+                foreach(List<Symbol> rule in sym.Rules) {
+                    for(int i = 0; i < rule.Count; i++) {
+                        SymbolTerm  term  = rule[i] as SymbolTerm;
+                        SymbolInstr instr = i > 0 ? rule[i-1] as SymbolInstr : null;
+                        if(term == null) {
+                            continue;
+                        }
+                        if(instr == null || (instr.Instruction != Instruction.SET && instr.Instruction != Instruction.RANGE && instr.Instruction != Instruction.NOTSET)) {
+                            if(Utf8(term.Text) != term.Text) {
+                                rule[i] = new SymbolTerm("'" + Utf8(term.Text) + "'");
+                            }
+                            continue;
+                        }
+                        List<int> ranges = CodePoints(sym, instr.Instruction, term.Text);
+                        if(ranges.Count == 0 || ranges[ranges.Count-1] < 0x80) {
+                            continue; // ASCII only, the bytes are the code points
+                        }
+                        SymbolNonTerm cls;
+                        if(!classes.TryGetValue(instr.Token + term.Token, out cls)) {
+                            int n = 1;
+                            while(Index.ContainsKey(string.Format("{0}_UTF8_{1}", sym.Name, n))) {
+                                n++;
+                            }
+                            cls = GetNonTerm(string.Format("{0}_UTF8_{1}", sym.Name, n));
+                            NonTerms.Add(cls);
+                            List<List<int>> sequences = new List<List<int>>();
+                            for(int j = 0; j < ranges.Count; j += 2) {
+                                SplitUtf8(sequences, ranges[j], ranges[j+1]);
+                            }
+                            AddUtf8(cls, sequences, 0);
+                            classes.Add(instr.Token + term.Token, cls);
+                        }
+                        rule.RemoveAt(i-1);
+                        rule[i-1] = cls;
+                        i--;
+                    }
+                }
+            }
+        }
+
+        // Returns the UTF-8 encoding of the text, one char per byte.
+        public static string Utf8(string text)
+        {
+            StringBuilder sb = new StringBuilder();
+            foreach(byte b in Encoding.UTF8.GetBytes(text)) {
+                sb.Append((char) b);
+            }
+            return sb.ToString();
+        }
+
+        // Returns the code points matched by a <set>, <range> or <notset> as sorted pairs of inclusive lower and
+        // upper bounds. The surrogates are no code points and have no UTF-8 encoding.
+        private static List<int> CodePoints(SymbolNonTerm sym, Instruction instr, string text)
+        {
+            List<int> chars = new List<int>();
+            for(int i = 0; i < text.Length; i += char.IsSurrogatePair(text, i) ? 2 : 1) {
+                chars.Add(char.ConvertToUtf32(text, i));
+            }
+            List<int> ranges = new List<int>();
+            if(instr == Instruction.RANGE) {
+                if(chars.Count != 2) {
+                    throw new Exception(string.Format("{0}: Invalid range '{1}', expected two characters.", sym.Name, text));
+                }
+                AddRange(ranges, chars[0], chars[1]);
+            } else {
+                chars.Sort();
+                foreach(int c in chars) {
+                    AddRange(ranges, c, c);
+                }
+            }
+            if(instr == Instruction.NOTSET) {
+                List<int> others = new List<int>();
+                int next = 0;
+                for(int i = 0; i < ranges.Count; i += 2) {
+                    AddRange(others, next, ranges[i]-1);
+                    next = ranges[i+1]+1;
+                }
+                AddRange(others, next, 0x10FFFF);
+                ranges = others;
+            }
+            List<int> valid = new List<int>();
+            for(int i = 0; i < ranges.Count; i += 2) {
+                AddRange(valid, ranges[i], Math.Min(ranges[i+1], 0xD7FF));
+                AddRange(valid, Math.Max(ranges[i], 0xE000), ranges[i+1]);
+            }
+            return valid;
+        }
+
+        private static void AddRange(List<int> ranges, int lo, int hi)
+        {
+            if(lo > hi) {
+                return;
+            }
+            if(ranges.Count > 0 && lo <= ranges[ranges.Count-1]+1) {
+                ranges[ranges.Count-1] = Math.Max(ranges[ranges.Count-1], hi);
+            } else {
+                ranges.Add(lo);
+                ranges.Add(hi);
+            }
+        }
+
+        // Adds the UTF-8 byte sequences of the code points [lo, hi] to the list, one pair of inclusive lower and upper
+        // bounds per byte. The range is split until all code points have the same length and every byte is a range
+        // independent of the other bytes, e.g. U+0800-U+FFFF into E0 A0-BF 80-BF | E1-EF 80-BF 80-BF (and so on).
+        private static void SplitUtf8(List<List<int>> sequences, int lo, int hi)
+        {
+            foreach(int max in new int[] { 0x7F, 0x7FF, 0xFFFF }) {
+                if(lo <= max && max < hi) {
+                    SplitUtf8(sequences, lo, max);
+                    SplitUtf8(sequences, max+1, hi);
+                    return;
+                }
+            }
+            string first = Utf8(char.ConvertFromUtf32(lo));
+            string last  = Utf8(char.ConvertFromUtf32(hi));
+            for(int i = 1; i < first.Length; i++) {
+                int m = (1 << (6*i)) - 1;
+                if((lo & ~m) != (hi & ~m)) {
+                    if((lo & m) != 0) {
+                        SplitUtf8(sequences, lo, lo | m);
+                        SplitUtf8(sequences, (lo | m)+1, hi);
+                        return;
+                    }
+                    if((hi & m) != m) {
+                        SplitUtf8(sequences, lo, (hi & ~m)-1);
+                        SplitUtf8(sequences, hi & ~m, hi);
+                        return;
+                    }
+                }
+            }
+            List<int> sequence = new List<int>();
+            for(int i = 0; i < first.Length; i++) {
+                sequence.Add(first[i]);
+                sequence.Add(last[i]);
+            }
+            sequences.Add(sequence);
+        }
+
+        // Adds an alternative per byte sequence, from the byte at the given offset on. Sequences that start with the
+        // same range share an alternative, which continues in a new NTS, so the alternatives stay LL(1) and lexical
+        // NTS can still be compiled into scanners.
+        private void AddUtf8(SymbolNonTerm sym, List<List<int>> sequences, int offset)
+        {
+            int i = 0;
+            while(i < sequences.Count) {
+                List<int> sequence = sequences[i];
+                int j = i+1;
+                while(j < sequences.Count && sequences[j][2*offset] == sequence[2*offset] && sequences[j][2*offset+1] == sequence[2*offset+1]) {
+                    j++;
+                }
+                List<Symbol> rule  = new List<Symbol>();
+                int          end   = j == i+1 ? sequence.Count/2 : offset+1;
+                string       bytes = "";
+                for(int k = offset; k < end; k++) {
+                    int lo = sequence[2*k];
+                    int hi = sequence[2*k+1];
+                    if(lo == hi) {
+                        bytes += (char) lo;
+                        continue;
+                    }
+                    if(bytes.Length > 0) {
+                        rule.Add(new SymbolTerm("'" + bytes + "'"));
+                        bytes = "";
+                    }
+                    rule.Add(new SymbolInstr("<range>"));
+                    rule.Add(new SymbolTerm("'" + (char) lo + (char) hi + "'"));
+                }
+                if(bytes.Length > 0) {
+                    rule.Add(new SymbolTerm("'" + bytes + "'"));
+                }
+                if(j > i+1) {
+                    int n = 1;
+                    while(Index.ContainsKey(string.Format("{0}_{1}", sym.Name, n))) {
+                        n++;
+                    }
+                    SymbolNonTerm next = GetNonTerm(string.Format("{0}_{1}", sym.Name, n));
+                    NonTerms.Add(next);
+                    AddUtf8(next, sequences.GetRange(i, j-i), offset+1);
+                    rule.Add(next);
+                }
+                sym.Rules.Add(rule);
+                i = j;
+            }
+        }
+
         private List<string> Tokenize(TextReader reader) 
         {
             List<string>  tokens = new List<string>();
@@ -105,16 +340,27 @@ namespace RSPT
         {
             int  pos = 0;
             bool exp = false;
+            bool memo = false;
+            string sync = null;
+            SymbolNonTerm operand = null;
             while(pos < tokens.Count) {
                 string symbol = tokens[pos];
                 if(symbol == "<export>") {
                     exp = true;
+                } else if(symbol == "<memo>") {
+                    memo = true;
+                } else if(symbol.StartsWith("<sync:'") && symbol.EndsWith("'>") && symbol.Length > 9) {
+                    sync = symbol.Substring(7, symbol.Length-9);
+                } else if(symbol.StartsWith("<operators:") && symbol[symbol.Length-1] == '>') {
+                    operand = GetNonTerm(symbol.Substring(11, symbol.Length-12));
                 } else if(symbol.StartsWith("<include:") && symbol[symbol.Length-1] == '>') {
                     Includes.Add(symbol.Substring(9, symbol.Length-10));
                 } else if(symbol.StartsWith("<namespace:") && symbol[symbol.Length-1] == '>') {
                     Namespace = symbol.Substring(11, symbol.Length-12);
                 } else if(symbol.StartsWith("<class:") && symbol[symbol.Length-1] == '>') {
                     Class = symbol.Substring(7, symbol.Length-8);
+                } else if(symbol.StartsWith("<option:") && symbol[symbol.Length-1] == '>') {
+                    Options.Add(symbol.Substring(8, symbol.Length-9));
                 } else if(symbol.Length > 2 && symbol[0] == '{' && symbol[symbol.Length-1] == '}') {
                     Codes.Add(symbol.Substring(1, symbol.Length-2));
                 } else {
@@ -124,6 +370,12 @@ namespace RSPT
                         Exports.Add(sym);
                         exp = false;
                     }
+                    sym.Memo = memo;
+                    sym.Sync = sync;
+                    sym.Operand = operand;
+                    memo = false;
+                    sync = null;
+                    operand = null;
                     pos++;
                     if(tokens[pos] == ":") {
                        sym.Type = tokens[pos+1];
@@ -27,12 +27,16 @@ namespace RSPT
 
         private bool ParseNT(SymbolNonTerm sym, char[] input, ref int pos, List<char> output)
         {
+            if(sym.Operand != null) {
+                throw new Exception(string.Format("{0}: <operators:...> is not supported by the interpreter.", sym.Name));
+            }
             foreach(List<Symbol> rule in sym.Rules) {
                 List<int>        posAry    = new List<int>();
                 List<List<char>> outputAry = new List<List<char>>();
 
                 bool ok = true;
                 int pos2 = pos;
+                int outputCount = output.Count; // the output appended by a failed alternative is removed again
                 posAry.Add(pos2);
 
                 string ins_to  = null;
@@ -87,6 +91,7 @@ namespace RSPT
                     pos = pos2;
                     return true;
                 }
+                output.RemoveRange(outputCount, output.Count - outputCount);
             }
             return false;
         }
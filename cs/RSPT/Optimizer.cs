@@ -0,0 +1,243 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+
+namespace RSPT
+{
+    public class Optimizer // transforms a grammar into an equivalent grammar that parses faster
+    {
+        private readonly Grammar  _grammar;
+        private readonly Analysis _analysis;
+
+        public Optimizer(Grammar grammar) {
+            _grammar  = grammar;
+            _analysis = new Analysis(grammar);
+        }
+
+        // Reads a profile written by ProfileReport() of a parser generated with <option:profile>.
+        // Returns the number of successes for every alternative, indexed by the name of the NTS.
+        public static Dictionary<string, List<double>> ReadProfile(TextReader reader)
+        {
+            Dictionary<string, List<double>> profile = new Dictionary<string, List<double>>();
+            string line;
+            while((line = reader.ReadLine()) != null) {
+                string[] fields = line.Split(new char[] { ' ', '\t' }, StringSplitOptions.RemoveEmptyEntries);
+                int    alt;
+                double count;
+                if(fields.Length < 4 || fields[0].StartsWith("#") ||  // skip headers and other output
+                   !int.TryParse(fields[1], NumberStyles.None, CultureInfo.InvariantCulture, out alt) || alt < 1 ||
+                   !double.TryParse(fields[3], NumberStyles.Float, CultureInfo.InvariantCulture, out count)) {
+                    continue;
+                }
+                if(!profile.ContainsKey(fields[0])) {
+                    profile.Add(fields[0], new List<double>());
+                }
+                List<double> successes = profile[fields[0]];
+                while(successes.Count < alt) {
+                    successes.Add(0);
+                }
+                successes[alt-1] = count;
+            }
+            return profile;
+        }
+
+        // Reorders alternatives by their observed number of successes, most frequent first.
+        // An alternative can only be moved if it always consumes input, does not run code before it
+        // consumes input, and its FIRST set is disjoint from the FIRST sets of the alternatives it
+        // is moved across. Then at most one of these alternatives can match any given input, so the
+        // order does not matter to ordered choice and the result of the parser is unchanged.
+        public void ReorderAlternatives(Dictionary<string, List<double>> profile)
+        {
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                List<double> successes;
+                if(sym.Operand != null || !profile.TryGetValue(sym.Name, out successes)) {
+                    continue;
+                }
+                if(successes.Count != sym.Rules.Count) {
+                    Console.WriteLine("WARNING: {0}: Profile does not match the grammar, alternatives are not reordered.", sym.Name);
+                    continue;
+                }
+                List<int> order = new List<int>();
+                int start = 0;
+                while(start < sym.Rules.Count) {
+                    int end = start + 1;
+                    if(IsMovable(sym.Rules[start])) {
+                        while(end < sym.Rules.Count && IsMovable(sym.Rules[end]) && IsDisjoint(sym.Rules, start, end)) {
+                            end++;
+                        }
+                    }
+                    for(int i = start; i < end; i++) { // stable insertion sort of the run [start, end)
+                        int j = order.Count;
+                        while(j > start && successes[order[j-1]] < successes[i]) {
+                            j--;
+                        }
+                        order.Insert(j, i);
+                    }
+                    start = end;
+                }
+                bool changed = false;
+                List<List<Symbol>> rules = new List<List<Symbol>>();
+                for(int i = 0; i < order.Count; i++) {
+                    rules.Add(sym.Rules[order[i]]);
+                    changed = changed || order[i] != i;
+                }
+                if(changed) {
+                    sym.Rules.Clear();
+                    sym.Rules.AddRange(rules);
+                    Console.WriteLine("{0}: Reordered alternatives to {1}.", sym.Name, FormatOrder(order));
+                }
+            }
+        }
+
+        // Reduces the number of nt_ functions called per input symbol (<option:inline>):
+        // - references to pass-through NTS like X = Y {output = output1}; are redirected to Y,
+        // - references to NTS without output that consist of a single TS like DIGIT = <range> '09';
+        //   are replaced by the TS and the NTS is removed if it is no longer used (not with <option:append>,
+        //   as the output templates refer to the NTS by number),
+        // - NTS with a single call site are marked to be generated inline, as long as this does not
+        //   make a cycle of inline functions.
+        // Source code fragments are never moved, so the numbering of posN and outputN is preserved.
+        public void Inline()
+        {
+            Dictionary<SymbolNonTerm, int> before = CountCalls();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                SymbolNonTerm operand;
+                while(sym.Operand != null && (operand = GetPassThrough(sym.Operand)) != null && operand != sym) {
+                    sym.Operand = operand;
+                }
+                foreach(List<Symbol> rule in sym.Rules) {
+                    for(int i = 0; i < rule.Count; i++) {
+                        if(!(rule[i] is SymbolNonTerm) || (i > 0 && rule[i-1] is SymbolInstr)) {
+                            continue; // a NTS with <to:xxx> works on the caller's output, which a pass-through NTS does not forward
+                        }
+                        SymbolNonTerm target = rule[i] as SymbolNonTerm;
+                        SymbolNonTerm next;
+                        while((next = GetPassThrough(target)) != null && next != sym) {
+                            target = next;
+                        }
+                        List<Symbol> terminal = _grammar.Options.Contains("append") ? null : GetTerminal(target);
+                        if(terminal != null && target != sym) {
+                            rule.RemoveAt(i);
+                            rule.InsertRange(i, terminal);
+                            i += terminal.Count - 1;
+                        } else {
+                            rule[i] = target;
+                        }
+                    }
+                }
+            }
+
+            Dictionary<SymbolNonTerm, int> calls = CountCalls();
+            foreach(SymbolNonTerm sym in before.Keys) {
+                if(before[sym] > 0 && calls[sym] == 0 && !_grammar.Exports.Contains(sym)) {
+                    _grammar.NonTerms.Remove(sym);
+                    _grammar.Index.Remove(sym.Name);
+                    Console.WriteLine("{0}: Removed, all references have been inlined.", sym.Name);
+                }
+            }
+
+            calls = CountCalls();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(calls[sym] == 1 && !_grammar.Exports.Contains(sym) && !IsReachable(sym, sym, true)) {
+                    sym.Inline = true;
+                }
+            }
+        }
+
+        // Returns Y if the NTS is defined as X = Y {output = output1}; with X and Y of the same type.
+        private static SymbolNonTerm GetPassThrough(SymbolNonTerm sym)
+        {
+            if(sym.Operand != null || sym.Rules.Count != 1 || sym.Rules[0].Count != 2) {
+                return null;
+            }
+            SymbolNonTerm target = sym.Rules[0][0] as SymbolNonTerm;
+            SymbolCode    code   = sym.Rules[0][1] as SymbolCode;
+            if(target == null || code == null || code.Code.Replace(" ", "") != "output=output1" || target.Type != sym.Type) {
+                return null;
+            }
+            return target;
+        }
+
+        // Returns the TS (and its instruction) if the NTS is defined as a single TS and has no output.
+        private static List<Symbol> GetTerminal(SymbolNonTerm sym)
+        {
+            if(sym.Operand != null || sym.Rules.Count != 1 || (sym.Type != null && sym.Type != "void*")) {
+                return null;
+            }
+            List<Symbol> rule = sym.Rules[0];
+            if(rule.Count == 1 && rule[0] is SymbolTerm) {
+                return rule;
+            }
+            if(rule.Count == 2 && rule[0] is SymbolInstr && (rule[0] as SymbolInstr).Instruction != Instruction.TO && rule[1] is SymbolTerm) {
+                return rule;
+            }
+            return null;
+        }
+
+        private Dictionary<SymbolNonTerm, int> CountCalls()
+        {
+            Dictionary<SymbolNonTerm, int> calls = new Dictionary<SymbolNonTerm, int>();
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                calls[sym] = 0;
+            }
+            foreach(SymbolNonTerm sym in _grammar.NonTerms) {
+                if(sym.Operand != null) {
+                    calls[sym.Operand]++;
+                }
+                foreach(List<Symbol> rule in sym.Rules) {
+                    foreach(Symbol sym2 in rule) {
+                        if(sym2 is SymbolNonTerm && !(sym2 == sym && sym.Operand != null)) { // the right operand of an operator calls op_X
+                            calls[sym2 as SymbolNonTerm]++;
+                        }
+                    }
+                }
+            }
+            return calls;
+        }
+
+        // Returns true if target is called by sym, directly or through NTS marked as inline.
+        private static bool IsReachable(SymbolNonTerm sym, SymbolNonTerm target, bool first)
+        {
+            if(!first && (sym == target || !sym.Inline)) {
+                return sym == target;
+            }
+            if(sym.Operand != null && IsReachable(sym.Operand, target, false)) {
+                return true;
+            }
+            foreach(List<Symbol> rule in sym.Rules) {
+                foreach(Symbol sym2 in rule) {
+                    if(sym2 is SymbolNonTerm && !(sym2 == sym && sym.Operand != null) && IsReachable(sym2 as SymbolNonTerm, target, false)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        private bool IsMovable(List<Symbol> rule)
+        {
+            return !_analysis.IsNullable(rule) && !_analysis.HasLeadingCode(rule);
+        }
+
+        private bool IsDisjoint(List<List<Symbol>> rules, int start, int end)
+        {
+            CharSet first = _analysis.First(rules[end]);
+            for(int i = start; i < end; i++) {
+                if(first.Intersects(_analysis.First(rules[i]))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        private static string FormatOrder(List<int> order)
+        {
+            string text = "";
+            foreach(int i in order) {
+                text += (text.Length > 0 ? " " : "") + (i+1);
+            }
+            return text;
+        }
+    }
+}
@@ -10,15 +10,43 @@ namespace RSPT
         {
             if(args.Length == 0) {
                 Console.WriteLine("RSPT - Really Simple Parser Tool - (C) 2015 Philip Oswald");
-                Console.WriteLine("Usage: $ RSPT.exe -gen=cs   <grammar.txt> <output.cs>");
-                Console.WriteLine("                  -gen=cpp  <grammar.txt> <output.h>");
-                Console.WriteLine("                  -gen=java <grammar.txt> <output.java>");
+                Console.WriteLine("Usage: $ RSPT.exe [-opt=<option> ...] [-prof=<profile.txt>] -gen=cs   <grammar.txt> <output.cs>");
+                Console.WriteLine("                  [-opt=<option> ...] [-prof=<profile.txt>] -gen=cpp  <grammar.txt> <output.h>");
+                Console.WriteLine("                  [-opt=<option> ...] [-prof=<profile.txt>] -gen=java <grammar.txt> <output.java>");
+                Console.WriteLine("                  [-opt=<option> ...] -gen=cpptable <grammar.txt> <output.h>");
                 Console.WriteLine("                  -par=txt  <grammar.txt> <input.txt> <output.txt>");
                 Console.WriteLine("Where:");
+                Console.WriteLine("    -opt=xxx  enables a code generator option (same as <option:xxx> in the grammar)");
+                Console.WriteLine("    -prof=xxx reorders alternatives by the profile written by ProfileReport()");
+                Console.WriteLine("              of a parser generated with -opt=profile (where this is safe)");
                 Console.WriteLine("    -gen=cs   generates a parser for the given grammar in C#");
                 Console.WriteLine("    -gen=cpp  generates a parser for the given grammar in C++");
+                Console.WriteLine("              (with Validate_X() next to every Parse_X(), which only recognizes the input)");
                 Console.WriteLine("    -gen=java generates a parser for the given grammar in Java");
+                Console.WriteLine("    -gen=cpptable generates a non-recursive, table driven LL(1) parser in C++");
+                Console.WriteLine("              (conflicts are reported if the grammar is not LL(1))");
                 Console.WriteLine("    -par=txt  parses the input using the given grammar");
+                Console.WriteLine("Options:");
+                Console.WriteLine("    profile   instruments the C++ parser to count calls, successes, failures,");
+                Console.WriteLine("              consumed and backtracked characters per rule and alternative");
+                Console.WriteLine("    inline    redirects pass-through rules, replaces single terminal rules by the");
+                Console.WriteLine("              terminal and generates rules with a single call site inline");
+                Console.WriteLine("    scanner   compiles rules that consist of terminals only (and are LL(1))");
+                Console.WriteLine("              into DFA scanner functions (C++, not together with profile)");
+                Console.WriteLine("    append    compiles the actions of rules without type as output templates");
+                Console.WriteLine("              (like -par=txt) into appends to one output buffer (C++)");
+                Console.WriteLine("    events    generates a C++ parser template that reports rules and tokens to a");
+                Console.WriteLine("              handler class instead of computing outputs (overrides append)");
+                Console.WriteLine("    tree      like events, but records the rules and tokens as a flat syntax tree");
+                Console.WriteLine("              (an array of nodes linked by index, see GetTree())");
+                Console.WriteLine("    incremental like tree, but after Edit() the next parse only parses the smallest rule");
+                Console.WriteLine("              that encloses the edit again and copies the unchanged subtrees");
+                Console.WriteLine("    budget    limits the nt_ calls and the time of a C++ parse (see SetBudget()),");
+                Console.WriteLine("              an exceeded budget fails the parse (see IsBudgetExceeded())");
+                Console.WriteLine("    utf8      parses UTF-8 input (char) in C++ without converting it: the TS are UTF-8");
+                Console.WriteLine("              byte sequences, <set>, <range> and <notset> match code points");
+                Console.WriteLine("    arena     allocates the values of Str() and New() in actions from an arena that");
+                Console.WriteLine("              is reset by each C++ Parse_X, instead of the heap (see SetArena())");
                 Console.WriteLine("Notes:");
                 Console.WriteLine("  All parsers are top down (recursive descent) parsers that");
                 Console.WriteLine("  can parse non-left recursive LL(x) grammars. Grammars contain rules,");
@@ -28,13 +56,25 @@ namespace RSPT
             }
 
             int i = 0;
+            List<string> options = new List<string>();
+            string       profile = null;
             while(i < args.Length) {
-                if(args[i].StartsWith("-gen=")) {
+                if(args[i].StartsWith("-opt=")) {
+                    options.Add(args[i].Substring(5));
+                    i += 1;
+
+                } else if(args[i].StartsWith("-prof=")) {
+                    profile = args[i].Substring(6);
+                    i += 1;
+
+                } else if(args[i].StartsWith("-gen=")) {
                     if(i+2 >= args.Length) {
                         Console.WriteLine("ERROR: Not enough arguments for -gen=...");
                         break;
                     }
-                    Generate(args[i+1], args[i+2], args[i].Substring(5));
+                    Generate(args[i+1], args[i+2], args[i].Substring(5), options, profile);
+                    options = new List<string>();
+                    profile = null;
                     i += 3;
 
                 } else if(args[i] == "-par=txt") {
@@ -52,13 +92,22 @@ namespace RSPT
             }
         }
 
-        private static void Generate(string grammarFile, string parserFile, string type)
+        private static void Generate(string grammarFile, string parserFile, string type, List<string> options, string profileFile)
         {
             Console.WriteLine("Generating parser '{0}' from grammar '{1}'.", parserFile, grammarFile);
 
             try {
                 using(TextReader grammarStream  = new StreamReader(new FileStream(grammarFile, FileMode.Open, FileAccess.Read))) {
                     Grammar grammar = new Grammar(grammarStream);
+                    grammar.Options.AddRange(options);
+                    if(profileFile != null) {
+                        using(TextReader profileStream = new StreamReader(new FileStream(profileFile, FileMode.Open, FileAccess.Read))) {
+                            new Optimizer(grammar).ReorderAlternatives(Optimizer.ReadProfile(profileStream));
+                        }
+                    }
+                    if(grammar.Options.Contains("inline")) {
+                        new Optimizer(grammar).Inline();
+                    }
                     using(TextWriter parserStream = new StreamWriter(new FileStream(parserFile, FileMode.Create))) {
                         Generator generator; 
                         if(type == "cs") {
@@ -67,6 +116,8 @@ namespace RSPT
                             generator = new GeneratorRecursiveCPP(grammar);
                         } else if(type == "java") {
                             generator = new GeneratorRecursiveJava(grammar);
+                        } else if(type == "cpptable") {
+                            generator = new GeneratorTableCPP(grammar);
                         } else {
                             throw new Exception(string.Format("Invalid generator type '{0}'.", type));
                         }
@@ -0,0 +1,401 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+
+namespace RSPT
+{
+    // A minimized DFA that matches the same input as a NTS built from TS only (a lexical NTS like
+    // IDENT or NUMBER), so that it can be scanned in a single pass without calls and backtracking.
+    //
+    // Ordered choice is not the same as the choice of a DFA, so only NTS whose rules (and the rules
+    // of the NTS they use) are LL(1) are compiled: the alternatives of every NTS start with different
+    // input symbols, an alternative that can match the empty input comes last and the alternatives
+    // of such a NTS do not start with a symbol that can follow it. Then the alternative chosen by the
+    // next input symbol is the only one that can match, and if it fails later on, the parser can only
+    // fall back to ending the NTS early. The result is the last position at which the DFA accepted.
+    public class Scanner
+    {
+        public class State
+        {
+            public bool          Accept;                      // the NTS can end here
+            public List<CharSet> Labels  = new List<CharSet>(); // the input symbols of every transition
+            public List<int>     Targets = new List<int>();
+        }
+
+        private class Item // a position within a rule, Off is the position within a TS of several symbols
+        {
+            public List<Symbol> Rule;
+            public int          Idx;
+            public int          Off;
+        }
+
+        private const int MaxStates = 1000;
+        private const int MaxDepth  = 64;
+
+        private readonly Analysis                    _analysis;
+        private readonly Dictionary<List<Symbol>, int> _ids = new Dictionary<List<Symbol>, int>();
+
+        public readonly List<State> States = new List<State>(); // States[0] is the start state
+
+        // Returns the NTS that only consist of TS and other such NTS and have no output. NTS with <sync:'xxx'> are
+        // not lexical, they are searched in parallel by the parser itself.
+        public static List<SymbolNonTerm> FindLexical(Grammar grammar)
+        {
+            List<SymbolNonTerm> lexical = new List<SymbolNonTerm>();
+            foreach(SymbolNonTerm sym in grammar.NonTerms) {
+                if(sym.Operand == null && !sym.Memo && sym.Sync == null && (sym.Type == null || sym.Type == "void*")) {
+                    lexical.Add(sym);
+                }
+            }
+            bool changed = true;
+            while(changed) {
+                changed = false;
+                foreach(SymbolNonTerm sym in lexical.ToArray()) {
+                    foreach(List<Symbol> rule in sym.Rules) {
+                        foreach(Symbol sym2 in rule) {
+                            if(sym2 is SymbolCode || (sym2 is SymbolNonTerm && !lexical.Contains(sym2 as SymbolNonTerm)) ||
+                               (sym2 is SymbolInstr && (sym2 as SymbolInstr).Instruction == Instruction.TO)) {
+                                if(lexical.Remove(sym)) {
+                                    changed = true;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            return lexical;
+        }
+
+        // Builds the DFA for a lexical NTS. Throws an exception if the NTS is not LL(1) or not regular.
+        public Scanner(SymbolNonTerm root, Analysis analysis)
+        {
+            _analysis = analysis;
+            List<SymbolNonTerm> closure = Closure(root);
+            CheckLL1(root, closure);
+            List<CharSet> classes = Classes(closure);
+
+            List<Symbol> start = new List<Symbol>();
+            start.Add(root);
+            List<List<Item>>        stacks = new List<List<Item>>();
+            List<int[]>             delta  = new List<int[]>();
+            Dictionary<string, int> index  = new Dictionary<string, int>();
+            stacks.Add(new List<Item>(new Item[] { NewItem(start, 0, 0) }));
+            index.Add(Key(stacks[0]), 0);
+            for(int s = 0; s < stacks.Count; s++) {
+                int[] targets = new int[classes.Count];
+                for(int k = 0; k < classes.Count; k++) {
+                    List<Item> next = Step(stacks[s], classes[k].RangeLo(0));
+                    targets[k] = -1;
+                    if(next == null) {
+                        continue;
+                    }
+                    if(next.Count > MaxDepth) {
+                        throw new Exception("it is not regular (it calls a NTS recursively, but not as its last symbol)");
+                    }
+                    string key = Key(next);
+                    if(!index.TryGetValue(key, out targets[k])) {
+                        if(stacks.Count >= MaxStates) {
+                            throw new Exception(string.Format("it needs more than {0} states", MaxStates));
+                        }
+                        targets[k] = stacks.Count;
+                        index.Add(key, stacks.Count);
+                        stacks.Add(next);
+                    }
+                }
+                delta.Add(targets);
+            }
+
+            // minimize by splitting the blocks of equivalent states until the partition is stable
+            int[] block = new int[stacks.Count];
+            for(int s = 0; s < stacks.Count; s++) {
+                block[s] = IsAccepting(stacks[s]) ? 1 : 0;
+            }
+            int count = 0;
+            while(true) {
+                Dictionary<string, int> signatures = new Dictionary<string, int>();
+                int[] next = new int[stacks.Count];
+                for(int s = 0; s < stacks.Count; s++) {
+                    StringBuilder sb = new StringBuilder();
+                    sb.Append(block[s]);
+                    foreach(int t in delta[s]) {
+                        sb.Append(',').Append(t < 0 ? -1 : block[t]);
+                    }
+                    if(!signatures.TryGetValue(sb.ToString(), out next[s])) {
+                        next[s] = signatures.Count;
+                        signatures.Add(sb.ToString(), next[s]);
+                    }
+                }
+                block = next;
+                if(signatures.Count == count) {
+                    break;
+                }
+                count = signatures.Count;
+            }
+
+            // number the blocks in the order they are reached from the start state
+            int[] number = new int[count];
+            for(int b = 0; b < count; b++) {
+                number[b] = -1;
+            }
+            List<int> order = new List<int>(); // a representative state of every block
+            number[block[0]] = 0;
+            order.Add(0);
+            for(int i = 0; i < order.Count; i++) {
+                State state = new State();
+                state.Accept = IsAccepting(stacks[order[i]]);
+                for(int k = 0; k < classes.Count; k++) {
+                    int t = delta[order[i]][k];
+                    if(t < 0) {
+                        continue;
+                    }
+                    if(number[block[t]] < 0) {
+                        number[block[t]] = order.Count;
+                        order.Add(t);
+                    }
+                    int j = state.Targets.IndexOf(number[block[t]]);
+                    if(j < 0) {
+                        state.Labels.Add(classes[k]);
+                        state.Targets.Add(number[block[t]]);
+                    } else {
+                        state.Labels[j] = state.Labels[j].Union(classes[k]);
+                    }
+                }
+                States.Add(state);
+            }
+        }
+
+        private static List<SymbolNonTerm> Closure(SymbolNonTerm root)
+        {
+            List<SymbolNonTerm> closure = new List<SymbolNonTerm>();
+            closure.Add(root);
+            for(int i = 0; i < closure.Count; i++) {
+                foreach(List<Symbol> rule in closure[i].Rules) {
+                    foreach(Symbol sym in rule) {
+                        if(sym is SymbolNonTerm && !closure.Contains(sym as SymbolNonTerm)) {
+                            closure.Add(sym as SymbolNonTerm);
+                        }
+                    }
+                }
+            }
+            return closure;
+        }
+
+        // Checks the conditions under which the DFA matches the same input as ordered choice.
+        // The FOLLOW sets are local to the NTS: whatever follows the root is not scanned by the DFA.
+        private void CheckLL1(SymbolNonTerm root, List<SymbolNonTerm> closure)
+        {
+            Dictionary<SymbolNonTerm, CharSet> follow = new Dictionary<SymbolNonTerm, CharSet>();
+            foreach(SymbolNonTerm sym in closure) {
+                follow[sym] = CharSet.Empty;
+            }
+            bool changed = true;
+            while(changed) {
+                changed = false;
+                foreach(SymbolNonTerm sym in closure) {
+                    foreach(List<Symbol> rule in sym.Rules) {
+                        for(int i = 0; i < rule.Count; i++) {
+                            SymbolNonTerm sym2 = rule[i] as SymbolNonTerm;
+                            if(sym2 == null) {
+                                continue;
+                            }
+                            List<Symbol> rest = rule.GetRange(i+1, rule.Count-i-1);
+                            CharSet set = follow[sym2].Union(_analysis.First(rest));
+                            if(_analysis.IsNullable(rest)) {
+                                set = set.Union(follow[sym]);
+                            }
+                            if(!set.Equals(follow[sym2])) {
+                                follow[sym2] = set;
+                                changed = true;
+                            }
+                        }
+                    }
+                }
+            }
+            foreach(SymbolNonTerm sym in closure) {
+                List<CharSet> firsts = First(sym);
+                for(int i = 0; i < sym.Rules.Count; i++) {
+                    CharSet first = firsts[i];
+                    if(_analysis.IsNullable(sym.Rules[i]) && i+1 < sym.Rules.Count) {
+                        throw new Exception(string.Format("alternative {0} of {1} can match the empty input, but is not the last one", i+1, sym.Name));
+                    }
+                    for(int j = i+1; j < sym.Rules.Count; j++) {
+                        CharSet common = first.Intersect(firsts[j]);
+                        if(!common.IsEmpty) {
+                            throw new Exception(string.Format("alternatives {0} and {1} of {2} can both start with {3}", i+1, j+1, sym.Name, common));
+                        }
+                    }
+                    if(_analysis.IsNullable(sym)) {
+                        CharSet common = first.Intersect(follow[sym]);
+                        if(!common.IsEmpty) {
+                            throw new Exception(string.Format("alternative {0} of {1} can start with {2}, which can also follow {1}", i+1, sym.Name, common));
+                        }
+                    }
+                }
+            }
+        }
+
+        // Returns the input symbols every alternative is tried with. An alternative that is a single
+        // <set>, <range>, <notset> or TS of one symbol always succeeds if it can start, so the
+        // following alternatives are never tried with these input symbols.
+        private List<CharSet> First(SymbolNonTerm sym)
+        {
+            List<CharSet> firsts = new List<CharSet>();
+            CharSet       taken  = CharSet.Empty;
+            foreach(List<Symbol> rule in sym.Rules) {
+                CharSet first = _analysis.First(rule);
+                firsts.Add(first.Intersect(taken.Complement()));
+                if((rule.Count == 1 && rule[0] is SymbolTerm && (rule[0] as SymbolTerm).Text.Length == 1) ||
+                   (rule.Count == 2 && rule[0] is SymbolInstr && rule[1] is SymbolTerm)) {
+                    taken = taken.Union(first);
+                }
+            }
+            return firsts;
+        }
+
+        // Splits the input symbols into classes that no TS of the closure can tell apart.
+        private List<CharSet> Classes(List<SymbolNonTerm> closure)
+        {
+            List<CharSet> sets = new List<CharSet>();
+            foreach(SymbolNonTerm sym in closure) {
+                foreach(List<Symbol> rule in sym.Rules) {
+                    for(int i = 0; i < rule.Count; i++) {
+                        if(rule[i] is SymbolTerm) {
+                            string text = (rule[i] as SymbolTerm).Text;
+                            if(i > 0 && rule[i-1] is SymbolInstr) {
+                                sets.Add(_analysis.First(rule, i-1));
+                            } else {
+                                foreach(char c in text) {
+                                    sets.Add(CharSet.Single(c));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            List<int> cuts = new List<int>();
+            cuts.Add(0);
+            cuts.Add(CharSet.MaxChar+1);
+            foreach(CharSet set in sets) {
+                for(int i = 0; i < set.RangeCount; i++) {
+                    cuts.Add(set.RangeLo(i));
+                    cuts.Add(set.RangeHi(i)+1);
+                }
+            }
+            cuts.Sort();
+            List<CharSet>           classes    = new List<CharSet>();
+            Dictionary<string, int> signatures = new Dictionary<string, int>();
+            for(int i = 0; i+1 < cuts.Count; i++) {
+                if(cuts[i] == cuts[i+1]) {
+                    continue;
+                }
+                StringBuilder sb = new StringBuilder();
+                foreach(CharSet set in sets) {
+                    sb.Append(set.Contains(cuts[i]) ? '1' : '0');
+                }
+                int k;
+                if(signatures.TryGetValue(sb.ToString(), out k)) {
+                    classes[k] = classes[k].Union(CharSet.Range(cuts[i], cuts[i+1]-1));
+                } else {
+                    signatures.Add(sb.ToString(), classes.Count);
+                    classes.Add(CharSet.Range(cuts[i], cuts[i+1]-1));
+                }
+            }
+            return classes;
+        }
+
+        // Returns the stack after consuming the input symbol c, or null if c cannot be consumed.
+        // A NTS called as the last symbol of a rule replaces the rule on the stack, so the stack
+        // only grows for NTS that are not regular.
+        private List<Item> Step(List<Item> stack, int c)
+        {
+            List<Item> next = new List<Item>(stack);
+            while(true) {
+                Pop(next);
+                if(next.Count == 0) {
+                    return null;
+                }
+                Item         top  = next[next.Count-1];
+                List<Symbol> rule = top.Rule;
+                if(rule[top.Idx] is SymbolNonTerm) {
+                    SymbolNonTerm sym  = rule[top.Idx] as SymbolNonTerm;
+                    List<Symbol>  alt  = null;
+                    foreach(List<Symbol> rule2 in sym.Rules) { // the first alternative that can start with c, as ordered choice
+                        if(_analysis.First(rule2).Contains(c) || _analysis.IsNullable(rule2)) {
+                            alt = rule2;
+                            break;
+                        }
+                    }
+                    if(alt == null) {
+                        return null;
+                    }
+                    next[next.Count-1] = NewItem(rule, top.Idx+1, 0);
+                    Pop(next);
+                    next.Add(NewItem(alt, 0, 0));
+                    if(next.Count > MaxDepth) {
+                        throw new Exception("it is not regular (it calls a NTS recursively, but not as its last symbol)");
+                    }
+                    continue;
+                }
+                int        idx  = rule[top.Idx] is SymbolInstr ? top.Idx+1 : top.Idx;
+                string     text = (rule[idx] as SymbolTerm).Text;
+                CharSet    set;
+                if(idx > top.Idx) {
+                    set = _analysis.First(rule, top.Idx);
+                } else if(text.Length == 0) {
+                    next[next.Count-1] = NewItem(rule, idx+1, 0);
+                    continue;
+                } else {
+                    set = CharSet.Single(text[top.Off]);
+                }
+                if(!set.Contains(c)) {
+                    return null;
+                }
+                if(idx == top.Idx && top.Off+1 < text.Length) {
+                    next[next.Count-1] = NewItem(rule, idx, top.Off+1);
+                } else {
+                    next[next.Count-1] = NewItem(rule, idx+1, 0);
+                }
+                Pop(next);
+                return next;
+            }
+        }
+
+        private static void Pop(List<Item> stack)
+        {
+            while(stack.Count > 0 && stack[stack.Count-1].Idx >= stack[stack.Count-1].Rule.Count) {
+                stack.RemoveAt(stack.Count-1);
+            }
+        }
+
+        private bool IsAccepting(List<Item> stack)
+        {
+            foreach(Item item in stack) {
+                if(item.Off > 0 || !_analysis.IsNullable(item.Rule.GetRange(item.Idx, item.Rule.Count-item.Idx))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        private Item NewItem(List<Symbol> rule, int idx, int off)
+        {
+            if(!_ids.ContainsKey(rule)) {
+                _ids.Add(rule, _ids.Count);
+            }
+            Item item = new Item();
+            item.Rule = rule;
+            item.Idx  = idx;
+            item.Off  = off;
+            return item;
+        }
+
+        private string Key(List<Item> stack)
+        {
+            StringBuilder sb = new StringBuilder();
+            foreach(Item item in stack) {
+                sb.AppendFormat("{0}.{1}.{2};", _ids[item.Rule], item.Idx, item.Off);
+            }
+            return sb.ToString();
+        }
+    }
+}
\ No newline at end of file
@@ -16,6 +16,10 @@ namespace RSPT
 
         public readonly List<List<Symbol>> Rules = new List<List<Symbol>>();
         public string                      Type; // C++ or C# type for output 
+        public bool                        Inline; // the NTS has a single call site and is generated inline (<option:inline>)
+        public bool                        Memo;   // the result of the last call is remembered (<memo>)
+        public string                      Sync;   // the NTS may start behind this text and is parsed there in parallel (<sync:'xxx'>)
+        public SymbolNonTerm               Operand; // the operand of an operator table (<operators:xxx>), null for normal NTS
 
         public SymbolNonTerm(string token) : base(token) { }
 
@@ -52,6 +56,8 @@ namespace RSPT
                 if(Token.Substring(1, Token.Length-2) == "set")    return Instruction.SET;
                 if(Token.Substring(1, Token.Length-2) == "range")  return Instruction.RANGE;
                 if(Token.Substring(1, Token.Length-2) == "notset") return Instruction.NOTSET;
+                if(Token.StartsWith("<left:"))                     return Instruction.LEFT;
+                if(Token.StartsWith("<right:"))                    return Instruction.RIGHT;
                 throw new Exception(string.Format("Invalid instruction {0}.", Token));
             }
         }
@@ -59,6 +65,10 @@ namespace RSPT
         public string ToResult {
             get { return Token.Substring(4, Token.Length-5); }
         }
+
+        public int Precedence {
+            get { return int.Parse(Token.Substring(Token.IndexOf(':')+1, Token.Length-Token.IndexOf(':')-2)); }
+        }
     }
 
     public enum Instruction {
@@ -66,5 +76,7 @@ namespace RSPT
         SET,    // <set> interprets the following TS as a set of characters
         RANGE,  // <range> interprets the following TS as a range of characters
         NOTSET, // <notset> interprets the following TS as a set of excluded characters
+        LEFT,   // <left:n> starts a left associative operator with precedence n (in a NTS with <operators:xxx>)
+        RIGHT,  // <right:n> starts a right associative operator with precedence n (in a NTS with <operators:xxx>)
     }
 }
\ No newline at end of file